@@ -0,0 +1,159 @@
+/*
+ * File:   board.h
+ *
+ * PICKit 44-Pin Demo Board pins, driven through shadow latches
+ * A pin is a compile-time pair of port letter and bit (LED0 is D, 0), and
+ * the PIN_ macros paste it into plain register code, so nothing is left
+ * for run time: no tables, no pointers, no function calls.
+ *
+ * The PIC16F887 has no LATx registers. BSF/BCF/XORWF on PORTx read the
+ * pins, not the latch, and write all eight back: a pin that reads wrong
+ * for a moment (an LED or capacitive load still rising, a pin in analog
+ * mode reading 0) gets its latch overwritten. That is the read-modify-
+ * write hazard behind
+ *     PORTDbits.RD0 = ~PORTDbits.RD0;
+ * Here every output change goes to boardLatchX, a RAM copy of the latch,
+ * and the whole byte is then stored to PORTx. The RAM operation is a
+ * single BSF/BCF/XORWF (atomic, so isr() may use the same latch), the
+ * store two more instructions:
+ *     PIN_SET(LED1)       BSF boardLatchD,1  MOVF boardLatchD,W  MOVWF PORTD
+ *     PIN_TOGGLE(LED0)    MOVLW 1  XORWF boardLatchD,F  MOVF..  MOVWF PORTD
+ *     PORT_WRITE(D, x)    MOVWF boardLatchD  MOVWF PORTD
+ * That costs cycles: a set or clear takes 3 where BSF/BCF on PORTx takes
+ * 1, a toggle 4 where MOVLW/XORWF on PORTx takes 2, bank selects aside.
+ * The shadow latch trades those cycles for freedom from the read-modify-
+ * write hazard; where no pin of the port can read back wrong and every
+ * cycle counts, a plain PORTxbits store is still the cheaper one. The
+ * macros cost no more than the same shadow code written out by hand (see
+ * main_board_pins.c). An isr() that changes pins of the same port between
+ * the MOVF and the MOVWF of main() has its change undone on the pins (not
+ * in the latch) until the next write; keep the pins of isr() and main()
+ * on different ports, or write with GIE off.
+ *
+ * Inputs are read from the pins as usual, PIN_READ(SW1).
+ *
+ * Exactly one file of the program defines BOARD_IMPL before including
+ * board.h; the latches are stored there and shared by every other file.
+ *
+ * board_init() sets up the ports from compile-time masks the sketch may
+ * define before including this file (the rest default to 0):
+ *   BOARD_INPUTS_A .. BOARD_INPUTS_E   TRIS bits, 1 = input
+ *   BOARD_LATCH_A .. BOARD_LATCH_E     output levels to start with
+ *   BOARD_ANALOG                       ANSELH:ANSEL, bit n = ANn analog
+ * It writes every latch before any TRIS, so no output ever shows a stale
+ * level, and each register once: 12 stores.
+ */
+
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <stdint.h>
+
+// Pins of the demo board: port letter, bit
+#define LED0                D, 0
+#define LED1                D, 1
+#define LED2                D, 2
+#define LED3                D, 3
+#define LED4                D, 4
+#define LED5                D, 5
+#define LED6                D, 6
+#define LED7                D, 7
+#define SW1                 B, 0        // low while pressed, external pull-up
+#define POT                 A, 0        // AN0
+#define POT_AN              0
+
+// The macros take a pin (LED0) and hand its two halves on to the _ version
+#define PIN_MASK(pin)               PIN_MASK_(pin)
+#define PIN_MASK_(port, bit)        (1 << (bit))
+
+#ifndef BOARD_INPUTS_A
+#define BOARD_INPUTS_A      0x00
+#endif
+#ifndef BOARD_INPUTS_B
+#define BOARD_INPUTS_B      0x00
+#endif
+#ifndef BOARD_INPUTS_C
+#define BOARD_INPUTS_C      0x00
+#endif
+#ifndef BOARD_INPUTS_D
+#define BOARD_INPUTS_D      0x00
+#endif
+#ifndef BOARD_INPUTS_E
+#define BOARD_INPUTS_E      0x00
+#endif
+#ifndef BOARD_LATCH_A
+#define BOARD_LATCH_A       0x00
+#endif
+#ifndef BOARD_LATCH_B
+#define BOARD_LATCH_B       0x00
+#endif
+#ifndef BOARD_LATCH_C
+#define BOARD_LATCH_C       0x00
+#endif
+#ifndef BOARD_LATCH_D
+#define BOARD_LATCH_D       0x00
+#endif
+#ifndef BOARD_LATCH_E
+#define BOARD_LATCH_E       0x00
+#endif
+#ifndef BOARD_ANALOG
+#define BOARD_ANALOG        0x0000
+#endif
+
+// An analog pin must be an input: AN0-AN3 RA0-RA3, AN4 RA5, AN5-AN7 RE0-RE2,
+// AN8 RB2, AN9 RB3, AN10 RB1, AN11 RB4, AN12 RB0, AN13 RB5
+#define BOARD_ANALOG_A      ((BOARD_ANALOG & 0x0F) | (BOARD_ANALOG & 0x10) << 1)
+#define BOARD_ANALOG_E      ((BOARD_ANALOG >> 5) & 0x07)
+#define BOARD_ANALOG_B      ((BOARD_ANALOG >> 6 & 0x04) | (BOARD_ANALOG >> 6 & 0x08) | (BOARD_ANALOG >> 9 & 0x02) \
+                             | (BOARD_ANALOG >> 7 & 0x10) | (BOARD_ANALOG >> 12 & 0x01) | (BOARD_ANALOG >> 8 & 0x20))
+#if BOARD_ANALOG > 0x3FFF
+#error "BOARD_ANALOG: the PIC16F887 has AN0 to AN13"
+#endif
+#if (BOARD_ANALOG_A & ~BOARD_INPUTS_A) || (BOARD_ANALOG_B & ~BOARD_INPUTS_B) || (BOARD_ANALOG_E & ~BOARD_INPUTS_E)
+#error "an analog pin in BOARD_ANALOG is not an input in BOARD_INPUTS_x"
+#endif
+#if BOARD_INPUTS_E & 0xF0 || BOARD_LATCH_E & 0xF0
+#error "PORTE has four pins"
+#endif
+
+// The port latches as the code last set them: one per port for the whole
+// program, stored in the file that defines BOARD_IMPL before including
+// board.h, so writes from any file keep each other's pins
+extern uint8_t boardLatchA, boardLatchB, boardLatchC, boardLatchD, boardLatchE;
+#ifdef BOARD_IMPL
+uint8_t boardLatchA, boardLatchB, boardLatchC, boardLatchD, boardLatchE;
+#endif
+
+#define PIN_SET(pin)                PIN_SET_(pin)
+#define PIN_SET_(port, bit)         do { boardLatch##port |= 1u << (bit); PORT##port = boardLatch##port; } while(0)
+#define PIN_CLEAR(pin)              PIN_CLEAR_(pin)
+#define PIN_CLEAR_(port, bit)       do { boardLatch##port &= ~(1u << (bit)); PORT##port = boardLatch##port; } while(0)
+#define PIN_TOGGLE(pin)             PIN_TOGGLE_(pin)
+#define PIN_TOGGLE_(port, bit)      do { boardLatch##port ^= 1u << (bit); PORT##port = boardLatch##port; } while(0)
+#define PIN_WRITE(pin, on)          do { if(on) PIN_SET(pin); else PIN_CLEAR(pin); } while(0)
+#define PIN_IS_SET(pin)             PIN_IS_SET_(pin)                // the latch, not the pin
+#define PIN_IS_SET_(port, bit)      ((boardLatch##port >> (bit)) & 1)
+#define PIN_READ(pin)               PIN_READ_(pin)                  // the pin
+#define PIN_READ_(port, bit)        ((PORT##port >> (bit)) & 1)
+#define PORT_WRITE(port, value)     do { boardLatch##port = (value); PORT##port = boardLatch##port; } while(0)
+#define PORT_LATCH(port)            boardLatch##port
+
+static inline void board_init()
+{
+    ANSEL = (uint8_t)BOARD_ANALOG;
+    ANSELH = (uint8_t)(BOARD_ANALOG >> 8);
+
+    PORT_WRITE(A, BOARD_LATCH_A);           // levels first, then the drivers
+    PORT_WRITE(B, BOARD_LATCH_B);
+    PORT_WRITE(C, BOARD_LATCH_C);
+    PORT_WRITE(D, BOARD_LATCH_D);
+    PORT_WRITE(E, BOARD_LATCH_E);
+
+    TRISA = BOARD_INPUTS_A;
+    TRISB = BOARD_INPUTS_B;
+    TRISC = BOARD_INPUTS_C;
+    TRISD = BOARD_INPUTS_D;
+    TRISE = BOARD_INPUTS_E;
+}
+
+#endif /* BOARD_H */
@@ -0,0 +1,49 @@
+/*
+ * File:   debounce.h
+ *
+ * Vertical-counter debouncer: eight inputs for the price of one
+ * Each pin has a 2-bit counter stored "vertically": bit n of
+ * debounceCount0 and debounceCount1 together are pin n's counter, so one
+ * byte-wide AND/XOR steps all eight counters at once. Call
+ * debounce_update() once per tick with the raw inputs (1 = active, e.g.
+ * ~PORTB for buttons to ground). A pin that agrees with its debounced
+ * state has its counter reset; a pin that differs counts down and flips
+ * on the DEBOUNCE_TICKS'th sample in a row, so any glitch or bounce
+ * shorter than that never gets through. Pick the tick so that
+ * DEBOUNCE_TICKS ticks cover the bounce time of the switches
+ * (main_debounce.c uses 4 ms: changes are accepted 12-16 ms after the
+ * contact settles).
+ *
+ * debounced holds the state; the return value has a 1 for every pin that
+ * changed on this tick. The state is stored in the one file that defines
+ * DEBOUNCE_IMPL before including this header.
+ */
+
+#ifndef DEBOUNCE_H
+#define DEBOUNCE_H
+
+#include <stdint.h>
+
+#define DEBOUNCE_TICKS      4       // fixed by the 2-bit counters
+
+extern uint8_t debounced;                               // 1 = active
+extern uint8_t debounceCount0, debounceCount1;
+#ifdef DEBOUNCE_IMPL
+uint8_t debounced = 0;
+uint8_t debounceCount0 = 0xFF, debounceCount1 = 0xFF;   // all counters at 3
+#endif
+
+static inline uint8_t debounce_update(uint8_t sample)
+{
+    uint8_t changed = debounced ^ sample;
+
+    // Differing pins count 3-2-1-0 and flip as they wrap back to 3,
+    // agreeing pins go straight to 3
+    debounceCount0 = ~(debounceCount0 & changed);
+    debounceCount1 = debounceCount0 ^ (debounceCount1 & changed);
+    changed &= debounceCount0 & debounceCount1;
+    debounced ^= changed;
+    return changed;
+}
+
+#endif /* DEBOUNCE_H */
@@ -7,6 +7,9 @@
  * Blinking LED
  * Digital I/O
  * 
+ * SW1 selects the next mode (blink, rotate, bounce, binary, Knight Rider).
+ * The mode is kept in data EEPROM, so it survives a reset or power cycle.
+ * 
  *  Board connection (PICKit 44-Pin Demo Board; PIC16F887):
  *   PIN                	Module                         				  
  * -------------------------------------------                        
@@ -18,6 +21,8 @@
  *  RD5          			LED
  *  RD6          			LED
  *  RD7          			LED
+ * 
+ *  RB0 (SW1)               BUTTON    
  *
  */
 
@@ -49,6 +54,7 @@ begins with a single underscore.
 #pragma config WRT = OFF        // Flash Program Memory Self Write Enable bits (Write protection off)
 
 #include <xc.h>
+#include <stdint.h>
 
 void system_init()
 {
@@ -106,7 +112,7 @@ void system_init()
      * ---------------------------------------------------------------------
      */
         TRISA = 0x00;         // Set All on PORTA as Output    
-        TRISB = 0x00;         // Set All on PORTB as Output    
+        TRISB = 0x01;         // Set All on PORTB as Output, and B0 (SW1) as Input
         TRISC = 0x00;         // Set All on PORTC as Output    
         TRISD = 0x00;         // Set All on PORTD as Output   
         TRISE = 0x00;         // Set All on PORTE as Output    
@@ -123,48 +129,180 @@ void system_init()
         PORTE = 0x00;         // Set PORTE all 0
 }
 
-static int mode = 1; // 0 - blink; 1 - rotate (need to be recompiled to change modes)
+// LED patterns
+// A pattern is a list of steps. Each step is the whole PORTD value and how long
+// it stays on, in PATTERN_TICK_MS units. PORTD is written with one store per
+// step, so all eight LEDs change at the same instant.
+// 'const' puts the tables in program memory (RETLW tables), not in RAM.
+#define PATTERN_TICK_MS           10
+
+typedef struct
+{
+    uint8_t leds;                 // PORTD value, bit n = LED n
+    uint8_t ticks;                // duration, PATTERN_TICK_MS units (1 to 255)
+} step_t;
+
+typedef struct
+{
+    const step_t *steps;
+    uint16_t count;
+} pattern_t;
+
+#define STEPS(table)              { table, sizeof(table) / sizeof(table[0]) }
+
+// one LED walking from LED 0 to LED 7, 0.5 second each
+static const step_t rotateSteps[] = {
+    { 0x01, 50 }, { 0x02, 50 }, { 0x04, 50 }, { 0x08, 50 },
+    { 0x10, 50 }, { 0x20, 50 }, { 0x40, 50 }, { 0x80, 50 },
+};
+
+// one LED walking to LED 7 and back
+static const step_t bounceSteps[] = {
+    { 0x01, 20 }, { 0x02, 20 }, { 0x04, 20 }, { 0x08, 20 },
+    { 0x10, 20 }, { 0x20, 20 }, { 0x40, 20 }, { 0x80, 20 },
+    { 0x40, 20 }, { 0x20, 20 }, { 0x10, 20 }, { 0x08, 20 },
+    { 0x04, 20 }, { 0x02, 20 },
+};
+
+// 0 to 255 in binary, 0.1 second per count
+#define COUNT1(n)                 { (n), 10 }
+#define COUNT4(n)                 COUNT1(n), COUNT1(n + 1), COUNT1(n + 2), COUNT1(n + 3)
+#define COUNT16(n)                COUNT4(n), COUNT4(n + 4), COUNT4(n + 8), COUNT4(n + 12)
+#define COUNT64(n)                COUNT16(n), COUNT16(n + 16), COUNT16(n + 32), COUNT16(n + 48)
+static const step_t binarySteps[] = {
+    COUNT64(0), COUNT64(64), COUNT64(128), COUNT64(192),
+};
+
+// two LEDs sweeping back and forth, slowing down at both ends
+static const step_t knightRiderSteps[] = {
+    { 0x01, 12 }, { 0x03, 6 }, { 0x06, 4 }, { 0x0C, 4 }, { 0x18, 4 },
+    { 0x30, 4 }, { 0x60, 4 }, { 0xC0, 6 }, { 0x80, 12 },
+    { 0xC0, 6 }, { 0x60, 4 }, { 0x30, 4 }, { 0x18, 4 },
+    { 0x0C, 4 }, { 0x06, 4 }, { 0x03, 6 },
+};
+
+// LED 0-3 on and off, 2 seconds each
+static const step_t blinkSteps[] = {
+    { 0x0F, 200 }, { 0x00, 200 },
+};
+
+const pattern_t blink = STEPS(blinkSteps);
+const pattern_t rotate = STEPS(rotateSteps);
+const pattern_t bounce = STEPS(bounceSteps);
+const pattern_t binary = STEPS(binarySteps);
+const pattern_t knightRider = STEPS(knightRiderSteps);
+
+// Pattern player
+// Nothing in here waits: pattern_tick() is called once every PATTERN_TICK_MS
+// and only changes PORTD when the current step is over.
+static const pattern_t *playing;
+static uint16_t playStep;
+static uint8_t playTicks;
+
+void pattern_start(const pattern_t *pattern)
+{
+    playing = pattern;
+    playStep = 0;
+    playTicks = pattern->steps[0].ticks;
+    PORTD = pattern->steps[0].leds;                 // all LEDs in one write
+}
+
+void pattern_tick()
+{
+    if(--playTicks)
+        return;
+    if(++playStep == playing->count)
+        playStep = 0;
+    playTicks = playing->steps[playStep].ticks;
+    PORTD = playing->steps[playStep].leds;          // all LEDs in one write
+}
+
+// Modes, in the order SW1 steps through them
+static const pattern_t *const modes[] = { &blink, &rotate, &bounce, &binary, &knightRider };
+#define MODE_COUNT                (sizeof(modes) / sizeof(modes[0]))
+#define MODE_DEFAULT              1               // rotate
+#define EE_MODE_ADDR              0x00            // EEPROM address of the mode
+
+// Data EEPROM
+// 256 bytes that keep their contents without power.
+/* 
+ * -------------------EECON1-----------------------------
+ * Bit#:  ---7----6---5---4----3-----2----1----0---------
+ *        -|EEPGD|---|---|---|WRERR|WREN|WR |RD |---------
+ * ------------------------------------------------------
+ * EEPGD - 0 selects data EEPROM, 1 program memory
+ * WRERR - a write was interrupted by a reset
+ * WREN  - 1 allows write cycles
+ * WR    - 1 starts a write; cleared by hardware when it is done (~5ms, EEIF is set)
+ * RD    - 1 starts a read; EEDAT holds the data on the next instruction
+ *
+ * A write only starts if 0x55 and then 0xAA are written to EECON2 right
+ * before WR is set, so a runaway program cannot change the EEPROM by accident.
+ * Interrupts must be off during that sequence.
+ */
+uint8_t EEPROM_Read(uint8_t address)
+{
+    EEADR = address;
+    EECON1bits.EEPGD = 0;       // data memory
+    EECON1bits.RD = 1;          // start the read
+    return EEDAT;
+}
+
+void EEPROM_Write(uint8_t address, uint8_t value)
+{
+    uint8_t gie;
+
+    while(EECON1bits.WR);       // previous write still in progress
+
+    EEADR = address;
+    EEDAT = value;
+    EECON1bits.EEPGD = 0;       // data memory
+    EECON1bits.WREN = 1;        // allow the write
+
+    gie = INTCONbits.GIE;
+    INTCONbits.GIE = 0;         // nothing may come between the steps below
+    EECON2 = 0x55;
+    EECON2 = 0xAA;
+    EECON1bits.WR = 1;          // start the write, it finishes on its own
+    INTCONbits.GIE = gie;
+
+    EECON1bits.WREN = 0;        // no further writes
+}
+
+// SW1 pulls RB0 low. Sampled every PATTERN_TICK_MS, which is longer than the
+// switch bounces, so two low samples in a row after a high one are a press.
+static uint8_t buttonHistory = 0xFF;
+
+uint8_t button_pressed()
+{
+    buttonHistory = (buttonHistory << 1) | PORTBbits.RB0;
+    return (buttonHistory & 0x07) == 0x04;          // high, low, low
+}
 
 void main(void) 
 {
+    uint8_t mode;
+
     system_init();
     
+    mode = EEPROM_Read(EE_MODE_ADDR);
+    if(mode >= MODE_COUNT)
+        mode = MODE_DEFAULT;                        // EEPROM still erased (0xFF)
+    pattern_start(modes[mode]);
+
     while(1)
     {
-        if(0 == mode)
+        __delay_ms(PATTERN_TICK_MS);
+
+        if(button_pressed())
         {
-            // turn on and off
-            while(1)  
-            {
-                PORTDbits.RD0 = ~PORTDbits.RD0;   // Toggle the LED 
-                PORTDbits.RD1 = ~PORTDbits.RD1;   // Toggle the LED
-                PORTDbits.RD2 = ~PORTDbits.RD2;   // Toggle the LED
-                PORTDbits.RD3 = ~PORTDbits.RD3;   // Toggle the LED
-                __delay_ms(2000);                 // sleep 2 seconds
-            }
+            if(++mode == MODE_COUNT)
+                mode = 0;
+            EEPROM_Write(EE_MODE_ADDR, mode);
+            pattern_start(modes[mode]);
         }
         else
-        {
-            // rotate
-            int index = 1;
-            while(1)
-            {
-                PORTDbits.RD0 = index & 1;
-                PORTDbits.RD1 = (index & 2) >> 1;
-                PORTDbits.RD2 = (index & 4) >> 2;
-                PORTDbits.RD3 = (index & 8) >> 3;
-                PORTDbits.RD4 = (index & 16) >> 4;
-                PORTDbits.RD5 = (index & 32) >> 5;
-                PORTDbits.RD6 = (index & 64) >> 6;
-                PORTDbits.RD7 = (index & 128) >> 7;
-
-                index <<= 1;
-                if(index >= 256)
-                    index = 1;
-
-                __delay_ms(500);                   // sleep 0.5 second
-            }
-        }
+            pattern_tick();
     }
     
 	return;
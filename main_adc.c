@@ -106,9 +106,9 @@ void system_init()
             11 = FRC (clock derived from a dedicated internal oscillator = 500 kHz max)     
       
         CHS<3:0> - channel select: This selects which voltage is fed into the ADC. 
-            Setting this 0 to 11 selects AN0 to AN11 respectively. 
-            Setting 12 feeds CVref (Comparator voltage reference). 
-            Setting 13 connects the 0.6V fixed voltage reference from the
+            Setting this 0 to 13 selects AN0 to AN13 respectively. 
+            Setting 14 feeds CVref (Comparator voltage reference). 
+            Setting 15 connects the 0.6V fixed voltage reference from the
             Comparator module to the ADC.
 
         GO/DONE: 1 to start ADC conversion. 
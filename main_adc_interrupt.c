@@ -0,0 +1,195 @@
+/*
+ * File:   main_adc_interrupt.c
+ *
+ * Analog to Digital Converter (ADC) with interrupt
+ * The ADC interrupt (ADIF) stores every result into a ring buffer and starts
+ * the next conversion right away, so conversions run back-to-back while
+ * main() only takes samples out of the buffer.
+ * LED 0-3 show the input level as a bar (like main_adc.c)
+ * LED 7 toggles every 1024 samples
+ *
+ *  Board connection (PICKit 44-Pin Demo Board; PIC16F887):
+ *   PIN                	Module
+ * -------------------------------------------
+ *  RD0          			LED
+ *  RD1          			LED
+ *  RD2          			LED
+ *  RD3          			LED
+ *  RD7          			LED
+ *  RA0 (RP1)               POTENCIOMETER
+ *
+ */
+
+/* The __delay_ms() function is provided by XC8.
+It requires you define _XTAL_FREQ as the frequency of your system clock.
+The compiler then uses that value to calculate how many cycles are required to give the requested delay.
+There is also __delay_us() for microseconds and _delay() to delay for a specific number of clock cycles.
+Note that __delay_ms() and __delay_us() begin with a double underscore whereas _delay()
+begins with a single underscore.
+*/
+#define _XTAL_FREQ 8000000
+
+// PIC16F887 Configuration Bit Settings
+// 'C' source line config statements
+// CONFIG1
+#pragma config FOSC = INTRC_NOCLKOUT// Oscillator Selection bits (INTOSCIO oscillator: I/O function on RA6/OSC2/CLKOUT pin, I/O function on RA7/OSC1/CLKIN)
+#pragma config WDTE = OFF       // Watchdog Timer Enable bit (WDT disabled and can be enabled by SWDTEN bit of the WDTCON register)
+#pragma config PWRTE = OFF      // Power-up Timer Enable bit (PWRT disabled)
+#pragma config MCLRE = ON       // RE3/MCLR pin function select bit (RE3/MCLR pin function is MCLR)
+#pragma config CP = OFF         // Code Protection bit (Program memory code protection is disabled)
+#pragma config CPD = OFF        // Data Code Protection bit (Data memory code protection is disabled)
+#pragma config BOREN = ON       // Brown Out Reset Selection bits (BOR enabled)
+#pragma config IESO = ON        // Internal External Switchover bit (Internal/External Switchover mode is enabled)
+#pragma config FCMEN = ON       // Fail-Safe Clock Monitor Enabled bit (Fail-Safe Clock Monitor is enabled)
+#pragma config LVP = OFF        // Low Voltage Programming Enable bit (RB3 pin has digital I/O, HV on MCLR must be used for programming)
+
+// CONFIG2
+#pragma config BOR4V = BOR40V   // Brown-out Reset Selection bit (Brown-out Reset set to 4.0V)
+#pragma config WRT = OFF        // Flash Program Memory Self Write Enable bits (Write protection off)
+
+#include <xc.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PIN_A0                    0
+#define ACQ_US_DELAY              5
+
+// The holding capacitor needs ACQ_US_DELAY to charge after a conversion before
+// the next one may start. The interrupt entry and context save alone take about
+// ISR_ENTRY_CYCLES, so only the remainder (if any) has to be spent in isr().
+#define ACQ_CYCLES                (ACQ_US_DELAY * (_XTAL_FREQ / 4000000))
+#define ISR_ENTRY_CYCLES          9
+#if ACQ_CYCLES > ISR_ENTRY_CYCLES
+#define ACQ_PAD_CYCLES            (ACQ_CYCLES - ISR_ENTRY_CYCLES)
+#else
+#define ACQ_PAD_CYCLES            0
+#endif
+
+// Single-producer (isr) / single-consumer (main) ring buffer.
+// Each side only ever writes its own index, and an 8-bit index is read and
+// written in one instruction, so no interrupt masking is needed.
+// The size must be a power of two.
+#define ADC_BUFFER_SIZE           32
+
+volatile uint16_t adcBuffer[ADC_BUFFER_SIZE];
+volatile uint8_t adcHead = 0;               // next slot isr() writes
+volatile uint8_t adcTail = 0;               // next slot main() reads
+volatile uint8_t adcOverruns = 0;           // samples dropped because the buffer was full
+
+void system_init()
+{
+    OSCCON=0x70;          // Select 8 Mhz internal clock
+
+	// I/O
+		// ANSELx registers
+			ANSEL = 0x00;         // Set PORT ANS0 to ANS7 as Digital I/O
+			ANSELH = 0x00;        // Set PORT ANS8 to ANS11 as Digital I/O
+			ANSELbits.ANS0 = 1;   // Set RA0/AN0 to analog mode
+
+		// TRISx registers (This register specifies the data direction of each pin)
+			TRISA = 0x00;         // Set All on PORTA as Output
+			TRISB = 0x00;         // Set All on PORTB as Output
+			TRISC = 0x00;         // Set All on PORTC as Output
+            TRISD = 0x00;         // Set All on PORTD as Output
+            TRISE = 0x00;         // Set All on PORTE as Output
+			TRISAbits.TRISA0 = 1; // Set RA0/AN0 as Input
+
+		// PORT registers
+			PORTA = 0x00;         // Set PORTA all 0
+			PORTB = 0x00;         // Set PORTB all 0
+			PORTC = 0x00;         // Set PORTC all 0
+            PORTD = 0x00;         // Set PORTD all 0
+            PORTE = 0x00;         // Set PORTE all 0
+
+    // ADC setup (see main_adc.c for the register description)
+        ADCON1bits.ADFM = 1;   		// ADC result is right justified
+        ADCON1bits.VCFG0 = 0;    	// Vref uses Vdd as reference
+        ADCON1bits.VCFG1 = 0;       // Vss as negative reference
+        ADCON0bits.ADCS = 0b10;     // Fosc/32 is the conversion clock
+									//   Tad must be greater than 1.6us.
+									//   With a Fosc of 8MHz, Fosc/32 results in a Tad
+									//   of 4us, so one conversion (11 Tad) takes 44us.
+        ADCON0bits.CHS = PIN_A0;	// Select analog input - AN0
+        ADCON0bits.ADON = 1;    	// Turn on the ADC
+
+	// Interrupt setup
+        PIR1bits.ADIF = 0;          // Clear the ADC interrupt flag
+        PIE1bits.ADIE = 1;          // Enable the ADC interrupt
+        INTCONbits.PEIE = 1;        // ADC is a peripheral interrupt
+		INTCONbits.GIE = 1;         // Set the Global Interrupt Enable
+}
+
+/*
+ * The PIC16F887 can only have one Interrupt Service Routine.
+ * Compiler should know which function is the interrupt handler.
+ * This is done by declaring the function with 'interrupt' prefix:
+ */
+void interrupt isr()
+{
+    if(PIR1bits.ADIF == 1)
+    {
+        uint8_t next = (adcHead + 1) & (ADC_BUFFER_SIZE - 1);
+
+        PIR1bits.ADIF = 0;                  // Clear the ADC interrupt flag
+
+        if(next != adcTail)
+        {
+            adcBuffer[adcHead] = (uint16_t)((ADRESH << 8) + ADRESL);
+            adcHead = next;                 // publish the sample
+        }
+        else
+            adcOverruns++;                  // main() is behind, drop the sample
+
+#if ACQ_PAD_CYCLES
+        _delay(ACQ_PAD_CYCLES);             // finish the acquisition time
+#endif
+        ADCON0bits.GO_nDONE = 1;            // Start the next conversion
+    }
+}
+
+bool ADC_GetSample(uint16_t *sample)
+{
+    if(adcTail == adcHead)
+        return false;                       // buffer empty
+    *sample = adcBuffer[adcTail];
+    adcTail = (adcTail + 1) & (ADC_BUFFER_SIZE - 1);
+    return true;
+}
+
+void main(void)
+{
+    uint16_t count = 0;
+    uint8_t leds = 0;
+
+    system_init();
+
+    __delay_us(ACQ_US_DELAY);               // Acquisition time delay
+    ADCON0bits.GO_nDONE = 1;                // Start the first conversion, isr() starts the rest
+
+    while(1)
+	{
+        uint16_t adcResult;
+
+        if(!ADC_GetSample(&adcResult))
+        {
+            NOP();                          // nothing to do until isr() delivers a sample
+            continue;
+        }
+
+        leds &= 0x80;
+        if(adcResult > 256)
+            leds |= 0x01;
+        if(adcResult > 512)
+            leds |= 0x02;
+        if(adcResult > 768)
+            leds |= 0x04;
+        if(adcResult > 1000)
+            leds |= 0x08;
+        if((++count & 0x3FF) == 0)
+            leds ^= 0x80;                   // 1024 samples
+
+        PORTD = leds;                       // all LEDs in one write
+    }
+
+  return;
+}
@@ -0,0 +1,203 @@
+/*
+ * File:   main_adc_oversample.c
+ *
+ * Analog to Digital Converter (ADC) with oversampling and decimation
+ * The ADC interrupt converts AN0 back-to-back and adds up 4^OVERSAMPLE_BITS
+ * samples; the sum shifted right by OVERSAMPLE_BITS is a result with
+ * OVERSAMPLE_BITS more bits than the 10-bit converter (12 bits by default).
+ * This only works when the input carries at least about 1 LSB of noise,
+ * which a real potentiometer and supply do.
+ * main() runs every decimated result through a first order IIR low-pass
+ * filter and shows the upper 8 bits of it on the LEDs.
+ * Integer arithmetic only, no multiplication or division.
+ *
+ *  Board connection (PICKit 44-Pin Demo Board; PIC16F887):
+ *   PIN                	Module
+ * -------------------------------------------
+ *  RD0-RD7          		LED
+ *  RA0 (RP1)               POTENCIOMETER
+ *
+ */
+
+/* The __delay_ms() function is provided by XC8.
+It requires you define _XTAL_FREQ as the frequency of your system clock.
+The compiler then uses that value to calculate how many cycles are required to give the requested delay.
+There is also __delay_us() for microseconds and _delay() to delay for a specific number of clock cycles.
+Note that __delay_ms() and __delay_us() begin with a double underscore whereas _delay()
+begins with a single underscore.
+*/
+#define _XTAL_FREQ 8000000
+
+// PIC16F887 Configuration Bit Settings
+// 'C' source line config statements
+// CONFIG1
+#pragma config FOSC = INTRC_NOCLKOUT// Oscillator Selection bits (INTOSCIO oscillator: I/O function on RA6/OSC2/CLKOUT pin, I/O function on RA7/OSC1/CLKIN)
+#pragma config WDTE = OFF       // Watchdog Timer Enable bit (WDT disabled and can be enabled by SWDTEN bit of the WDTCON register)
+#pragma config PWRTE = OFF      // Power-up Timer Enable bit (PWRT disabled)
+#pragma config MCLRE = ON       // RE3/MCLR pin function select bit (RE3/MCLR pin function is MCLR)
+#pragma config CP = OFF         // Code Protection bit (Program memory code protection is disabled)
+#pragma config CPD = OFF        // Data Code Protection bit (Data memory code protection is disabled)
+#pragma config BOREN = ON       // Brown Out Reset Selection bits (BOR enabled)
+#pragma config IESO = ON        // Internal External Switchover bit (Internal/External Switchover mode is enabled)
+#pragma config FCMEN = ON       // Fail-Safe Clock Monitor Enabled bit (Fail-Safe Clock Monitor is enabled)
+#pragma config LVP = OFF        // Low Voltage Programming Enable bit (RB3 pin has digital I/O, HV on MCLR must be used for programming)
+
+// CONFIG2
+#pragma config BOR4V = BOR40V   // Brown-out Reset Selection bit (Brown-out Reset set to 4.0V)
+#pragma config WRT = OFF        // Flash Program Memory Self Write Enable bits (Write protection off)
+
+#include <xc.h>
+#include <stdint.h>
+
+#define PIN_A0                    0
+#define ACQ_US_DELAY              5
+
+// Extra bits of resolution: 4^OVERSAMPLE_BITS samples per result.
+// 1 -> 11 bits from 4 samples, 2 -> 12 bits from 16, 3 -> 13 bits from 64.
+// The sum of 64 10-bit samples still fits in 16 bits, 256 would not.
+#define OVERSAMPLE_BITS           2
+#if OVERSAMPLE_BITS < 1 || OVERSAMPLE_BITS > 3
+#error "OVERSAMPLE_BITS must be 1 to 3"
+#endif
+#define OVERSAMPLE_COUNT          (1 << (2 * OVERSAMPLE_BITS))
+#define RESULT_BITS               (10 + OVERSAMPLE_BITS)
+
+// IIR low-pass: y += (x - y) / 2^IIR_SHIFT, 0 turns the filter off.
+// The filter keeps 2^IIR_SHIFT * y in 16 bits, hence the limit.
+// Time constant is about 2^IIR_SHIFT decimated results.
+#define IIR_SHIFT                 3
+#if RESULT_BITS + IIR_SHIFT > 16
+#error "IIR_SHIFT too large for RESULT_BITS"
+#endif
+
+// See main_adc_interrupt.c
+#define ACQ_CYCLES                (ACQ_US_DELAY * (_XTAL_FREQ / 4000000))
+#define ISR_ENTRY_CYCLES          9
+#if ACQ_CYCLES > ISR_ENTRY_CYCLES
+#define ACQ_PAD_CYCLES            (ACQ_CYCLES - ISR_ENTRY_CYCLES)
+#else
+#define ACQ_PAD_CYCLES            0
+#endif
+
+uint16_t adcSum = 0;                        // isr() only
+uint8_t adcCount = 0;                       // isr() only
+volatile uint16_t adcDecimated;             // latest RESULT_BITS result
+volatile uint8_t adcReady = 0;              // set by isr(), cleared by main()
+
+void system_init()
+{
+    OSCCON=0x70;          // Select 8 Mhz internal clock
+
+	// I/O
+		// ANSELx registers
+			ANSEL = 0x00;         // Set PORT ANS0 to ANS7 as Digital I/O
+			ANSELH = 0x00;        // Set PORT ANS8 to ANS11 as Digital I/O
+			ANSELbits.ANS0 = 1;   // Set RA0/AN0 to analog mode
+
+		// TRISx registers (This register specifies the data direction of each pin)
+			TRISA = 0x00;         // Set All on PORTA as Output
+			TRISB = 0x00;         // Set All on PORTB as Output
+			TRISC = 0x00;         // Set All on PORTC as Output
+            TRISD = 0x00;         // Set All on PORTD as Output
+            TRISE = 0x00;         // Set All on PORTE as Output
+			TRISAbits.TRISA0 = 1; // Set RA0/AN0 as Input
+
+		// PORT registers
+			PORTA = 0x00;         // Set PORTA all 0
+			PORTB = 0x00;         // Set PORTB all 0
+			PORTC = 0x00;         // Set PORTC all 0
+            PORTD = 0x00;         // Set PORTD all 0
+            PORTE = 0x00;         // Set PORTE all 0
+
+    // ADC setup (see main_adc.c for the register description)
+        ADCON1bits.ADFM = 1;   		// ADC result is right justified, all 10 bits are used
+        ADCON1bits.VCFG0 = 0;    	// Vref uses Vdd as reference
+        ADCON1bits.VCFG1 = 0;       // Vss as negative reference
+        ADCON0bits.ADCS = 0b10;     // Fosc/32 is the conversion clock (Tad = 4us at 8MHz)
+        ADCON0bits.CHS = PIN_A0;	// Select analog input - AN0
+        ADCON0bits.ADON = 1;    	// Turn on the ADC
+
+	// Interrupt setup
+        PIR1bits.ADIF = 0;          // Clear the ADC interrupt flag
+        PIE1bits.ADIE = 1;          // Enable the ADC interrupt
+        INTCONbits.PEIE = 1;        // ADC is a peripheral interrupt
+		INTCONbits.GIE = 1;         // Set the Global Interrupt Enable
+}
+
+/*
+ * The PIC16F887 can only have one Interrupt Service Routine.
+ * Compiler should know which function is the interrupt handler.
+ * This is done by declaring the function with 'interrupt' prefix:
+ */
+void interrupt isr()
+{
+    if(PIR1bits.ADIF == 1)
+    {
+        PIR1bits.ADIF = 0;                  // Clear the ADC interrupt flag
+
+        adcSum += (uint16_t)((ADRESH << 8) + ADRESL);
+        if(++adcCount == OVERSAMPLE_COUNT)
+        {
+            adcDecimated = adcSum >> OVERSAMPLE_BITS;   // decimate
+            adcReady = 1;
+            adcSum = 0;
+            adcCount = 0;
+        }
+
+#if ACQ_PAD_CYCLES
+        _delay(ACQ_PAD_CYCLES);             // finish the acquisition time
+#endif
+        ADCON0bits.GO_nDONE = 1;            // Start the next conversion
+    }
+}
+
+// First order IIR low-pass. The state is the output scaled by 2^IIR_SHIFT,
+// so y = state >> IIR_SHIFT keeps the fraction the shift would otherwise drop:
+// state += x - state / 2^IIR_SHIFT
+uint16_t Filter(uint16_t x)
+{
+#if IIR_SHIFT
+    static uint16_t state = 0;
+    static uint8_t primed = 0;
+
+    if(!primed)
+    {
+        state = x << IIR_SHIFT;             // start at the first input, not at 0
+        primed = 1;
+    }
+    state += x - (state >> IIR_SHIFT);
+    return state >> IIR_SHIFT;
+#else
+    return x;
+#endif
+}
+
+void main(void)
+{
+    system_init();
+
+    __delay_us(ACQ_US_DELAY);               // Acquisition time delay
+    ADCON0bits.GO_nDONE = 1;                // Start the first conversion, isr() starts the rest
+
+    while(1)
+	{
+        uint16_t result;
+
+        if(!adcReady)
+        {
+            NOP();                          // nothing to do until isr() delivers a result
+            continue;
+        }
+
+        PIE1bits.ADIE = 0;                  // 16-bit copy, keep isr() out
+        result = adcDecimated;
+        adcReady = 0;
+        PIE1bits.ADIE = 1;
+
+        result = Filter(result);
+
+        PORTD = (uint8_t)(result >> (RESULT_BITS - 8));  // upper 8 bits
+    }
+
+  return;
+}
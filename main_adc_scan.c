@@ -0,0 +1,228 @@
+/*
+ * File:   main_adc_scan.c
+ *
+ * Analog to Digital Converter (ADC) scanning several channels
+ * The ADC interrupt converts every channel of scanList[] in turn (round-robin)
+ * and keeps the latest result of each one in adcLatest[].
+ * Each channel is refreshed at least every SCAN_PERIOD_US.
+ * LED 0-3 are on while the matching scanList[] channel is above half scale
+ * LED 7 toggles every 256 complete scans
+ *
+ *  Board connection (PICKit 44-Pin Demo Board; PIC16F887):
+ *   PIN                	Module
+ * -------------------------------------------
+ *  RD0          			LED
+ *  RD1          			LED
+ *  RD2          			LED
+ *  RD3          			LED
+ *  RD7          			LED
+ *  RA0 (RP1)               POTENCIOMETER
+ *  RA1, RA2, RA3           analog inputs on the header
+ *
+ */
+
+/* The __delay_ms() function is provided by XC8.
+It requires you define _XTAL_FREQ as the frequency of your system clock.
+The compiler then uses that value to calculate how many cycles are required to give the requested delay.
+There is also __delay_us() for microseconds and _delay() to delay for a specific number of clock cycles.
+Note that __delay_ms() and __delay_us() begin with a double underscore whereas _delay()
+begins with a single underscore.
+*/
+#define _XTAL_FREQ 8000000
+
+// PIC16F887 Configuration Bit Settings
+// 'C' source line config statements
+// CONFIG1
+#pragma config FOSC = INTRC_NOCLKOUT// Oscillator Selection bits (INTOSCIO oscillator: I/O function on RA6/OSC2/CLKOUT pin, I/O function on RA7/OSC1/CLKIN)
+#pragma config WDTE = OFF       // Watchdog Timer Enable bit (WDT disabled and can be enabled by SWDTEN bit of the WDTCON register)
+#pragma config PWRTE = OFF      // Power-up Timer Enable bit (PWRT disabled)
+#pragma config MCLRE = ON       // RE3/MCLR pin function select bit (RE3/MCLR pin function is MCLR)
+#pragma config CP = OFF         // Code Protection bit (Program memory code protection is disabled)
+#pragma config CPD = OFF        // Data Code Protection bit (Data memory code protection is disabled)
+#pragma config BOREN = ON       // Brown Out Reset Selection bits (BOR enabled)
+#pragma config IESO = ON        // Internal External Switchover bit (Internal/External Switchover mode is enabled)
+#pragma config FCMEN = ON       // Fail-Safe Clock Monitor Enabled bit (Fail-Safe Clock Monitor is enabled)
+#pragma config LVP = OFF        // Low Voltage Programming Enable bit (RB3 pin has digital I/O, HV on MCLR must be used for programming)
+
+// CONFIG2
+#pragma config BOR4V = BOR40V   // Brown-out Reset Selection bit (Brown-out Reset set to 4.0V)
+#pragma config WRT = OFF        // Flash Program Memory Self Write Enable bits (Write protection off)
+
+#include <xc.h>
+#include <stdint.h>
+
+#define ACQ_US_DELAY              5
+
+// Channels to scan, in order (0 to 13 = AN0 to AN13).
+// A channel may be listed more than once to sample it more often.
+static const uint8_t scanList[] = { 0, 1, 2, 3 };
+#define SCAN_COUNT                (sizeof(scanList) / sizeof(scanList[0]))
+
+// The next channel is selected as soon as a conversion has started: the holding
+// capacitor is disconnected during the conversion and starts charging from the
+// new channel the moment it ends, so the interrupt entry already counts towards
+// the acquisition time. Only the remainder (if any) is spent in isr().
+#define ACQ_CYCLES                (ACQ_US_DELAY * (_XTAL_FREQ / 4000000))
+#define ISR_ENTRY_CYCLES          9
+#if ACQ_CYCLES > ISR_ENTRY_CYCLES
+#define ACQ_PAD_CYCLES            (ACQ_CYCLES - ISR_ENTRY_CYCLES)
+#else
+#define ACQ_PAD_CYCLES            0
+#endif
+
+// isr() code before GO that ACQ_PAD_CYCLES does not take off (the pad only
+// allows for ISR_ENTRY_CYCLES), so it adds to the acquisition: XC8 context
+// save, ADIF clear, result copy and scanIndex wrap, about 20 instruction cycles.
+#define ISR_WORK_CYCLES           20
+#define ISR_WORK_US               (ISR_WORK_CYCLES / (_XTAL_FREQ / 4000000))
+
+// Worst case time between two results of the same channel:
+// 11 Tad (Fosc/32) conversion + acquisition + isr() work, per listed channel.
+#define CONV_US                   (11 * 32 / (_XTAL_FREQ / 1000000))
+#define SCAN_PERIOD_US            (SCAN_COUNT * (CONV_US + ACQ_US_DELAY + ISR_WORK_US))
+
+// Pin behind each analog channel AN0..AN13
+static const uint8_t anPort[14] = { 'A', 'A', 'A', 'A', 'A', 'E', 'E', 'E', 'B', 'B', 'B', 'B', 'B', 'B' };
+static const uint8_t anBit[14]  = {  0,   1,   2,   3,   5,   0,   1,   2,   2,   3,   1,   4,   0,   5  };
+
+volatile uint16_t adcLatest[SCAN_COUNT];    // latest result of scanList[i]
+volatile uint8_t adcScans = 0;              // complete passes over scanList[]
+uint8_t scanIndex = 0;                      // scanList[] entry being converted (isr() only)
+
+void system_init()
+{
+    uint8_t i;
+
+    OSCCON=0x70;          // Select 8 Mhz internal clock
+
+	// I/O
+		// ANSELx registers
+			ANSEL = 0x00;         // Set PORT ANS0 to ANS7 as Digital I/O
+			ANSELH = 0x00;        // Set PORT ANS8 to ANS11 as Digital I/O
+
+		// TRISx registers (This register specifies the data direction of each pin)
+			TRISA = 0x00;         // Set All on PORTA as Output
+			TRISB = 0x00;         // Set All on PORTB as Output
+			TRISC = 0x00;         // Set All on PORTC as Output
+            TRISD = 0x00;         // Set All on PORTD as Output
+            TRISE = 0x00;         // Set All on PORTE as Output
+
+		// Every scanned channel: analog mode and input
+			for(i = 0; i < SCAN_COUNT; i++)
+			{
+				uint8_t ch = scanList[i];
+				uint8_t mask = 1 << anBit[ch];
+
+				if(ch < 8)
+					ANSEL |= 1 << ch;
+				else
+					ANSELH |= 1 << (ch - 8);
+
+				if(anPort[ch] == 'A')
+					TRISA |= mask;
+				else if(anPort[ch] == 'B')
+					TRISB |= mask;
+				else
+					TRISE |= mask;
+			}
+
+		// PORT registers
+			PORTA = 0x00;         // Set PORTA all 0
+			PORTB = 0x00;         // Set PORTB all 0
+			PORTC = 0x00;         // Set PORTC all 0
+            PORTD = 0x00;         // Set PORTD all 0
+            PORTE = 0x00;         // Set PORTE all 0
+
+    // ADC setup (see main_adc.c for the register description)
+        ADCON1bits.ADFM = 1;   		// ADC result is right justified
+        ADCON1bits.VCFG0 = 0;    	// Vref uses Vdd as reference
+        ADCON1bits.VCFG1 = 0;       // Vss as negative reference
+        ADCON0bits.ADCS = 0b10;     // Fosc/32 is the conversion clock (Tad = 4us at 8MHz)
+        ADCON0bits.CHS = scanList[0];	// First channel of the scan
+        ADCON0bits.ADON = 1;    	// Turn on the ADC
+
+	// Interrupt setup
+        PIR1bits.ADIF = 0;          // Clear the ADC interrupt flag
+        PIE1bits.ADIE = 1;          // Enable the ADC interrupt
+        INTCONbits.PEIE = 1;        // ADC is a peripheral interrupt
+		INTCONbits.GIE = 1;         // Set the Global Interrupt Enable
+}
+
+/*
+ * The PIC16F887 can only have one Interrupt Service Routine.
+ * Compiler should know which function is the interrupt handler.
+ * This is done by declaring the function with 'interrupt' prefix:
+ */
+void interrupt isr()
+{
+    if(PIR1bits.ADIF == 1)
+    {
+        uint8_t next;
+
+        PIR1bits.ADIF = 0;                  // Clear the ADC interrupt flag
+
+        adcLatest[scanIndex] = (uint16_t)((ADRESH << 8) + ADRESL);
+
+        // CHS already points at the channel after scanIndex (selected below
+        // last time), and it has been acquiring since the conversion ended.
+        if(++scanIndex == SCAN_COUNT)
+        {
+            scanIndex = 0;
+            adcScans++;
+        }
+
+#if ACQ_PAD_CYCLES
+        _delay(ACQ_PAD_CYCLES);             // finish the acquisition time
+#endif
+        ADCON0bits.GO_nDONE = 1;            // Convert scanList[scanIndex]
+
+        next = scanIndex + 1;
+        if(next == SCAN_COUNT)
+            next = 0;
+        ADCON0bits.CHS = scanList[next];    // Acquire the following one meanwhile
+    }
+}
+
+// Latest result of scanList[index]; 16-bit reads are not atomic, so keep
+// isr() out while copying.
+uint16_t ADC_GetLatest(uint8_t index)
+{
+    uint16_t value;
+
+    PIE1bits.ADIE = 0;
+    value = adcLatest[index];
+    PIE1bits.ADIE = 1;
+    return value;
+}
+
+void main(void)
+{
+    uint8_t scans;
+    uint8_t leds = 0;
+    uint8_t i;
+
+    system_init();
+
+    __delay_us(ACQ_US_DELAY);               // Acquisition time delay
+    ADCON0bits.GO_nDONE = 1;                // Convert scanList[0]
+    ADCON0bits.CHS = scanList[SCAN_COUNT > 1 ? 1 : 0];  // and acquire scanList[1]
+
+    scans = adcScans;
+    while(1)
+	{
+        while(scans == adcScans)
+            NOP();                          // wait for a complete new scan
+        scans = adcScans;
+
+        leds &= 0x80;
+        for(i = 0; i < SCAN_COUNT && i < 4; i++)
+            if(ADC_GetLatest(i) > 512)
+                leds |= 1 << i;
+        if(scans == 0)
+            leds ^= 0x80;                   // 256 scans
+
+        PORTD = leds;                       // all LEDs in one write
+    }
+
+  return;
+}
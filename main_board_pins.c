@@ -0,0 +1,162 @@
+/*
+ * File:   main_board_pins.c
+ *
+ * board.h against the code it replaces, with an SFR access benchmark
+ * The same three jobs are done three ways:
+ *   _rmw       the usual sketch code: TRIS/PORT set up register by
+ *              register, PORTxbits read-modify-write (on PORTC here, so
+ *              it cannot disturb the other two on PORTD)
+ *   _shadow    a shadow latch written out by hand
+ *   _board     the board.h macros
+ * Run it with -b to get the SFR cycles per call of each:
+ *     build/main_board_pins -b bench.tsv
+ * _board costs what _shadow costs, the macros add nothing: init 12 SFR
+ * accesses against 15, toggle 1 against 2 (a store instead of a read and
+ * a store), set and clear 1 each like a bit store. The simulator does not
+ * count the RAM instructions around them, and those make the shadow latch
+ * the slower one on the part (instruction cycles, bank selects aside):
+ *     toggle   _rmw 2 at best (MOVLW, XORWF PORTC,F)   _shadow, _board 4
+ *     pulse    _rmw 2 (BSF, BCF)                       _shadow, _board 6
+ * That is the price of freedom from the read-modify-write hazard.
+ *
+ *  Board connection (PICKit 44-Pin Demo Board; PIC16F887):
+ *   PIN                	Module
+ * -------------------------------------------
+ *  RD0          			LED (toggled by hand-written shadow code)
+ *  RD1          			LED (set and cleared by hand-written shadow code)
+ *  RD2          			LED (toggled with board.h)
+ *  RD3          			LED (set and cleared with board.h)
+ *  RA0 (RP1)               POTENCIOMETER
+ *  RB0 (SW1)               Switch
+ *
+ */
+
+
+
+/* The __delay_ms() function is provided by XC8.
+It requires you define _XTAL_FREQ as the frequency of your system clock.
+The compiler then uses that value to calculate how many cycles are required to give the requested delay.
+There is also __delay_us() for microseconds and _delay() to delay for a specific number of clock cycles.
+Note that __delay_ms() and __delay_us() begin with a double underscore whereas _delay()
+begins with a single underscore.
+*/
+#define _XTAL_FREQ 8000000
+
+// PIC16F887 Configuration Bit Settings
+// 'C' source line config statements
+// CONFIG1
+#pragma config FOSC = INTRC_NOCLKOUT// Oscillator Selection bits (INTOSCIO oscillator: I/O function on RA6/OSC2/CLKOUT pin, I/O function on RA7/OSC1/CLKIN)
+#pragma config WDTE = OFF       // Watchdog Timer Enable bit (WDT disabled and can be enabled by SWDTEN bit of the WDTCON register)
+#pragma config PWRTE = OFF      // Power-up Timer Enable bit (PWRT disabled)
+#pragma config MCLRE = ON       // RE3/MCLR pin function select bit (RE3/MCLR pin function is MCLR)
+#pragma config CP = OFF         // Code Protection bit (Program memory code protection is disabled)
+#pragma config CPD = OFF        // Data Code Protection bit (Data memory code protection is disabled)
+#pragma config BOREN = ON       // Brown Out Reset Selection bits (BOR enabled)
+#pragma config IESO = ON        // Internal External Switchover bit (Internal/External Switchover mode is enabled)
+#pragma config FCMEN = ON       // Fail-Safe Clock Monitor Enabled bit (Fail-Safe Clock Monitor is enabled)
+#pragma config LVP = OFF        // Low Voltage Programming Enable bit (RB3 pin has digital I/O, HV on MCLR must be used for programming)
+
+// CONFIG2
+#pragma config BOR4V = BOR40V   // Brown-out Reset Selection bit (Brown-out Reset set to 4.0V)
+#pragma config WRT = OFF        // Flash Program Memory Self Write Enable bits (Write protection off)
+
+#include <xc.h>
+#include <stdint.h>
+
+#define BOARD_INPUTS_A            PIN_MASK(POT)
+#define BOARD_INPUTS_B            PIN_MASK(SW1)
+#define BOARD_ANALOG              (1 << POT_AN)
+#define BOARD_IMPL                          // the shadow latches live in this file
+#include "board.h"
+
+#define RUN_MS_DELAY              100
+
+// Ports set up register by register, as system_init() does in the other sketches
+void init_rmw()
+{
+	// I/O
+		// ANSELx registers
+			ANSEL = 0x00;         // Set PORT ANS0 to ANS7 as Digital I/O
+			ANSELH = 0x00;        // Set PORT ANS8 to ANS11 as Digital I/O
+            ANSELbits.ANS0 = 1;   // Set RA0/AN0 to analog mode
+
+		// TRISx registers (This register specifies the data direction of each pin)
+			TRISA = 0x00;         // Set All on PORTA as Output
+			TRISB = 0x00;         // Set All on PORTB as Output
+			TRISC = 0x00;         // Set All on PORTC as Output
+            TRISD = 0x00;         // Set All on PORTD as Output
+            TRISE = 0x00;         // Set All on PORTE as Output
+            TRISAbits.TRISA0 = 1; // Set RA0/AN0 as Input
+            TRISBbits.TRISB0 = 1; // Set RB0 (SW1) as Input
+
+		// PORT registers (hold the current digital state of the digital I/O)
+			PORTA = 0x00;         // Set PORTA all 0
+			PORTB = 0x00;         // Set PORTB all 0
+			PORTC = 0x00;         // Set PORTC all 0
+            PORTD = 0x00;         // Set PORTD all 0
+            PORTE = 0x00;         // Set PORTE all 0
+}
+
+// The same with board.h: 12 stores, latches before TRIS
+void init_board()
+{
+    board_init();
+}
+
+void toggle_rmw()
+{
+    PORTCbits.RC0 = ~PORTCbits.RC0;
+}
+
+void toggle_shadow()
+{
+    boardLatchD ^= 0x01;
+    PORTD = boardLatchD;
+}
+
+void toggle_board()
+{
+    PIN_TOGGLE(LED2);
+}
+
+void pulse_rmw()
+{
+    PORTCbits.RC1 = 1;
+    PORTCbits.RC1 = 0;
+}
+
+void pulse_shadow()
+{
+    boardLatchD |= 0x02;
+    PORTD = boardLatchD;
+    boardLatchD &= ~0x02;
+    PORTD = boardLatchD;
+}
+
+void pulse_board()
+{
+    PIN_SET(LED3);
+    PIN_CLEAR(LED3);
+}
+
+void main(void)
+{
+    OSCCON=0x70;          // Select 8 Mhz internal clock
+
+    init_rmw();
+    init_board();
+
+    while(1)
+    {
+        toggle_rmw();
+        toggle_shadow();
+        toggle_board();
+        pulse_rmw();
+        pulse_shadow();
+        pulse_board();
+
+        __delay_ms(RUN_MS_DELAY);
+    }
+
+  return;
+}
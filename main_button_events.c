@@ -0,0 +1,288 @@
+/*
+ * File:   main_button_events.c
+ *
+ * Button engine: interrupt-on-change plus a debounce tick
+ * The PORTB pins in BUTTON_MASK are button inputs (pressed = low, weak
+ * pull-ups on). Interrupt-on-change (IOCB) notices the first edge on any
+ * of them and starts the 2 ms Timer 0 tick; the tick debounces all eight
+ * pins at once with the vertical counters of debounce.h
+ * (a pin has to read the same for DEBOUNCE_TICKS ticks in a row) and
+ * turns the debounced state into events:
+ *   EV_PRESS, EV_RELEASE   debounced edges
+ *   EV_LONG                held for LONG_PRESS_MS (once per press)
+ *   EV_DOUBLE              pressed again within DOUBLE_CLICK_MS of the last release
+ * Events go into a queue as (type << 3) | pin for main() to take out.
+ * Once every button is released and settled the tick stops again, so an
+ * idle panel costs no CPU time at all. Neither interrupt waits for
+ * anything; the tick is the longer one with a few dozen instructions per
+ * pin that is pressed or waiting for a second click.
+ * Unlike main_interrupt.c there is no delay in isr(), and unlike
+ * main_button.c no pin is polled in main().
+ *
+ *  Board connection (PICKit 44-Pin Demo Board; PIC16F887):
+ *   PIN                	Module
+ * -------------------------------------------
+ *  RD0          			LED (on while SW1 is pressed)
+ *  RD1          			LED (toggles on a double click)
+ *  RD2          			LED (toggles on a long press)
+ *  RD4-RD6          		LED (pin of the last event)
+ *  RD7          			LED (on once the event queue overflowed)
+ *  RB0 (SW1)               BUTTON
+ *  RB1-RB7                 more buttons to ground, with BUTTON_MASK = 0xFF
+ *
+ */
+
+
+/* The __delay_ms() function is provided by XC8.
+It requires you define _XTAL_FREQ as the frequency of your system clock.
+The compiler then uses that value to calculate how many cycles are required to give the requested delay.
+There is also __delay_us() for microseconds and _delay() to delay for a specific number of clock cycles.
+Note that __delay_ms() and __delay_us() begin with a double underscore whereas _delay()
+begins with a single underscore.
+*/
+#define _XTAL_FREQ 8000000
+
+// PIC16F887 Configuration Bit Settings
+// 'C' source line config statements
+// CONFIG1
+#pragma config FOSC = INTRC_NOCLKOUT// Oscillator Selection bits (INTOSCIO oscillator: I/O function on RA6/OSC2/CLKOUT pin, I/O function on RA7/OSC1/CLKIN)
+#pragma config WDTE = OFF       // Watchdog Timer Enable bit (WDT disabled and can be enabled by SWDTEN bit of the WDTCON register)
+#pragma config PWRTE = OFF      // Power-up Timer Enable bit (PWRT disabled)
+#pragma config MCLRE = ON       // RE3/MCLR pin function select bit (RE3/MCLR pin function is MCLR)
+#pragma config CP = OFF         // Code Protection bit (Program memory code protection is disabled)
+#pragma config CPD = OFF        // Data Code Protection bit (Data memory code protection is disabled)
+#pragma config BOREN = ON       // Brown Out Reset Selection bits (BOR enabled)
+#pragma config IESO = ON        // Internal External Switchover bit (Internal/External Switchover mode is enabled)
+#pragma config FCMEN = ON       // Fail-Safe Clock Monitor Enabled bit (Fail-Safe Clock Monitor is enabled)
+#pragma config LVP = OFF        // Low Voltage Programming Enable bit (RB3 pin has digital I/O, HV on MCLR must be used for programming)
+
+// CONFIG2
+#pragma config BOR4V = BOR40V   // Brown-out Reset Selection bit (Brown-out Reset set to 4.0V)
+#pragma config WRT = OFF        // Flash Program Memory Self Write Enable bits (Write protection off)
+
+#include <xc.h>
+#include <stdint.h>
+#define DEBOUNCE_IMPL                       // the debouncer state lives in this file
+#include "debounce.h"
+
+#define BUTTON_MASK               0x01      // SW1 only on the demo board; 0xFF for a full panel
+#define TICK_MS                   2
+#define TIMER_RESET_VALUE         6         // TMR0 = 256 - (0.002 * 8000000) / (4 * 16) = 6
+#define LONG_PRESS_MS             1000
+#define DOUBLE_CLICK_MS           300
+#define LONG_PRESS_TICKS          (LONG_PRESS_MS / TICK_MS)
+#define DOUBLE_CLICK_TICKS        (DOUBLE_CLICK_MS / TICK_MS)
+#if DOUBLE_CLICK_TICKS > 255
+#error "DOUBLE_CLICK_MS does not fit the 8-bit click counters"
+#endif
+
+// Events: (type << 3) | pin
+#define EV_PRESS                  0
+#define EV_RELEASE                1
+#define EV_LONG                   2
+#define EV_DOUBLE                 3
+#define EVENT(type, pin)          (uint8_t)(((type) << 3) | (pin))
+#define EVENT_TYPE(ev)            ((ev) >> 3)
+#define EVENT_PIN(ev)             ((ev) & 0x07)
+
+// Single-producer (isr) / single-consumer (main) event queue, power of two
+#define EVENT_QUEUE_SIZE          16
+
+volatile uint8_t eventQueue[EVENT_QUEUE_SIZE];
+volatile uint8_t eventHead = 0;             // next slot isr() writes
+volatile uint8_t eventTail = 0;             // next event main() reads
+volatile uint8_t eventOverruns = 0;
+
+// Button timing, isr() only
+uint16_t holdTicks[8];                      // ticks pressed, stops at LONG_PRESS_TICKS
+uint8_t clickTicks[8];                      // ticks since the last short release, 0 = none
+uint8_t edges = 0;                          // raw pin changes seen by interrupt-on-change
+
+void system_init()
+{
+    OSCCON=0x70;          // Select 8 Mhz internal clock
+
+	// I/O
+		// ANSELx registers
+			ANSEL = 0x00;         // Set PORT ANS0 to ANS7 as Digital I/O
+			ANSELH = 0x00;        // Set PORT ANS8 to ANS11 as Digital I/O (RB0-RB5 too)
+
+		// TRISx registers (This register specifies the data direction of each pin)
+			TRISA = 0x00;         // Set All on PORTA as Output
+			TRISB = 0xFF;         // Set All on PORTB as Input
+			TRISC = 0x00;         // Set All on PORTC as Output
+            TRISD = 0x00;         // Set All on PORTD as Output
+            TRISE = 0x00;         // Set All on PORTE as Output
+
+		// PORT registers (hold the current digital state of the digital I/O)
+			PORTA = 0x00;         // Set PORTA all 0
+			PORTB = 0x00;         // Set PORTB all 0
+			PORTC = 0x00;         // Set PORTC all 0
+            PORTD = 0x00;         // Set PORTD all 0
+            PORTE = 0x00;         // Set PORTE all 0
+
+		// Weak pull-ups (see main_button.c) hold released buttons high
+			WPUB = BUTTON_MASK;   // Pull-ups on the button pins only
+			OPTION_REGbits.nRBPU = 0; // Enable the PORTB pull-ups
+
+	// Timer Setup - Timer 0 (see main_timer_interrupt_long.c), only runs while a button is busy
+		OPTION_REGbits.PSA = 0; 	// Prescaler assigned to Timer 0
+        OPTION_REGbits.PS = 0b011;  // Set the prescaler to 1:16
+		OPTION_REGbits.T0CS = 0;    // Use the instruction clock (Fcy/4) as the timer clock.
+
+	// Interrupt-on-change setup
+    /*
+     * -------------------IOCB------------------------------------------
+     * Bit#:  ----7-----6-----5-----4-----3-----2-----1-----0----------
+     *        --|IOCB7|IOCB6|IOCB5|IOCB4|IOCB3|IOCB2|IOCB1|IOCB0|------
+     * -----------------------------------------------------------------
+     * A 1 enables interrupt-on-change for that PORTB pin. The pins are
+     * compared with what PORTB read last time; a difference sets RBIF,
+     * and RBIF can only be cleared after PORTB has been read again.
+    */
+        IOCB = BUTTON_MASK;         // Every button pin
+        (void)PORTB;                // Start comparing from the current levels
+        INTCONbits.RBIF = 0;        // Clear the port B change interrupt flag
+		INTCONbits.RBIE = 1;        // Enable the port B change interrupt
+		INTCONbits.GIE = 1;         // Set the Global Interrupt Enable
+}
+
+void event_put(uint8_t ev)
+{
+    uint8_t next = (eventHead + 1) & (EVENT_QUEUE_SIZE - 1);
+
+    if(next == eventTail)
+    {
+        eventOverruns++;                    // main() is behind, drop the event
+        return;
+    }
+    eventQueue[eventHead] = ev;
+    eventHead = next;
+}
+
+// One Timer 0 tick: debounce all pins, then time the busy ones.
+// Returns 0 once there is nothing left to time.
+uint8_t debounce_tick()
+{
+    uint8_t sample = ~PORTB & BUTTON_MASK;  // pressed = 1
+    uint8_t changed, pin, mask, busy;
+
+    changed = debounce_update(sample);
+
+    busy = debounced ^ sample;              // still counting
+    for(pin = 0, mask = 0x01; pin < 8; pin++, mask <<= 1)
+    {
+        if(changed & mask)
+        {
+            if(debounced & mask)
+            {
+                event_put(EVENT(EV_PRESS, pin));
+                if(clickTicks[pin])
+                {
+                    event_put(EVENT(EV_DOUBLE, pin));
+                    clickTicks[pin] = 0;
+                }
+                holdTicks[pin] = 0;
+            }
+            else
+            {
+                event_put(EVENT(EV_RELEASE, pin));
+                if(holdTicks[pin] < LONG_PRESS_TICKS)
+                    clickTicks[pin] = 1;    // may be the first of two
+            }
+        }
+        else if((debounced & mask) && holdTicks[pin] < LONG_PRESS_TICKS)
+        {
+            if(++holdTicks[pin] == LONG_PRESS_TICKS)
+                event_put(EVENT(EV_LONG, pin));
+        }
+        else if(clickTicks[pin])
+        {
+            if(++clickTicks[pin] > DOUBLE_CLICK_TICKS)
+                clickTicks[pin] = 0;        // too late for a double click
+        }
+        if(clickTicks[pin] || ((debounced & mask) && holdTicks[pin] < LONG_PRESS_TICKS))
+            busy |= mask;                   // still timing; a held button after
+                                            //   its long press waits for the release edge
+    }
+    return busy;
+}
+
+/*
+ * The PIC16F887 can only have one Interrupt Service Routine.
+ * Compiler should know which function is the interrupt handler.
+ * This is done by declaring the function with 'interrupt' prefix:
+ */
+void interrupt isr()
+{
+    if(INTCONbits.RBIE && INTCONbits.RBIF)
+    {
+        (void)PORTB;                        // Reading PORTB ends the mismatch...
+        INTCONbits.RBIF = 0;                // ...so the flag can be cleared
+        edges++;
+        if(!INTCONbits.T0IE)
+        {
+            TMR0 = TIMER_RESET_VALUE;       // first edge: start the debounce tick
+            INTCONbits.T0IF = 0;
+            INTCONbits.T0IE = 1;
+        }
+    }
+    if(INTCONbits.T0IE && INTCONbits.T0IF)
+    {
+        INTCONbits.T0IF = 0;                // Clear the Timer 0 interrupt flag
+        TMR0 += TIMER_RESET_VALUE;          // Add, don't overwrite (see main_scheduler.c)
+        if(!debounce_tick())
+            INTCONbits.T0IE = 0;            // all released and settled: stop until the next edge
+    }
+}
+
+uint8_t event_get(uint8_t *ev)
+{
+    if(eventTail == eventHead)
+        return 0;
+    *ev = eventQueue[eventTail];
+    eventTail = (eventTail + 1) & (EVENT_QUEUE_SIZE - 1);
+    return 1;
+}
+
+void main(void)
+{
+    uint8_t leds = 0;
+
+    system_init();
+
+    while(1)
+    {
+        uint8_t ev;
+
+        if(!event_get(&ev))
+        {
+            NOP();                          // nothing to do until isr() queues an event
+            continue;
+        }
+
+        switch(EVENT_TYPE(ev))
+        {
+        case EV_PRESS:
+            if(EVENT_PIN(ev) == 0)
+                leds |= 0x01;
+            break;
+        case EV_RELEASE:
+            if(EVENT_PIN(ev) == 0)
+                leds &= ~0x01;
+            break;
+        case EV_DOUBLE:
+            leds ^= 0x02;
+            break;
+        case EV_LONG:
+            leds ^= 0x04;
+            break;
+        }
+        leds = (leds & 0x0F) | (EVENT_PIN(ev) << 4);
+        if(eventOverruns)
+            leds |= 0x80;
+        PORTD = leds;                       // all LEDs in one write
+    }
+
+  return;
+}
@@ -0,0 +1,358 @@
+/*
+ * File:   main_clock_governor.c
+ *
+ * Clock scaling: run fast for bursts of work, slow in between
+ * The other sketches pick one clock for good (8 MHz with OSCCON = 0x70,
+ * 250 kHz with IRCF = 0b010). Here a governor in main() switches the
+ * internal oscillator at run time: CLOCK_FAST while there is work (every
+ * Timer 1 tick: 16 ADC samples averaged and put on the PWM), CLOCK_SLOW
+ * otherwise, where the core draws a fraction of the current.
+ *
+ * Everything that counts instruction cycles depends on Fosc, so each level
+ * in clockLevels[] carries its own Timer 0, Timer 1 and Timer 2 setup for
+ * the same periods, and clock_set() moves them over:
+ *   - Timer 0: the prescaler makes up for the clock, TMR0 counts at the
+ *     same rate at every level and overflows every 8.192 ms without a
+ *     reload. Only PS changes. This is the cheapest way when a prescaler
+ *     pair exists for the clock ratio (1:64 and 1:2 for 32).
+ *   - Timer 1: reloaded for a 102.4 ms tick. The counts made since the
+ *     last tick are converted to the new count rate, so the tick in
+ *     progress keeps its length. The rates are 2^n apart, a shift does it.
+ *     The sums run at the fast clock, before slowing down or after
+ *     speeding up, so Timer 1 is stopped for a few counts only (it
+ *     loses some 0.1% here, switching 20 times a second).
+ *   - Timer 2 / PWM: new PR2 and prescaler, and the duty scaled to the new
+ *     number of steps. The period of the switch itself is cut short.
+ *   - ADC: conversion clock kept within the 1.6 us minimum Tad.
+ *   - Delays: __delay_ms() is fixed at compile time for _XTAL_FREQ, use
+ *     clock_delay_ms() for delays that must hold at any level.
+ * The heartbeat LEDs show whether the ticks stay on time; the simulator
+ * reports the time spent at each frequency.
+ *
+ *  Board connection (PICKit 44-Pin Demo Board; PIC16F887):
+ *   PIN                	Module
+ * -------------------------------------------
+ *  RD0          			LED (Timer 0 heartbeat, toggles every 500 ms)
+ *  RD1          			LED (toggles every Timer 1 tick, 102.4 ms)
+ *  RD2          			LED (on while the clock is fast)
+ *  RD7 (P1D)          		LED (PWM, brightness follows the potentiometer)
+ *  RA0 (RP1)               POTENCIOMETER
+ *
+ */
+
+
+
+/* The __delay_ms() function is provided by XC8.
+It requires you define _XTAL_FREQ as the frequency of your system clock.
+The compiler then uses that value to calculate how many cycles are required to give the requested delay.
+There is also __delay_us() for microseconds and _delay() to delay for a specific number of clock cycles.
+Note that __delay_ms() and __delay_us() begin with a double underscore whereas _delay()
+begins with a single underscore.
+*/
+#define _XTAL_FREQ 8000000
+
+// PIC16F887 Configuration Bit Settings
+// 'C' source line config statements
+// CONFIG1
+#pragma config FOSC = INTRC_NOCLKOUT// Oscillator Selection bits (INTOSCIO oscillator: I/O function on RA6/OSC2/CLKOUT pin, I/O function on RA7/OSC1/CLKIN)
+#pragma config WDTE = OFF       // Watchdog Timer Enable bit (WDT disabled and can be enabled by SWDTEN bit of the WDTCON register)
+#pragma config PWRTE = OFF      // Power-up Timer Enable bit (PWRT disabled)
+#pragma config MCLRE = ON       // RE3/MCLR pin function select bit (RE3/MCLR pin function is MCLR)
+#pragma config CP = OFF         // Code Protection bit (Program memory code protection is disabled)
+#pragma config CPD = OFF        // Data Code Protection bit (Data memory code protection is disabled)
+#pragma config BOREN = ON       // Brown Out Reset Selection bits (BOR enabled)
+#pragma config IESO = ON        // Internal External Switchover bit (Internal/External Switchover mode is enabled)
+#pragma config FCMEN = ON       // Fail-Safe Clock Monitor Enabled bit (Fail-Safe Clock Monitor is enabled)
+#pragma config LVP = OFF        // Low Voltage Programming Enable bit (RB3 pin has digital I/O, HV on MCLR must be used for programming)
+
+// CONFIG2
+#pragma config BOR4V = BOR40V   // Brown-out Reset Selection bit (Brown-out Reset set to 4.0V)
+#pragma config WRT = OFF        // Flash Program Memory Self Write Enable bits (Write protection off)
+
+#include <xc.h>
+#include <stdint.h>
+
+#define ACQ_US_DELAY              5         // at CLOCK_FAST only (__delay_us() uses _XTAL_FREQ)
+#define ADC_SAMPLES               16
+
+// The periods that must not change with the clock
+#define HEARTBEAT_TICKS           61        // 500 ms of 8.192 ms Timer 0 overflows
+#define TMR1_TICK_US              102400    // whole TMR1H steps at both levels
+#define PWM_HZ                    500
+
+// Timer 0: instruction cycles per overflow
+#define T0_CYCLES(pre)            (256UL * (pre))
+// Timer 1: the same, 65536 - counts; isr() only reloads TMR1H
+#define T1_COUNTS(fosc, pre)      ((fosc) / 4 / (pre) / 100 * (TMR1_TICK_US / 100) / 100)
+// Timer 2: PR2 + 1 (a PWM period is (PR2 + 1) x 4 Tosc x prescaler)
+#define T2_COUNTS(fosc, pre)      ((fosc) / 4 / (pre) / PWM_HZ)
+
+// Levels. Timer 0 must count at the same rate at every level, the count
+// rates of Timer 1 must differ by powers of two: t1Shift is their log2
+// over the slowest.
+#define CLOCK_SLOW                0         // 250 kHz
+#define CLOCK_SLOW_HZ             250000UL
+#define CLOCK_FAST                1         // 8 MHz
+#define CLOCK_FAST_HZ             8000000UL
+#define CLOCK_LEVELS              2
+
+#if T0_CYCLES(64) / (CLOCK_FAST_HZ / 4000) != T0_CYCLES(2) / (CLOCK_SLOW_HZ / 4000) \
+    || T1_COUNTS(CLOCK_FAST_HZ, 8) != 4 * T1_COUNTS(CLOCK_SLOW_HZ, 1) || T1_COUNTS(CLOCK_FAST_HZ, 8) > 65536UL \
+    || T2_COUNTS(CLOCK_FAST_HZ, 16) > 256 || T2_COUNTS(CLOCK_SLOW_HZ, 1) > 256 \
+    || T1_COUNTS(CLOCK_FAST_HZ, 8) % 256 || T1_COUNTS(CLOCK_SLOW_HZ, 1) % 256
+#error "tick periods do not fit the prescalers in clockLevels[]"
+#endif
+
+typedef struct {
+    uint8_t  ircf;                          // OSCCON IRCF
+    uint8_t  adcs;                          // ADCON0 ADCS, Tad >= 1.6 us
+    uint8_t  t0ps;                          // OPTION_REG PS (PSA = 0)
+    uint8_t  t1ckps;                        // T1CON T1CKPS
+    uint16_t t1Reload;
+    uint8_t  t1Shift;
+    uint8_t  t2ckps;                        // T2CON T2CKPS
+    uint8_t  pr2;
+} clock_level_t;
+
+const clock_level_t clockLevels[CLOCK_LEVELS] = {
+    // CLOCK_SLOW: 62.5 kHz Fcy, Tad = 2 Tosc = 8 us
+    { 0b010, 0b00,
+      0b000,                                                           // 1:2
+      0b00, (uint16_t)(65536UL - T1_COUNTS(CLOCK_SLOW_HZ, 1)), 0,      // 1:1
+      0b00, T2_COUNTS(CLOCK_SLOW_HZ, 1) - 1 },                         // 1:1
+    // CLOCK_FAST: 2 MHz Fcy, Tad = 32 Tosc = 4 us
+    { 0b111, 0b10,
+      0b101,                                                           // 1:64
+      0b11, (uint16_t)(65536UL - T1_COUNTS(CLOCK_FAST_HZ, 8)), 2,      // 1:8
+      0b10, T2_COUNTS(CLOCK_FAST_HZ, 16) - 1 },                        // 1:16
+};
+
+uint8_t clockLevel = CLOCK_SLOW;
+uint8_t pwmDuty = 0;                        // 0..255, scaled to the PWM steps of the level
+
+volatile uint8_t t0Ticks = 0;               // set by isr(), handled by main()
+volatile uint8_t t1Ticks = 0;
+
+// CCPR1L:DC1B for pwmDuty at the current PR2: duty x 4 (PR2 + 1) / 256
+void pwm_write()
+{
+    uint16_t steps = (uint16_t)pwmDuty * (clockLevels[clockLevel].pr2 + 1) >> 6;
+
+    CCP1CONbits.DC1B = steps & 0b11;
+    CCPR1L = (uint8_t)(steps >> 2);
+}
+
+// Timer counts at the count rate of another level
+uint16_t rescale(uint16_t counts, uint8_t fromShift, uint8_t toShift)
+{
+    if(toShift > fromShift)
+        return counts << (toShift - fromShift);
+    return counts >> (fromShift - toShift);
+}
+
+void clock_set(uint8_t level)
+{
+    const clock_level_t *from = &clockLevels[clockLevel];
+    const clock_level_t *to = &clockLevels[level];
+    uint8_t gie;
+    uint16_t t1;
+
+    if(level == clockLevel)
+        return;
+    gie = INTCONbits.GIE;
+    INTCONbits.GIE = 0;                     // isr() reloads with the level's values
+
+    T1CONbits.TMR1ON = 0;                   // no carry from TMR1L while it is moved
+    t1 = TMR1;
+    if(to->ircf > from->ircf)
+    {
+        OSCCONbits.IRCF = to->ircf;         // speed up first, then do the sums
+        OPTION_REGbits.PS = to->t0ps;
+    }
+
+    // The counts of the tick in progress at the new rate. If the tick has
+    // just ended and isr() has not run yet, they count from 0, and the
+    // reload isr() adds is the new one.
+    if(!PIR1bits.TMR1IF)
+        t1 -= from->t1Reload;
+    t1 = rescale(t1, from->t1Shift, to->t1Shift);
+    if(!PIR1bits.TMR1IF)
+        t1 += to->t1Reload;
+
+    if(to->ircf < from->ircf)
+    {
+        OSCCONbits.IRCF = to->ircf;         // slow down once the sums are done
+        OPTION_REGbits.PS = to->t0ps;
+    }
+    T1CONbits.T1CKPS = to->t1ckps;
+    TMR1 = t1;
+    T1CONbits.TMR1ON = 1;
+    clockLevel = level;
+
+    // Timer 2: restart the PWM period with the new PR2 and duty steps
+    T2CONbits.T2CKPS = to->t2ckps;
+    PR2 = to->pr2;
+    TMR2 = 0;
+    pwm_write();
+
+    ADCON0bits.ADCS = to->adcs;
+    PORTDbits.RD2 = level == CLOCK_FAST;
+    INTCONbits.GIE = gie;
+}
+
+// __delay_ms() for whatever the clock is now
+void clock_delay_ms(uint16_t ms)
+{
+    while(ms--)
+    {
+        if(clockLevel == CLOCK_FAST)
+            _delay(CLOCK_FAST_HZ / 4000);
+        else
+            _delay(CLOCK_SLOW_HZ / 4000);
+    }
+}
+
+void system_init()
+{
+    const clock_level_t *level = &clockLevels[CLOCK_SLOW];
+
+    OSCCONbits.IRCF = level->ircf;          // Start slow
+
+	// I/O
+		// ANSELx registers
+			ANSEL = 0x00;         // Set PORT ANS0 to ANS7 as Digital I/O
+			ANSELH = 0x00;        // Set PORT ANS8 to ANS11 as Digital I/O
+            ANSELbits.ANS0 = 1;   // Set RA0/AN0 to analog mode
+
+		// TRISx registers (This register specifies the data direction of each pin)
+			TRISA = 0x00;         // Set All on PORTA as Output
+			TRISB = 0x00;         // Set All on PORTB as Output
+			TRISC = 0x00;         // Set All on PORTC as Output
+            TRISD = 0x00;         // Set All on PORTD as Output
+            TRISE = 0x00;         // Set All on PORTE as Output
+            TRISAbits.TRISA0 = 1; // Set RA0/AN0 as Input
+
+		// PORT registers (hold the current digital state of the digital I/O)
+			PORTA = 0x00;         // Set PORTA all 0
+			PORTB = 0x00;         // Set PORTB all 0
+			PORTC = 0x00;         // Set PORTC all 0
+            PORTD = 0x00;         // Set PORTD all 0
+            PORTE = 0x00;         // Set PORTE all 0
+
+    // ADC setup (see main_adc.c for the register description)
+        ADCON1bits.ADFM = 1;   		// ADC result is right justified, all 10 bits are used
+        ADCON1bits.VCFG0 = 0;    	// Vref uses Vdd as reference
+        ADCON1bits.VCFG1 = 0;       // Vss as negative reference
+        ADCON0bits.ADCS = level->adcs;
+        ADCON0bits.CHS = 0;         // Select analog input - AN0
+        ADCON0bits.ADON = 1;    	// Turn on the ADC
+
+	// Timer Setup - Timer 0 (see main_timer_interrupt.c)
+        OPTION_REGbits.T0CS = 0;    // Internal instruction cycle clock
+        OPTION_REGbits.PSA = 0;     // Prescaler assigned to Timer 0
+        OPTION_REGbits.PS = level->t0ps;
+        TMR0 = 0;                   // free running, no reload
+
+	// Timer Setup - Timer 1 (see main_timer1.c), internal clock
+        T1CON = 0;
+        T1CONbits.T1CKPS = level->t1ckps;
+        TMR1 = level->t1Reload;
+        T1CONbits.TMR1ON = 1;
+
+    // PWM on P1D (see main_pwm.c)
+        PR2 = level->pr2;
+        CCP1CON = 0b00001100;       // Single output, PWM, active high
+        CCPR1L = 0;
+        PSTRCON = 0b1000;           // STRD: P1D (RD7)
+        T2CON = level->t2ckps;
+        T2CONbits.TMR2ON = 1;
+
+	// Interrupt setup
+        INTCONbits.T0IF = 0;
+        INTCONbits.T0IE = 1;        // Timer 0 tick
+        PIR1bits.TMR1IF = 0;
+        PIE1bits.TMR1IE = 1;        // Timer 1 tick
+        INTCONbits.PEIE = 1;
+		INTCONbits.GIE = 1;         // Set the Global Interrupt Enable
+}
+
+/*
+ * The PIC16F887 can only have one Interrupt Service Routine.
+ * Compiler should know which function is the interrupt handler.
+ * This is done by declaring the function with 'interrupt' prefix:
+ */
+void interrupt isr()
+{
+    if(INTCONbits.T0IE && INTCONbits.T0IF)
+    {
+        INTCONbits.T0IF = 0;
+        t0Ticks++;
+    }
+    if(PIE1bits.TMR1IE && PIR1bits.TMR1IF)
+    {
+        PIR1bits.TMR1IF = 0;
+        TMR1H += clockLevels[clockLevel].t1Reload >> 8;  // TMR1L has only just wrapped, leave it counting
+        t1Ticks++;
+    }
+}
+
+// The burst: ADC_SAMPLES conversions of the potentiometer, averaged
+uint8_t sample()
+{
+    uint16_t sum = 0;
+    uint8_t i;
+
+    for(i = 0; i < ADC_SAMPLES; i++)
+    {
+        __delay_us(ACQ_US_DELAY);           // Acquisition time delay
+        ADCON0bits.GO_nDONE = 1;
+        while(ADCON0bits.GO_nDONE);
+        sum += (uint16_t)((ADRESH << 8) + ADRESL);
+    }
+    return (uint8_t)(sum >> 6);             // 16 x 10 bits -> 8 bits
+}
+
+void main(void)
+{
+    uint8_t heartbeat = 0;
+
+    system_init();
+
+    PORTD = 0x03;
+    clock_delay_ms(200);                    // lamp test, 200 ms at 250 kHz
+    PORTD = 0x00;
+
+    while(1)
+    {
+        // The governor: fast while there is work, slow otherwise
+        clock_set(t1Ticks ? CLOCK_FAST : CLOCK_SLOW);
+
+        if(!t0Ticks && !t1Ticks)
+        {
+            NOP();                          // nothing to do until isr() delivers a tick
+            continue;
+        }
+        if(t0Ticks)
+        {
+            INTCONbits.GIE = 0;
+            t0Ticks--;
+            INTCONbits.GIE = 1;
+            if(++heartbeat == HEARTBEAT_TICKS)
+            {
+                heartbeat = 0;
+                PORTDbits.RD0 = ~PORTDbits.RD0;
+            }
+        }
+        if(t1Ticks)
+        {
+            INTCONbits.GIE = 0;
+            t1Ticks--;
+            INTCONbits.GIE = 1;
+            PORTDbits.RD1 = ~PORTDbits.RD1;
+            pwmDuty = sample();
+            pwm_write();
+        }
+    }
+
+  return;
+}
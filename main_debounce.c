@@ -0,0 +1,154 @@
+/*
+ * File:   main_debounce.c
+ *
+ * Debouncing all eight PORTB inputs at once
+ * Unlike main_button.c, which waits 10 ms and reads one pin again, every
+ * PORTB pin is sampled on a 4 ms Timer 0 tick and run through the
+ * vertical-counter debouncer of debounce.h: eight pins cost the same few
+ * AND/XOR instructions as one, and nothing ever waits. A change is
+ * accepted once a pin reads the same on four ticks in a row, 12 to 16 ms
+ * after the contact settles. LED n is on while button n is pressed, and
+ * presses[] counts the presses of each button.
+ *
+ * Checking it against bouncing contacts in the simulator, with 5 or 8 ms
+ * of chatter on every change and the LEDs as the response port:
+ *     build/main_debounce -t 2 -l D -s 0.5:B=0xFE,5 -s 0.8:B=0xFF,5
+ *         -s 1.1:B=0x0F,8 -s 1.4:B=0xFF,8
+ * should report every pin change answered once, no extra edges and no
+ * latency above the bounce time plus 16 ms. 'make test' in sim/ runs
+ * exactly this and fails otherwise.
+ *
+ *  Board connection (PICKit 44-Pin Demo Board; PIC16F887):
+ *   PIN                	Module
+ * -------------------------------------------
+ *  RD0-RD7          		LED (on while the matching RB pin is pressed)
+ *  RB0 (SW1)               BUTTON
+ *  RB1-RB7                 more buttons to ground (weak pull-ups on)
+ *
+ */
+
+
+
+/* The __delay_ms() function is provided by XC8.
+It requires you define _XTAL_FREQ as the frequency of your system clock.
+The compiler then uses that value to calculate how many cycles are required to give the requested delay.
+There is also __delay_us() for microseconds and _delay() to delay for a specific number of clock cycles.
+Note that __delay_ms() and __delay_us() begin with a double underscore whereas _delay()
+begins with a single underscore.
+*/
+#define _XTAL_FREQ 8000000
+
+// PIC16F887 Configuration Bit Settings
+// 'C' source line config statements
+// CONFIG1
+#pragma config FOSC = INTRC_NOCLKOUT// Oscillator Selection bits (INTOSCIO oscillator: I/O function on RA6/OSC2/CLKOUT pin, I/O function on RA7/OSC1/CLKIN)
+#pragma config WDTE = OFF       // Watchdog Timer Enable bit (WDT disabled and can be enabled by SWDTEN bit of the WDTCON register)
+#pragma config PWRTE = OFF      // Power-up Timer Enable bit (PWRT disabled)
+#pragma config MCLRE = ON       // RE3/MCLR pin function select bit (RE3/MCLR pin function is MCLR)
+#pragma config CP = OFF         // Code Protection bit (Program memory code protection is disabled)
+#pragma config CPD = OFF        // Data Code Protection bit (Data memory code protection is disabled)
+#pragma config BOREN = ON       // Brown Out Reset Selection bits (BOR enabled)
+#pragma config IESO = ON        // Internal External Switchover bit (Internal/External Switchover mode is enabled)
+#pragma config FCMEN = ON       // Fail-Safe Clock Monitor Enabled bit (Fail-Safe Clock Monitor is enabled)
+#pragma config LVP = OFF        // Low Voltage Programming Enable bit (RB3 pin has digital I/O, HV on MCLR must be used for programming)
+
+// CONFIG2
+#pragma config BOR4V = BOR40V   // Brown-out Reset Selection bit (Brown-out Reset set to 4.0V)
+#pragma config WRT = OFF        // Flash Program Memory Self Write Enable bits (Write protection off)
+
+#include <xc.h>
+#include <stdint.h>
+#define DEBOUNCE_IMPL                       // the debouncer state lives in this file
+#include "debounce.h"
+
+#define TICK_MS                   4
+#define TIMER_RESET_VALUE         6         // TMR0 = 256 - (0.004 * 8000000) / (4 * 32) = 6
+
+volatile uint8_t presses[8];                // per button, counted by main()
+volatile uint8_t pressedEdges = 0;          // buttons that went down since main() last looked
+
+void system_init()
+{
+    OSCCON=0x70;          // Select 8 Mhz internal clock
+
+	// I/O
+		// ANSELx registers
+			ANSEL = 0x00;         // Set PORT ANS0 to ANS7 as Digital I/O
+			ANSELH = 0x00;        // Set PORT ANS8 to ANS11 as Digital I/O (all of PORTB)
+
+		// TRISx registers (This register specifies the data direction of each pin)
+			TRISA = 0x00;         // Set All on PORTA as Output
+			TRISB = 0xFF;         // Set All on PORTB as Input
+			TRISC = 0x00;         // Set All on PORTC as Output
+            TRISD = 0x00;         // Set All on PORTD as Output
+            TRISE = 0x00;         // Set All on PORTE as Output
+
+		// PORT registers (hold the current digital state of the digital I/O)
+			PORTA = 0x00;         // Set PORTA all 0
+			PORTB = 0x00;         // Set PORTB all 0
+			PORTC = 0x00;         // Set PORTC all 0
+            PORTD = 0x00;         // Set PORTD all 0
+            PORTE = 0x00;         // Set PORTE all 0
+
+		// Weak pull-ups (see main_button.c) hold released buttons high
+			WPUB = 0xFF;          // Pull-ups on every PORTB pin
+			OPTION_REGbits.nRBPU = 0; // Enable the PORTB pull-ups
+
+	// Timer Setup - Timer 0 (see main_timer_interrupt_long.c)
+		OPTION_REGbits.PSA = 0; 	// Prescaler assigned to Timer 0
+        OPTION_REGbits.PS = 0b100;  // Set the prescaler to 1:32
+		OPTION_REGbits.T0CS = 0;    // Use the instruction clock (Fcy/4) as the timer clock.
+		INTCONbits.T0IF = 0;        // Clear the Timer 0 interrupt flag
+		TMR0 = TIMER_RESET_VALUE;   // Load the starting value back into the timer
+
+	// Interrupt setup
+		INTCONbits.T0IE = 1;        // Enable the Timer 0 interrupt
+		INTCONbits.GIE = 1;         // Set the Global Interrupt Enable
+}
+
+/*
+ * The PIC16F887 can only have one Interrupt Service Routine.
+ * Compiler should know which function is the interrupt handler.
+ * This is done by declaring the function with 'interrupt' prefix:
+ */
+void interrupt isr()
+{
+    if(INTCONbits.T0IE && INTCONbits.T0IF)
+    {
+        uint8_t changed;
+
+        INTCONbits.T0IF = 0;                // Clear the Timer 0 interrupt flag
+        TMR0 += TIMER_RESET_VALUE;          // Add, don't overwrite (see main_scheduler.c)
+
+        changed = debounce_update(~PORTB);  // pressed = 1, one read for all eight pins
+        if(changed)
+        {
+            PORTD = debounced;              // LEDs follow the debounced buttons
+            pressedEdges |= changed & debounced;
+        }
+    }
+}
+
+void main(void)
+{
+    uint8_t down, pin;
+
+    system_init();
+
+    while(1)
+    {
+        while(!pressedEdges)
+            NOP();                          // wait for a press
+
+        INTCONbits.T0IE = 0;                // take the edges atomically
+        down = pressedEdges;
+        pressedEdges = 0;
+        INTCONbits.T0IE = 1;
+
+        for(pin = 0; pin < 8; pin++)
+            if(down & (1 << pin))
+                presses[pin]++;
+    }
+
+  return;
+}
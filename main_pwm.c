@@ -171,8 +171,8 @@ void main(void)
         uint16_t adcResult = ADC_GetConversion(); //Start ADC conversion
 
         // set the new duty cycle
-        CCPR1H = adcResult & 0b11;    // LSB or like this: CCP1CONbits.DC1B = adcResult & 0b11;
-        CCPR1L = adcResult >> 2;      // MSB
+        CCP1CONbits.DC1B = adcResult & 0b11;  // LSB (CCPR1H is read-only in PWM mode)
+        CCPR1L = adcResult >> 2;      // MSB (see pwm.h for an update that never tears a period)
         
 		__delay_ms(50);             // sleep 50 milliseconds
     }
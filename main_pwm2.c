@@ -134,9 +134,9 @@ void system_init()
      *   5. Configure the CCP module for PWM operation.
     */
     // Set the PWM period by loading the PR2 register.
-        PR2 = 0x40;                     // Frequency: 2 kHz
+        PR2 = 0x40;                     // Frequency: 1.92 kHz (pwm.h solves PR2 for an exact target)
         // PWM period = (64 + 1) x 4 x (1 / 8000000) x 16 = 0.00052 second
-        // PWM frequency = 1 / PWM period = 1 / 0.00052 = 1923.07 Hz ~ 2.0 kHz
+        // PWM frequency = 1 / PWM period = 1 / 0.00052 = 1923.07 Hz ~ 1.92 kHz
         PSTRCON = 0b00011110;           // Enable Pulse Steering on port D pins
         
     // Configure the CCP module for the PWM mode by loading the CCPxCON register with the appropriate values.
@@ -174,7 +174,7 @@ void main(void)
         uint8_t adcResult = ADC_GetConversion(); //Start ADC conversion
 
         // set the new duty cycle
-        CCPR1H = adcResult & 0b11;           // LSB or like this: CCP1CONbits.DC1B = adcResult & 0b11;
+        CCP1CONbits.DC1B = adcResult & 0b11; // LSB (CCPR1H is read-only in PWM mode)
         CCPR1L = adcResult >> 2;             // MSB
         
         __delay_ms(50);                      // sleep 50 milliseconds
@@ -0,0 +1,123 @@
+/*
+ * File:   main_pwm_driver.c
+ *
+ * PWM through the pwm.h driver
+ * Same job as main_pwm.c (the potentiometer sets the brightness of an
+ * LED), but PR2 and the Timer 2 prescaler are worked out by pwm.h from
+ * PWM_FREQ_HZ instead of by hand, and a target it cannot meet stops the
+ * build. At 8 MHz, 5 kHz comes out as prescaler 1:1 and PR2 = 99:
+ * exactly 5000 Hz with 400 duty steps (8.6 bits). The ADC result
+ * is scaled to the steps so the knob covers 0 to 100%.
+ *
+ *  Board connection (PICKit 44-Pin Demo Board; PIC16F887):
+ *   PIN                	Module
+ * -------------------------------------------
+ *  RD7 (P1D)          		LED (PWM)
+ *  RA0 (RP1)               POTENCIOMETER
+ *
+ */
+
+
+
+/* The __delay_ms() function is provided by XC8.
+It requires you define _XTAL_FREQ as the frequency of your system clock.
+The compiler then uses that value to calculate how many cycles are required to give the requested delay.
+There is also __delay_us() for microseconds and _delay() to delay for a specific number of clock cycles.
+Note that __delay_ms() and __delay_us() begin with a double underscore whereas _delay()
+begins with a single underscore.
+*/
+#define _XTAL_FREQ 8000000
+
+// PIC16F887 Configuration Bit Settings
+// 'C' source line config statements
+// CONFIG1
+#pragma config FOSC = INTRC_NOCLKOUT// Oscillator Selection bits (INTOSCIO oscillator: I/O function on RA6/OSC2/CLKOUT pin, I/O function on RA7/OSC1/CLKIN)
+#pragma config WDTE = OFF       // Watchdog Timer Enable bit (WDT disabled and can be enabled by SWDTEN bit of the WDTCON register)
+#pragma config PWRTE = OFF      // Power-up Timer Enable bit (PWRT disabled)
+#pragma config MCLRE = ON       // RE3/MCLR pin function select bit (RE3/MCLR pin function is MCLR)
+#pragma config CP = OFF         // Code Protection bit (Program memory code protection is disabled)
+#pragma config CPD = OFF        // Data Code Protection bit (Data memory code protection is disabled)
+#pragma config BOREN = ON       // Brown Out Reset Selection bits (BOR enabled)
+#pragma config IESO = ON        // Internal External Switchover bit (Internal/External Switchover mode is enabled)
+#pragma config FCMEN = ON       // Fail-Safe Clock Monitor Enabled bit (Fail-Safe Clock Monitor is enabled)
+#pragma config LVP = OFF        // Low Voltage Programming Enable bit (RB3 pin has digital I/O, HV on MCLR must be used for programming)
+
+// CONFIG2
+#pragma config BOR4V = BOR40V   // Brown-out Reset Selection bit (Brown-out Reset set to 4.0V)
+#pragma config WRT = OFF        // Flash Program Memory Self Write Enable bits (Write protection off)
+
+#include <xc.h>
+#include <stdint.h>
+
+#define PWM_FREQ_HZ               5000
+#define PWM_STEERING              0b1000    // STRD: P1D (RD7), an LED on the demo board
+#define PWM_IMPL                            // pwm.h state, if any, lives in this file
+#include "pwm.h"
+
+#define ACQ_US_DELAY              5
+
+// The figures pwm.h settled on, for the debugger
+const uint32_t pwmActualHz = PWM_ACTUAL_HZ;
+const uint8_t pwmResolutionBits = PWM_RESOLUTION_BITS;
+
+void system_init()
+{
+    OSCCON=0x70;          // Select 8 Mhz internal clock
+
+	// I/O
+		// ANSELx registers
+			ANSEL = 0x00;         // Set PORT ANS0 to ANS7 as Digital I/O
+			ANSELH = 0x00;        // Set PORT ANS8 to ANS11 as Digital I/O
+            ANSELbits.ANS0 = 1;   // Set RA0/AN0 to analog mode
+
+		// TRISx registers (This register specifies the data direction of each pin)
+			TRISA = 0x00;         // Set All on PORTA as Output
+			TRISB = 0x00;         // Set All on PORTB as Output
+			TRISC = 0x00;         // Set All on PORTC as Output
+            TRISD = 0x00;         // Set All on PORTD as Output
+            TRISE = 0x00;         // Set All on PORTE as Output
+            TRISAbits.TRISA0 = 1; // Set RA0/AN0 as Input
+
+		// PORT registers
+			PORTA = 0x00;         // Set PORTA all 0
+			PORTB = 0x00;         // Set PORTB all 0
+			PORTC = 0x00;         // Set PORTC all 0
+            PORTD = 0x00;         // Set PORTD all 0
+            PORTE = 0x00;         // Set PORTE all 0
+
+    // ADC setup (see main_adc.c for the register description)
+        ADCON1bits.ADFM = 1;   		// ADC result is right justified
+        ADCON1bits.VCFG0 = 0;    	// Vref uses Vdd as reference
+        ADCON1bits.VCFG1 = 0;       // Vss as negative reference
+        ADCON0bits.ADCS = 0b10;     // Fosc/32 is the conversion clock (Tad = 4us at 8MHz)
+        ADCON0bits.CHS = 0;         // Select analog input - AN0
+        ADCON0bits.ADON = 1;    	// Turn on the ADC
+
+    // PWM setup: period, prescaler and steering all come from pwm.h
+        pwm_init();
+}
+
+uint16_t ADC_GetConversion()
+{
+    __delay_us(ACQ_US_DELAY);					// Acquisition time delay
+    ADCON0bits.GO_nDONE = 1;					// Start the conversion
+    while (ADCON0bits.GO_nDONE);				// Wait for the conversion to finish
+    return ((uint16_t)((ADRESH << 8) + ADRESL));// Conversion finished, return the result
+}
+
+void main(void)
+{
+    system_init();
+
+    while(1)
+	{
+        uint16_t adcResult = ADC_GetConversion();
+
+        // 0..1023 -> 0..PWM_DUTY_STEPS, so full scale is fully on
+        pwm_set_duty((uint16_t)(((uint32_t)adcResult * PWM_DUTY_STEPS + 512) >> 10));
+
+		__delay_ms(50);             // sleep 50 milliseconds
+    }
+
+  return;
+}
@@ -0,0 +1,125 @@
+/*
+ * File:   main_pwm_fade.c
+ *
+ * Breathing LED with period-synchronous PWM updates
+ * The duty ramps up and down by one step every FADE_STEP_US, the kind of
+ * stream of small updates where writing CCPR1L and DC1B from main() now
+ * and then lets the module latch a period between the two writes (a
+ * torn period: new high bits with the old low bits or the other way
+ * round). With PWM_SYNC 1 pwm.h hands every update to the TMR2IF
+ * interrupt, which writes both right after a period has started, so each
+ * period runs with a complete 10-bit duty. Set PWM_SYNC to 0 and the
+ * simulator report counts the torn periods.
+ *
+ *  Board connection (PICKit 44-Pin Demo Board; PIC16F887):
+ *   PIN                	Module
+ * -------------------------------------------
+ *  RD7 (P1D)          		LED (PWM)
+ *
+ */
+
+
+
+/* The __delay_ms() function is provided by XC8.
+It requires you define _XTAL_FREQ as the frequency of your system clock.
+The compiler then uses that value to calculate how many cycles are required to give the requested delay.
+There is also __delay_us() for microseconds and _delay() to delay for a specific number of clock cycles.
+Note that __delay_ms() and __delay_us() begin with a double underscore whereas _delay()
+begins with a single underscore.
+*/
+#define _XTAL_FREQ 8000000
+
+// PIC16F887 Configuration Bit Settings
+// 'C' source line config statements
+// CONFIG1
+#pragma config FOSC = INTRC_NOCLKOUT// Oscillator Selection bits (INTOSCIO oscillator: I/O function on RA6/OSC2/CLKOUT pin, I/O function on RA7/OSC1/CLKIN)
+#pragma config WDTE = OFF       // Watchdog Timer Enable bit (WDT disabled and can be enabled by SWDTEN bit of the WDTCON register)
+#pragma config PWRTE = OFF      // Power-up Timer Enable bit (PWRT disabled)
+#pragma config MCLRE = ON       // RE3/MCLR pin function select bit (RE3/MCLR pin function is MCLR)
+#pragma config CP = OFF         // Code Protection bit (Program memory code protection is disabled)
+#pragma config CPD = OFF        // Data Code Protection bit (Data memory code protection is disabled)
+#pragma config BOREN = ON       // Brown Out Reset Selection bits (BOR enabled)
+#pragma config IESO = ON        // Internal External Switchover bit (Internal/External Switchover mode is enabled)
+#pragma config FCMEN = ON       // Fail-Safe Clock Monitor Enabled bit (Fail-Safe Clock Monitor is enabled)
+#pragma config LVP = OFF        // Low Voltage Programming Enable bit (RB3 pin has digital I/O, HV on MCLR must be used for programming)
+
+// CONFIG2
+#pragma config BOR4V = BOR40V   // Brown-out Reset Selection bit (Brown-out Reset set to 4.0V)
+#pragma config WRT = OFF        // Flash Program Memory Self Write Enable bits (Write protection off)
+
+#include <xc.h>
+#include <stdint.h>
+
+#define PWM_FREQ_HZ               5000
+#define PWM_STEERING              0b1000    // STRD: P1D (RD7), an LED on the demo board
+#define PWM_SYNC                  1         // 0: write the duty from main() and see periods tear
+#define PWM_IMPL                            // the pending duty lives in this file
+#include "pwm.h"
+
+#define FADE_STEP_US              500       // 400 steps up and down: 0.4 s per breath
+
+void system_init()
+{
+    OSCCON=0x70;          // Select 8 Mhz internal clock
+
+	// I/O
+		// ANSELx registers
+			ANSEL = 0x00;         // Set PORT ANS0 to ANS7 as Digital I/O
+			ANSELH = 0x00;        // Set PORT ANS8 to ANS11 as Digital I/O
+
+		// TRISx registers (This register specifies the data direction of each pin)
+			TRISA = 0x00;         // Set All on PORTA as Output
+			TRISB = 0x00;         // Set All on PORTB as Output
+			TRISC = 0x00;         // Set All on PORTC as Output
+            TRISD = 0x00;         // Set All on PORTD as Output
+            TRISE = 0x00;         // Set All on PORTE as Output
+
+		// PORT registers
+			PORTA = 0x00;         // Set PORTA all 0
+			PORTB = 0x00;         // Set PORTB all 0
+			PORTC = 0x00;         // Set PORTC all 0
+            PORTD = 0x00;         // Set PORTD all 0
+            PORTE = 0x00;         // Set PORTE all 0
+
+    // PWM setup: period, prescaler and steering all come from pwm.h
+        pwm_init();
+
+	// Interrupt setup
+        INTCONbits.PEIE = 1;        // Timer 2 is a peripheral interrupt
+		INTCONbits.GIE = 1;         // Set the Global Interrupt Enable
+}
+
+/*
+ * The PIC16F887 can only have one Interrupt Service Routine.
+ * Compiler should know which function is the interrupt handler.
+ * This is done by declaring the function with 'interrupt' prefix:
+ */
+void interrupt isr()
+{
+#if PWM_SYNC
+    if(PIE1bits.TMR2IE && PIR1bits.TMR2IF)
+        pwm_commit();                       // a period has just started
+#endif
+}
+
+void main(void)
+{
+    uint16_t duty = 0;
+    int8_t step = 1;
+
+    system_init();
+
+    while(1)
+    {
+        pwm_set_duty(duty);
+        __delay_us(FADE_STEP_US);
+
+        if(duty == PWM_DUTY_STEPS)
+            step = -1;
+        else if(duty == 0)
+            step = 1;
+        duty += step;
+    }
+
+  return;
+}
@@ -0,0 +1,261 @@
+/*
+ * File:   main_scheduler.c
+ *
+ * Cooperative task scheduler on the 1 ms Timer 0 tick
+ * (the Timer 0 setup of main_timer_wheel.c)
+ * Instead of one job and __delay_ms() in main(), every job is a short task
+ * function that the scheduler calls at its own period. A task must not wait;
+ * it does a little work and returns. Periods are counted in ticks from the
+ * interrupt, so they do not depend on how long the other tasks take.
+ * Timer 1 counts instruction cycles / 4 to measure how much of the CPU each task
+ * uses (taskLoad[], in percent, updated every second).
+ *
+ *  Board connection (PICKit 44-Pin Demo Board; PIC16F887):
+ *   PIN                	Module
+ * -------------------------------------------
+ *  RD0          			LED (blinks, 0.5 s)
+ *  RD1          			LED (on while SW1 is pressed)
+ *  RD4-RD6          		LED (potentiometer level)
+ *  RD7          			LED (on while the CPU is more than half busy)
+ *  RA0 (RP1)               POTENCIOMETER
+ *  RB0 (SW1)               BUTTON
+ *
+ */
+
+/* The __delay_ms() function is provided by XC8.
+It requires you define _XTAL_FREQ as the frequency of your system clock.
+The compiler then uses that value to calculate how many cycles are required to give the requested delay.
+There is also __delay_us() for microseconds and _delay() to delay for a specific number of clock cycles.
+Note that __delay_ms() and __delay_us() begin with a double underscore whereas _delay()
+begins with a single underscore.
+*/
+#define _XTAL_FREQ 1000000
+
+// PIC16F887 Configuration Bit Settings
+// 'C' source line config statements
+// CONFIG1
+#pragma config FOSC = INTRC_NOCLKOUT// Oscillator Selection bits (INTOSCIO oscillator: I/O function on RA6/OSC2/CLKOUT pin, I/O function on RA7/OSC1/CLKIN)
+#pragma config WDTE = OFF       // Watchdog Timer Enable bit (WDT disabled and can be enabled by SWDTEN bit of the WDTCON register)
+#pragma config PWRTE = OFF      // Power-up Timer Enable bit (PWRT disabled)
+#pragma config MCLRE = ON       // RE3/MCLR pin function select bit (RE3/MCLR pin function is MCLR)
+#pragma config CP = OFF         // Code Protection bit (Program memory code protection is disabled)
+#pragma config CPD = OFF        // Data Code Protection bit (Data memory code protection is disabled)
+#pragma config BOREN = ON       // Brown Out Reset Selection bits (BOR enabled)
+#pragma config IESO = ON        // Internal External Switchover bit (Internal/External Switchover mode is enabled)
+#pragma config FCMEN = ON       // Fail-Safe Clock Monitor Enabled bit (Fail-Safe Clock Monitor is enabled)
+#pragma config LVP = OFF        // Low Voltage Programming Enable bit (RB3 pin has digital I/O, HV on MCLR must be used for programming)
+
+// CONFIG2
+#pragma config BOR4V = BOR40V   // Brown-out Reset Selection bit (Brown-out Reset set to 4.0V)
+#pragma config WRT = OFF        // Flash Program Memory Self Write Enable bits (Write protection off)
+
+#include <xc.h>
+#include <stdint.h>
+
+// 1 ms tick, exactly: Timer 0 without the prescaler, reloaded by adding, plus
+// the 2 counts a TMR0 write stalls it for (see main_timer_wheel.c)
+//   Fcy = 1 MHz / 4 = 250 kHz, 1 ms = 250 cycles (must be 256 or less)
+#define TICK_CYCLES       (_XTAL_FREQ / 4 / 1000)
+#define TMR0_WRITE_LOSS   2
+#define TMR0_RELOAD       (256 - TICK_CYCLES + TMR0_WRITE_LOSS)
+#if TICK_CYCLES > 256
+#error "1 ms is too long for Timer 0 without a prescaler at this _XTAL_FREQ"
+#endif
+
+#define TIMER1_HZ         (_XTAL_FREQ / 4 / 4)  // Timer 1 counts per second (Fcy, 1:4)
+#define LOAD_WINDOW_MS    1000                  // taskLoad[] is measured over this time
+#define LOAD_WARN         50                    // RD7 lights above this total load, %
+
+volatile uint8_t tickCount = 0;                 // 1 ms ticks, counted by isr()
+
+// Tasks
+void task_blink(void);
+void task_button(void);
+void task_adc(void);
+
+typedef struct
+{
+    void (*run)(void);
+    uint16_t period;              // ticks (ms) between two runs
+    uint16_t countdown;           // ticks until the next run
+    uint16_t busy;                // Timer 1 counts spent in run() this window
+    uint8_t overruns;             // runs that started a whole period late
+} task_t;
+
+task_t tasks[] = {
+    // run          period  countdown  busy  overruns
+    { task_blink,      500,         1,    0,        0 },
+    { task_button,      10,         2,    0,        0 },
+    { task_adc,         20,         3,    0,        0 },
+};
+#define TASK_COUNT        (sizeof(tasks) / sizeof(tasks[0]))
+
+uint8_t taskLoad[TASK_COUNT];                   // % of the CPU, last window
+uint8_t totalLoad;                              // all tasks together, %
+
+void system_init()
+{
+    OSCCONbits.IRCF = 0b100;       // Select 1 MHz internal clock
+
+	// I/O
+		// ANSELx registers
+			ANSEL = 0x00;         // Set PORT ANS0 to ANS7 as Digital I/O
+			ANSELH = 0x00;        // Set PORT ANS8 to ANS11 as Digital I/O
+			ANSELbits.ANS0 = 1;   // Set RA0/AN0 to analog mode
+
+		// TRISx registers (This register specifies the data direction of each pin)
+			TRISA = 0x01;         // Set All on PORTA as Output, and AN0 as Input
+			TRISB = 0x01;         // Set All on PORTB as Output, and B0 (SW1) as Input
+			TRISC = 0x00;         // Set All on PORTC as Output
+            TRISD = 0x00;         // Set All on PORTD as Output
+            TRISE = 0x00;         // Set All on PORTE as Output
+
+		// PORT registers (hold the current digital state of the digital I/O)
+			PORTA = 0x00;         // Set PORTA all 0
+			PORTB = 0x00;         // Set PORTB all 0
+			PORTC = 0x00;         // Set PORTC all 0
+            PORTD = 0x00;         // Set PORTD all 0
+            PORTE = 0x00;         // Set PORTE all 0
+
+    // ADC setup (see main_adc.c)
+        ADCON1bits.ADFM = 0;   		// ADC result is left justified, ADRESH is enough here
+        ADCON0bits.ADCS = 0b00;     // Fosc/2 is the conversion clock (Tad = 2us at 1MHz)
+        ADCON0bits.CHS = 0;         // Select analog input - AN0
+        ADCON0bits.ADON = 1;    	// Turn on the ADC
+
+	// Timer Setup - Timer 0 (see main_timer_interrupt_long.c)
+		OPTION_REGbits.PSA = 1; 	// Prescaler assigned to the WDT: Timer 0 counts every instruction cycle
+		OPTION_REGbits.T0CS = 0;    // Use the instruction clock (Fcy/4) as the timer clock.
+		INTCONbits.T0IF = 0;        // Clear the Timer 0 interrupt flag
+		TMR0 = TMR0_RELOAD;         // First tick
+
+	// Timer Setup - Timer 1 (see main_timer1.c)
+    // Free running at Fcy / 4, only read to measure time: a whole LOAD_WINDOW_MS
+    // (62500 counts) still fits in a task's 16-bit busy count
+        T1CONbits.TMR1CS = 0;       // Internal clock (Fcy)
+        T1CONbits.T1CKPS = 0b10;    // 1:4 prescaler
+        T1CONbits.TMR1ON = 1;       // Start Timer 1
+
+	// Interrupt setup
+		INTCONbits.T0IE = 1;        // Enable the Timer 0 interrupt
+		INTCONbits.GIE = 1;         // Set the Global Interrupt Enable
+}
+
+/*
+ * The PIC16F887 can only have one Interrupt Service Routine.
+ * Compiler should know which function is the interrupt handler.
+ * This is done by declaring the function with 'interrupt' prefix:
+ */
+void interrupt isr()
+{
+    if(INTCONbits.T0IF)
+    {
+        INTCONbits.T0IF = 0;        // Clear the Timer 0 interrupt flag
+        TMR0 += TMR0_RELOAD;        // Add, don't overwrite (see TMR0_RELOAD)
+        tickCount++;
+    }
+}
+
+// Timer 1 can carry from TMR1L into TMR1H between the two reads;
+// read TMR1H again and retry if it changed.
+uint16_t timer1_read()
+{
+    uint8_t high, low;
+
+    do
+    {
+        high = TMR1H;
+        low = TMR1L;
+    } while(high != TMR1H);
+    return ((uint16_t)high << 8) | low;
+}
+
+void task_blink()
+{
+    PORTDbits.RD0 = ~PORTDbits.RD0; // Toggle the LED
+}
+
+void task_button()
+{
+    PORTDbits.RD1 = PORTBbits.RB0 == 0 ? 1 : 0;     // RB0 == 0V (pressed)
+}
+
+// Reads the conversion started by the previous run and starts the next one,
+// so the task never waits for the ADC. The 20 ms in between are a long
+// enough acquisition time.
+void task_adc()
+{
+    if(ADCON0bits.GO_nDONE)
+        return;                                     // not finished yet
+
+    PORTD = (PORTD & 0x8F) | ((ADRESH >> 1) & 0x70);   // top 3 bits on RD4-RD6
+    ADCON0bits.GO_nDONE = 1;                        // Start the next conversion
+}
+
+// Every LOAD_WINDOW_MS: turn the busy counts into percent of the window
+void update_load()
+{
+    uint8_t i;
+    uint32_t total = 0;
+
+    for(i = 0; i < TASK_COUNT; i++)
+    {
+        total += tasks[i].busy;
+        taskLoad[i] = (uint8_t)((uint32_t)tasks[i].busy * 100 / (TIMER1_HZ / 1000 * LOAD_WINDOW_MS));
+        tasks[i].busy = 0;
+    }
+    totalLoad = (uint8_t)(total * 100 / (TIMER1_HZ / 1000 * LOAD_WINDOW_MS));
+    PORTDbits.RD7 = totalLoad > LOAD_WARN;
+}
+
+void main(void)
+{
+    uint8_t lastTick;
+    uint16_t windowTicks = 0;
+
+    system_init();
+
+    lastTick = tickCount;
+    while(1)
+    {
+        uint8_t elapsed;
+        uint8_t i;
+
+        while(tickCount == lastTick)
+            NOP();                                  // idle until the next tick
+        elapsed = tickCount - lastTick;             // more than 1 if the tasks ran long
+        lastTick += elapsed;
+
+        for(i = 0; i < TASK_COUNT; i++)
+        {
+            task_t *task = &tasks[i];
+
+            if(task->countdown > elapsed)
+            {
+                task->countdown -= elapsed;
+                continue;
+            }
+            task->countdown += task->period - elapsed;
+            while(task->countdown == 0 || task->countdown > task->period)
+            {
+                task->countdown += task->period;    // missed a whole period
+                task->overruns++;
+            }
+
+            {
+                uint16_t start = timer1_read();
+                task->run();
+                task->busy += timer1_read() - start;
+            }
+        }
+
+        windowTicks += elapsed;
+        if(windowTicks >= LOAD_WINDOW_MS)
+        {
+            windowTicks -= LOAD_WINDOW_MS;
+            update_load();
+        }
+    }
+
+  return;
+}
@@ -0,0 +1,219 @@
+/*
+ * File:   main_sleep_idle.c
+ *
+ * Low-power idle: SLEEP whenever there is nothing to do
+ * main_timer_interrupt.c and friends wait in __delay_ms() at full CPU
+ * current. Here main() runs whatever is pending and then goes to Sleep,
+ * where the CPU clock stops, until one of the wake sources has work for
+ * it:
+ *   Timer 1   on the 32.768 kHz T1OSC crystal in asynchronous mode, so it
+ *             keeps counting in Sleep; a 250 ms tick
+ *   ADC       converting on its own FRC clock in Sleep (less noise too);
+ *             ADIF wakes the CPU with the result
+ *   IOC       SW1 on RB0, interrupt-on-change
+ *   WDT       ~2.1 s backstop: it only ends a Sleep if the crystal stopped
+ *             and the tick never came
+ * The check for pending work and SLEEP run with GIE off: an interrupt that
+ * arrives in between still wakes the CPU (SLEEP then acts as a NOP), and
+ * its isr() runs as soon as GIE is set again, so no event is slept through.
+ * The simulator report shows the share of time spent asleep.
+ *
+ *  Board connection (PICKit 44-Pin Demo Board; PIC16F887):
+ *   PIN                	Module
+ * -------------------------------------------
+ *  RD0          			LED (blinks at 0.5 Hz: the tick)
+ *  RD1          			LED (toggled by SW1)
+ *  RD2          			LED (on after a WDT wake-up: crystal failure)
+ *  RD4-RD7          		LED (potentiometer, top 4 bits)
+ *  RB0 (SW1)               BUTTON
+ *  RA0 (RP1)               POTENCIOMETER
+ *  RC0, RC1 (T1OSO, T1OSI) 32.768 kHz crystal
+ *
+ */
+
+
+
+/* The __delay_ms() function is provided by XC8.
+It requires you define _XTAL_FREQ as the frequency of your system clock.
+The compiler then uses that value to calculate how many cycles are required to give the requested delay.
+There is also __delay_us() for microseconds and _delay() to delay for a specific number of clock cycles.
+Note that __delay_ms() and __delay_us() begin with a double underscore whereas _delay()
+begins with a single underscore.
+*/
+#define _XTAL_FREQ 8000000
+
+// PIC16F887 Configuration Bit Settings
+// 'C' source line config statements
+// CONFIG1
+#pragma config FOSC = INTRC_NOCLKOUT// Oscillator Selection bits (INTOSCIO oscillator: I/O function on RA6/OSC2/CLKOUT pin, I/O function on RA7/OSC1/CLKIN)
+#pragma config WDTE = OFF       // Watchdog Timer Enable bit (WDT disabled and can be enabled by SWDTEN bit of the WDTCON register)
+#pragma config PWRTE = OFF      // Power-up Timer Enable bit (PWRT disabled)
+#pragma config MCLRE = ON       // RE3/MCLR pin function select bit (RE3/MCLR pin function is MCLR)
+#pragma config CP = OFF         // Code Protection bit (Program memory code protection is disabled)
+#pragma config CPD = OFF        // Data Code Protection bit (Data memory code protection is disabled)
+#pragma config BOREN = ON       // Brown Out Reset Selection bits (BOR enabled)
+#pragma config IESO = ON        // Internal External Switchover bit (Internal/External Switchover mode is enabled)
+#pragma config FCMEN = ON       // Fail-Safe Clock Monitor Enabled bit (Fail-Safe Clock Monitor is enabled)
+#pragma config LVP = OFF        // Low Voltage Programming Enable bit (RB3 pin has digital I/O, HV on MCLR must be used for programming)
+
+// CONFIG2
+#pragma config BOR4V = BOR40V   // Brown-out Reset Selection bit (Brown-out Reset set to 4.0V)
+#pragma config WRT = OFF        // Flash Program Memory Self Write Enable bits (Write protection off)
+
+#include <xc.h>
+#include <stdint.h>
+
+#define TICK_MS                   250
+#define TMR1H_RELOAD              0xE0      // 0x2000 counts of 32.768 kHz = 250 ms
+#define ADC_EVERY_TICKS           4         // sample the potentiometer once a second
+#define BLINK_EVERY_TICKS         4
+
+// Work for main(), set by isr()
+volatile uint8_t ticks = 0;                 // Timer 1 ticks not handled yet
+volatile uint8_t buttonPressed = 0;
+volatile uint8_t adcDone = 0;
+
+uint8_t wdtWakeups = 0;
+
+void system_init()
+{
+    OSCCON=0x70;          // Select 8 Mhz internal clock
+
+	// I/O
+		// ANSELx registers
+			ANSEL = 0x00;         // Set PORT ANS0 to ANS7 as Digital I/O
+			ANSELH = 0x00;        // Set PORT ANS8 to ANS11 as Digital I/O
+            ANSELbits.ANS0 = 1;   // Set RA0/AN0 to analog mode
+
+		// TRISx registers (This register specifies the data direction of each pin)
+			TRISA = 0x00;         // Set All on PORTA as Output
+			TRISB = 0x00;         // Set All on PORTB as Output
+			TRISC = 0x00;         // Set All on PORTC as Output
+            TRISD = 0x00;         // Set All on PORTD as Output
+            TRISE = 0x00;         // Set All on PORTE as Output
+            TRISAbits.TRISA0 = 1; // Set RA0/AN0 as Input
+            TRISBbits.TRISB0 = 1; // Set RB0 (SW1) as Input
+            TRISCbits.TRISC0 = 1; // T1OSO and T1OSI belong to the crystal
+            TRISCbits.TRISC1 = 1;
+
+		// PORT registers (hold the current digital state of the digital I/O)
+			PORTA = 0x00;         // Set PORTA all 0
+			PORTB = 0x00;         // Set PORTB all 0
+			PORTC = 0x00;         // Set PORTC all 0
+            PORTD = 0x00;         // Set PORTD all 0
+            PORTE = 0x00;         // Set PORTE all 0
+
+    // ADC setup (see main_adc.c for the register description)
+        ADCON1bits.ADFM = 0;   		// ADC result is left justified: ADRESH has the top 8 bits
+        ADCON1bits.VCFG0 = 0;    	// Vref uses Vdd as reference
+        ADCON1bits.VCFG1 = 0;       // Vss as negative reference
+        ADCON0bits.ADCS = 0b11;     // FRC: the ADC's own oscillator, runs in Sleep
+        ADCON0bits.CHS = 0;         // Select analog input - AN0
+        ADCON0bits.ADON = 1;    	// Turn on the ADC
+
+	// Timer Setup - Timer 1 (see main_timer1.c for T1CON)
+        TMR1L = 0;
+        TMR1H = TMR1H_RELOAD;
+        T1CON = 0b00001111;         // T1OSC crystal, prescaler 1:1, not synchronized
+                                    //   (keeps counting in Sleep), Timer1=On
+
+	// Watchdog: 1:65536 of the 31 kHz LFINTOSC (see main_wdt.c), Timer 0 postscaler 1:1
+        OPTION_REGbits.PSA = 1;
+        OPTION_REGbits.PS = 0b000;
+        WDTCONbits.WDTPS = 0b1011;
+        WDTCONbits.SWDTEN = 1;
+
+	// Interrupt setup
+        PIR1bits.TMR1IF = 0;
+        PIE1bits.TMR1IE = 1;        // Timer 1 tick
+        PIR1bits.ADIF = 0;
+        PIE1bits.ADIE = 1;          // ADC result
+        IOCBbits.IOCB0 = 1;         // SW1
+        (void)PORTB;                // Latch the current level
+        INTCONbits.RBIF = 0;
+        INTCONbits.RBIE = 1;
+        INTCONbits.PEIE = 1;        // Timer 1 and ADC are peripheral interrupts
+		INTCONbits.GIE = 1;         // Set the Global Interrupt Enable
+}
+
+/*
+ * The PIC16F887 can only have one Interrupt Service Routine.
+ * Compiler should know which function is the interrupt handler.
+ * This is done by declaring the function with 'interrupt' prefix:
+ */
+void interrupt isr()
+{
+    if(PIE1bits.TMR1IE && PIR1bits.TMR1IF)
+    {
+        PIR1bits.TMR1IF = 0;
+        TMR1H = TMR1H_RELOAD;               // TMR1L has only just wrapped, leave it counting
+        ticks++;
+    }
+    if(PIE1bits.ADIE && PIR1bits.ADIF)
+    {
+        PIR1bits.ADIF = 0;
+        adcDone = 1;
+    }
+    if(INTCONbits.RBIE && INTCONbits.RBIF)
+    {
+        uint8_t level = PORTB;              // Reading PORTB ends the mismatch
+
+        INTCONbits.RBIF = 0;
+        if(!(level & 0x01))
+            buttonPressed = 1;              // falling edge: pressed (bounce: see main_button_events.c)
+    }
+}
+
+// Go to Sleep unless isr() has left work; returns once something woke the CPU
+void idle()
+{
+    INTCONbits.GIE = 0;                     // no isr() between the check and SLEEP
+    if(!ticks && !buttonPressed && !adcDone)
+    {
+        SLEEP();                            // a pending enabled flag wakes it, GIE or not
+        NOP();
+        if(!STATUSbits.nTO)
+        {
+            wdtWakeups++;                   // WDT, not the tick: the crystal has stopped
+            PORTDbits.RD2 = 1;
+        }
+    }
+    INTCONbits.GIE = 1;                     // whatever woke us is handled by isr() now
+}
+
+void main(void)
+{
+    uint8_t tickCount = 0;
+
+    system_init();
+
+    while(1)
+    {
+        if(ticks)
+        {
+            INTCONbits.GIE = 0;
+            ticks--;
+            INTCONbits.GIE = 1;
+
+            tickCount++;
+            if(tickCount % BLINK_EVERY_TICKS == 0)
+                PORTDbits.RD0 = ~PORTDbits.RD0;
+            if(tickCount % ADC_EVERY_TICKS == 0)
+                ADCON0bits.GO_nDONE = 1;    // converts while we sleep, ADIF wakes us
+        }
+        if(adcDone)
+        {
+            adcDone = 0;
+            PORTD = (PORTD & 0x0F) | (ADRESH & 0xF0);
+        }
+        if(buttonPressed)
+        {
+            buttonPressed = 0;
+            PORTDbits.RD1 = ~PORTDbits.RD1;
+        }
+
+        idle();
+    }
+
+  return;
+}
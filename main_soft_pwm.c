@@ -0,0 +1,194 @@
+/*
+ * File:   main_soft_pwm.c
+ *
+ * Software PWM on all eight PORTD LEDs, bit angle modulation (BAM)
+ * The hardware PWM (main_pwm2.c) has one duty cycle that PSTRCON can only
+ * steer to several pins at once; here every LED gets its own 8-bit
+ * brightness. A frame is cut into eight slots, slot k lasting
+ * BAM_UNIT_CYCLES << k instruction cycles, and during slot k PORTD shows
+ * bit k of every duty (a bit plane). An LED with duty d is therefore on
+ * for d / 256 of the frame: 256 x 64 cycles = 8.2 ms, 122 Hz at 8 MHz.
+ *
+ * Timer 2 times the slots: PR2 and the postscaler are reloaded for the
+ * next slot in isr(), which writes PORTD once per slot from a precomputed
+ * plane, whatever the duties are. Timer 2 keeps counting through the
+ * interrupt, so the slot lengths do not depend on the interrupt latency,
+ * but PR2 has to be written before TMR2 gets to it: otherwise TMR2 runs on
+ * to 255 and the slot lasts 256 counts. The shortest slot
+ * (BAM_UNIT_CYCLES) bounds isr() up to its PR2 write, interrupt latency
+ * and context save included.
+ * main() turns new duties into planes in a second buffer, which isr()
+ * takes over at the start of the next frame.
+ *
+ * The demo runs a comet of fading brightness around the eight LEDs;
+ * build/main_soft_pwm -m D shows each LED's measured duty cycle.
+ *
+ *  Board connection (PICKit 44-Pin Demo Board; PIC16F887):
+ *   PIN                	Module
+ * -------------------------------------------
+ *  RD0-RD7          		LED (8-bit brightness each)
+ *
+ */
+
+
+
+/* The __delay_ms() function is provided by XC8.
+It requires you define _XTAL_FREQ as the frequency of your system clock.
+The compiler then uses that value to calculate how many cycles are required to give the requested delay.
+There is also __delay_us() for microseconds and _delay() to delay for a specific number of clock cycles.
+Note that __delay_ms() and __delay_us() begin with a double underscore whereas _delay()
+begins with a single underscore.
+*/
+#define _XTAL_FREQ 8000000
+
+// PIC16F887 Configuration Bit Settings
+// 'C' source line config statements
+// CONFIG1
+#pragma config FOSC = INTRC_NOCLKOUT// Oscillator Selection bits (INTOSCIO oscillator: I/O function on RA6/OSC2/CLKOUT pin, I/O function on RA7/OSC1/CLKIN)
+#pragma config WDTE = OFF       // Watchdog Timer Enable bit (WDT disabled and can be enabled by SWDTEN bit of the WDTCON register)
+#pragma config PWRTE = OFF      // Power-up Timer Enable bit (PWRT disabled)
+#pragma config MCLRE = ON       // RE3/MCLR pin function select bit (RE3/MCLR pin function is MCLR)
+#pragma config CP = OFF         // Code Protection bit (Program memory code protection is disabled)
+#pragma config CPD = OFF        // Data Code Protection bit (Data memory code protection is disabled)
+#pragma config BOREN = ON       // Brown Out Reset Selection bits (BOR enabled)
+#pragma config IESO = ON        // Internal External Switchover bit (Internal/External Switchover mode is enabled)
+#pragma config FCMEN = ON       // Fail-Safe Clock Monitor Enabled bit (Fail-Safe Clock Monitor is enabled)
+#pragma config LVP = OFF        // Low Voltage Programming Enable bit (RB3 pin has digital I/O, HV on MCLR must be used for programming)
+
+// CONFIG2
+#pragma config BOR4V = BOR40V   // Brown-out Reset Selection bit (Brown-out Reset set to 4.0V)
+#pragma config WRT = OFF        // Flash Program Memory Self Write Enable bits (Write protection off)
+
+#include <xc.h>
+#include <stdint.h>
+
+#define BAM_SLOTS                 8         // 8-bit duty
+#define BAM_UNIT_CYCLES           64        // slot 0, Tcy
+#define BAM_PERIODS               9         // Timer 2 periods per frame
+#define COMET_STEP_MS             80
+
+// isr() up to the PR2 write, by hand count: about 4 cycles of latency,
+// 10 to 15 of XC8 context save and 25 to 35 of code. That does not fit in
+// 32 cycles; 64 leaves room. Recount from the XC8 listing when isr() changes.
+
+// Timer 2 period by period at prescaler 1:1: PR2 + 1 counts up to 256, then
+// 256 counts times the postscaler. Slot 7 (64 << 7 = 8192 cycles) is more
+// than 1:16 allows, so it runs as two 4096 cycle periods.
+const uint8_t periodPlane[BAM_PERIODS] = { 0, 1, 2, 3, 4, 5, 6, 7, 7 };
+const uint8_t periodPr2[BAM_PERIODS]   = { 63, 127, 255, 255, 255, 255, 255, 255, 255 };
+const uint8_t periodT2con[BAM_PERIODS] = {
+    0b00000100, 0b00000100, 0b00000100,                 // TMR2ON, postscaler 1:1
+    0b00001100, 0b00011100, 0b00111100,                 // 1:2, 1:4, 1:8
+    0b01111100, 0b01111100, 0b01111100,                 // 1:16
+};
+
+uint8_t bamPlanes[2][BAM_SLOTS];            // bit n of plane k = bit k of LED n's duty
+uint8_t *bamShow = bamPlanes[0];            // planes isr() outputs
+volatile uint8_t *bamNext = 0;              // planes to take over at the next frame
+uint8_t bamPeriod = 0;                      // periodPlane[] entry showing (isr() only)
+
+void system_init()
+{
+    OSCCON=0x70;          // Select 8 Mhz internal clock
+
+	// I/O
+		// ANSELx registers
+			ANSEL = 0x00;         // Set PORT ANS0 to ANS7 as Digital I/O
+			ANSELH = 0x00;        // Set PORT ANS8 to ANS11 as Digital I/O
+
+		// TRISx registers (This register specifies the data direction of each pin)
+			TRISA = 0x00;         // Set All on PORTA as Output
+			TRISB = 0x00;         // Set All on PORTB as Output
+			TRISC = 0x00;         // Set All on PORTC as Output
+            TRISD = 0x00;         // Set All on PORTD as Output
+            TRISE = 0x00;         // Set All on PORTE as Output
+
+		// PORT registers
+			PORTA = 0x00;         // Set PORTA all 0
+			PORTB = 0x00;         // Set PORTB all 0
+			PORTC = 0x00;         // Set PORTC all 0
+            PORTD = 0x00;         // Set PORTD all 0
+            PORTE = 0x00;         // Set PORTE all 0
+
+	// Timer Setup - Timer 2 (see main_timer2.c), reloaded by isr() for every slot
+        TMR2 = 0;
+        PR2 = periodPr2[0];
+        PIR1bits.TMR2IF = 0;        // Clear the Timer 2 interrupt flag
+        PIE1bits.TMR2IE = 1;        // Enable the Timer 2 interrupt
+        T2CON = periodT2con[0];     // Prescaler 1:1, start
+
+	// Interrupt setup
+        INTCONbits.PEIE = 1;        // Timer 2 is a peripheral interrupt
+		INTCONbits.GIE = 1;         // Set the Global Interrupt Enable
+}
+
+/*
+ * The PIC16F887 can only have one Interrupt Service Routine.
+ * Compiler should know which function is the interrupt handler.
+ * This is done by declaring the function with 'interrupt' prefix:
+ */
+void interrupt isr()
+{
+    if(PIR1bits.TMR2IF)
+    {
+        uint8_t period;
+
+        PIR1bits.TMR2IF = 0;
+        // A period has just ended; TMR2 is already timing the next one
+        if(++bamPeriod == BAM_PERIODS)
+        {
+            bamPeriod = 0;
+            if(bamNext)
+            {
+                bamShow = (uint8_t *)bamNext;   // new duties from this frame on
+                bamNext = 0;
+            }
+        }
+        period = bamPeriod;
+        PR2 = periodPr2[period];            // first, before TMR2 can pass it
+        T2CON = periodT2con[period];        // also clears the (empty) postscaler count
+        PORTD = bamShow[periodPlane[period]];   // the only PORTD write of the period
+    }
+}
+
+// New brightness for the eight LEDs, 0 (off) .. 255 (255/256 on)
+void bam_set(const uint8_t *duty)
+{
+    uint8_t *back;
+    uint8_t k, n, mask, plane;
+
+    while(bamNext)
+        NOP();                              // the last update has not been taken yet
+    back = bamShow == bamPlanes[0] ? bamPlanes[1] : bamPlanes[0];
+
+    for(k = 0, mask = 0x01; k < BAM_SLOTS; k++, mask <<= 1)
+    {
+        plane = 0;
+        for(n = 0; n < 8; n++)
+            if(duty[n] & mask)
+                plane |= 1 << n;
+        back[k] = plane;
+    }
+    bamNext = back;                         // isr() switches at the next frame
+}
+
+void main(void)
+{
+    static const uint8_t comet[8] = { 255, 128, 64, 32, 16, 8, 4, 0 };
+    uint8_t duty[8];
+    uint8_t head = 0, n;
+
+    system_init();
+
+    while(1)
+    {
+        for(n = 0; n < 8; n++)
+            duty[(head + 8 - n) & 7] = comet[n];
+        bam_set(duty);
+
+        __delay_ms(COMET_STEP_MS);
+        head = (head + 1) & 7;
+    }
+
+  return;
+}
@@ -0,0 +1,164 @@
+/*
+ * File:   main_timer1_timestamp.c
+ *
+ * Timer 1 as a 32-bit timestamp counter
+ * Timer 1 runs free at Fcy (one count per instruction cycle) and is never
+ * reloaded; isr() counts its overflows, which make up the upper 16 bits.
+ * timestamp_now() reads both halves without races, from main() or isr(),
+ * so any piece of code can be timed to the instruction cycle:
+ *     uint32_t start = timestamp_now();
+ *     ...
+ *     cycles = timestamp_now() - start - timestampOverhead;
+ * At 8 MHz one count is 0.5us and the counter wraps after about 35 minutes;
+ * differences stay correct across the wrap.
+ * LED 0 toggles every 2^20 cycles (0.52 s) straight from the timestamp.
+ * LED 7 lights if timing __delay_us(100) does not give 200 cycles.
+ *
+ *  Board connection (PICKit 44-Pin Demo Board; PIC16F887):
+ *   PIN                	Module
+ * -------------------------------------------
+ *  RD0          			LED
+ *  RD7          			LED
+ *
+ */
+
+/* The __delay_ms() function is provided by XC8.
+It requires you define _XTAL_FREQ as the frequency of your system clock.
+The compiler then uses that value to calculate how many cycles are required to give the requested delay.
+There is also __delay_us() for microseconds and _delay() to delay for a specific number of clock cycles.
+Note that __delay_ms() and __delay_us() begin with a double underscore whereas _delay()
+begins with a single underscore.
+*/
+#define _XTAL_FREQ 8000000
+
+// PIC16F887 Configuration Bit Settings
+// 'C' source line config statements
+// CONFIG1
+#pragma config FOSC = INTRC_NOCLKOUT// Oscillator Selection bits (INTOSCIO oscillator: I/O function on RA6/OSC2/CLKOUT pin, I/O function on RA7/OSC1/CLKIN)
+#pragma config WDTE = OFF       // Watchdog Timer Enable bit (WDT disabled and can be enabled by SWDTEN bit of the WDTCON register)
+#pragma config PWRTE = OFF      // Power-up Timer Enable bit (PWRT disabled)
+#pragma config MCLRE = ON       // RE3/MCLR pin function select bit (RE3/MCLR pin function is MCLR)
+#pragma config CP = OFF         // Code Protection bit (Program memory code protection is disabled)
+#pragma config CPD = OFF        // Data Code Protection bit (Data memory code protection is disabled)
+#pragma config BOREN = ON       // Brown Out Reset Selection bits (BOR enabled)
+#pragma config IESO = ON        // Internal External Switchover bit (Internal/External Switchover mode is enabled)
+#pragma config FCMEN = ON       // Fail-Safe Clock Monitor Enabled bit (Fail-Safe Clock Monitor is enabled)
+#pragma config LVP = OFF        // Low Voltage Programming Enable bit (RB3 pin has digital I/O, HV on MCLR must be used for programming)
+
+// CONFIG2
+#pragma config BOR4V = BOR40V   // Brown-out Reset Selection bit (Brown-out Reset set to 4.0V)
+#pragma config WRT = OFF        // Flash Program Memory Self Write Enable bits (Write protection off)
+
+#include <xc.h>
+#include <stdint.h>
+
+#define DELAY_TEST_US             100
+#define DELAY_TEST_CYCLES         (DELAY_TEST_US * (_XTAL_FREQ / 4000000))
+
+volatile uint16_t tmr1Overflows = 0;        // upper 16 bits of the timestamp
+uint16_t timestampOverhead;                 // cycles of a timestamp_now() call itself
+
+void system_init()
+{
+    OSCCON=0x70;          // Select 8 Mhz internal clock
+
+	// I/O
+		// ANSELx registers
+			ANSEL = 0x00;         // Set PORT ANS0 to ANS7 as Digital I/O
+			ANSELH = 0x00;        // Set PORT ANS8 to ANS11 as Digital I/O
+
+		// TRISx registers (This register specifies the data direction of each pin)
+			TRISA = 0x00;         // Set All on PORTA as Output
+			TRISB = 0x00;         // Set All on PORTB as Output
+			TRISC = 0x00;         // Set All on PORTC as Output
+            TRISD = 0x00;         // Set All on PORTD as Output
+            TRISE = 0x00;         // Set All on PORTE as Output
+
+		// PORT registers (hold the current digital state of the digital I/O)
+			PORTA = 0x00;         // Set PORTA all 0
+			PORTB = 0x00;         // Set PORTB all 0
+			PORTC = 0x00;         // Set PORTC all 0
+            PORTD = 0x00;         // Set PORTD all 0
+            PORTE = 0x00;         // Set PORTE all 0
+
+	// Timer Setup - Timer 1 (see main_timer1.c for T1CON)
+		TMR1 = 0;                   // Start with zero Counter
+        T1CON = 0b00000001;         // Internal Clock (Fosc/4), Prescaler: 1:1, Timer1=On
+
+	// Interrupt setup
+        PIR1bits.TMR1IF = 0;        // Clear the Timer 1 interrupt flag
+        PIE1bits.TMR1IE = 1;        // Enable the Timer 1 interrupt
+        INTCONbits.PEIE = 1;        // Timer 1 is a peripheral interrupt
+		INTCONbits.GIE = 1;         // Set the Global Interrupt Enable
+}
+
+/*
+ * The PIC16F887 can only have one Interrupt Service Routine.
+ * Compiler should know which function is the interrupt handler.
+ * This is done by declaring the function with 'interrupt' prefix:
+ */
+void interrupt isr()
+{
+    if(PIR1bits.TMR1IF)
+    {
+        PIR1bits.TMR1IF = 0;        // Clear the Timer 1 interrupt flag
+        tmr1Overflows++;            // Timer 1 is not reloaded, it just keeps counting
+    }
+}
+
+/*
+ * Read the 32-bit timestamp: tmr1Overflows:TMR1H:TMR1L.
+ * Three things can change while it is being read, each is caught:
+ *   - TMR1L overflows into TMR1H between reading the two: TMR1H is read
+ *     again and everything is retried if it moved.
+ *   - isr() counts an overflow while the bytes are being read (the 16-bit
+ *     counter itself takes two reads): tmr1Overflows is compared before
+ *     and after, and everything is retried if it moved.
+ *   - TMR1 has overflowed but isr() has not run yet (interrupts are off,
+ *     or this is called from isr()): TMR1IF is still set, so the count is
+ *     one short when TMR1 has wrapped to a small value.
+ */
+uint32_t timestamp_now()
+{
+    uint16_t overflows;
+    uint8_t high, low, pending;
+
+    do
+    {
+        overflows = tmr1Overflows;
+        high = TMR1H;
+        low = TMR1L;
+        pending = PIR1bits.TMR1IF;
+    } while(high != TMR1H || overflows != tmr1Overflows);
+
+    if(pending && !(high & 0x80))
+        overflows++;                // wrapped, not counted yet
+
+    return ((uint32_t)overflows << 16) | ((uint16_t)high << 8) | low;
+}
+
+void main(void)
+{
+    uint32_t start;
+    uint32_t cycles;
+
+    system_init();
+
+    // What two back-to-back calls measure is the cost of the call itself
+    start = timestamp_now();
+    timestampOverhead = (uint16_t)(timestamp_now() - start);
+
+    // Check: __delay_us(100) takes 200 instruction cycles at 8 MHz
+    start = timestamp_now();
+    __delay_us(DELAY_TEST_US);
+    cycles = timestamp_now() - start - timestampOverhead;
+    PORTDbits.RD7 = cycles < DELAY_TEST_CYCLES - 1 || cycles > DELAY_TEST_CYCLES + 1;
+
+    while(1)
+    {
+        PORTDbits.RD0 = (timestamp_now() >> 20) & 1;     // 2^20 cycles = 0.52 s
+        __delay_ms(10);
+    }
+
+  return;
+}
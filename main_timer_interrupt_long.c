@@ -43,17 +43,18 @@ begins with a single underscore.
 
 #include <xc.h>
 
-#define TIMER_RESET_VALUE 240 // To set up the timer for a period of 1 ms (timerPeriod)
+#define TIMER_RESET_VALUE 194 // To set up the timer for a period of 1.024 ms (timerPeriod)
                             // Calculated by the formula:
                             // TMR0 = 256 - ((timerPeriod * Fosc) / (4 * prescaler)) + x
                             // TMR1 = 65536 - ((timerPeriod * Fosc) / (4 * prescaler)) + x
 
-                            // In following case,   timerPeriod = 0.001s
+                            // In following case,   timerPeriod = 0.001024s
                             //                      Fosc = 250,000
-                            //                      prescaler = 4
-                            //                      x = 0 because prescaler is > 2
+                            //                      prescaler = 1 (not assigned to Timer 0)
+                            //                      x = 2 because a write to TMR0 stops it for 2 cycles
 
-                            // TMR0 = 256 - (0.001 * 250000) / (4 * 4) = 240
+                            // TMR0 = 256 - (0.001024 * 250000) / (4 * 1) + 2 = 194
+#define TICKS_5S          4883  // 5 s / 1.024 ms
 
 int delayTime = 0;          // store the time that has elapsed
 
@@ -118,10 +119,11 @@ void system_init()
      *  The timer expires when the TMR0 register rolls over. 
      *  The TMR0 register is an 8bit register, therefore it will roll over after 256 counts.
      *  Rollover Frequency = Fosc / (4 * prescaler * 256)
-     *  In following case it would be 0.95 Hz or 1.04 seconds per rollover.
+     *  Here the prescaler is left to the WDT, so TMR0 counts every 16 us and isr()
+     *  reloads it for 64 counts. With a prescaler every reload would also clear
+     *  the partial prescaler count, which no reload value can make up for.
     */
-		OPTION_REGbits.PSA = 0; 	// Prescaler assigned to Timer 0 
-        OPTION_REGbits.PS = 0b001;  // Set the prescaler to 1:4
+		OPTION_REGbits.PSA = 1; 	// Prescaler assigned to the WDT: Timer 0 counts every instruction cycle
 		OPTION_REGbits.T0CS = 0;    // Use the instruction clock (Fcy/4) as the timer clock. 
 									//   Other option is an external oscillator or clock on the T0CKI pin.
         INTCONbits.T0IE = 1;        // Enable the Timer 0 interrupt
@@ -141,9 +143,10 @@ void system_init()
 void interrupt isr()
 {
     INTCONbits.T0IF = 0;    // Clear the Timer 0 interrupt flag
-    TMR0 = TIMER_RESET_VALUE;   // Load the starting value back into the timer
+    TMR0 += TIMER_RESET_VALUE;  // Add, don't overwrite: keeps the counts made since the
+                                //   overflow while isr() was being entered
     
-    if(++delayTime >= 5000) // 5 seconds has elapsed
+    if(++delayTime >= TICKS_5S) // 5 seconds has elapsed
     {
         delayTime = 0;
         PORTDbits.RD3 = ~PORTDbits.RD3; // Toggle the LED
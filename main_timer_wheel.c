@@ -0,0 +1,304 @@
+/*
+ * File:   main_timer_wheel.c
+ *
+ * Software timers on a drift-free 1 ms Timer 0 tick
+ * Any number of independent one-shot or periodic timers (up to SWT_COUNT) run
+ * off a single hardware timer. They are kept in a hierarchical timer wheel,
+ * so arming or cancelling a timer takes the same few steps however many are
+ * running, and a tick only looks at the timers that are due.
+ * LED n toggles from its own periodic timer, from every 100 ms (LED 0) up to
+ * once a day (LED 7).
+ *
+ *  Board connection (PICKit 44-Pin Demo Board; PIC16F887):
+ *   PIN                	Module
+ * -------------------------------------------
+ *  RD0-RD7          		LED
+ *
+ */
+
+/* The __delay_ms() function is provided by XC8.
+It requires you define _XTAL_FREQ as the frequency of your system clock.
+The compiler then uses that value to calculate how many cycles are required to give the requested delay.
+There is also __delay_us() for microseconds and _delay() to delay for a specific number of clock cycles.
+Note that __delay_ms() and __delay_us() begin with a double underscore whereas _delay()
+begins with a single underscore.
+*/
+#define _XTAL_FREQ 1000000
+
+// PIC16F887 Configuration Bit Settings
+// 'C' source line config statements
+// CONFIG1
+#pragma config FOSC = INTRC_NOCLKOUT// Oscillator Selection bits (INTOSCIO oscillator: I/O function on RA6/OSC2/CLKOUT pin, I/O function on RA7/OSC1/CLKIN)
+#pragma config WDTE = OFF       // Watchdog Timer Enable bit (WDT disabled and can be enabled by SWDTEN bit of the WDTCON register)
+#pragma config PWRTE = OFF      // Power-up Timer Enable bit (PWRT disabled)
+#pragma config MCLRE = ON       // RE3/MCLR pin function select bit (RE3/MCLR pin function is MCLR)
+#pragma config CP = OFF         // Code Protection bit (Program memory code protection is disabled)
+#pragma config CPD = OFF        // Data Code Protection bit (Data memory code protection is disabled)
+#pragma config BOREN = ON       // Brown Out Reset Selection bits (BOR enabled)
+#pragma config IESO = ON        // Internal External Switchover bit (Internal/External Switchover mode is enabled)
+#pragma config FCMEN = ON       // Fail-Safe Clock Monitor Enabled bit (Fail-Safe Clock Monitor is enabled)
+#pragma config LVP = OFF        // Low Voltage Programming Enable bit (RB3 pin has digital I/O, HV on MCLR must be used for programming)
+
+// CONFIG2
+#pragma config BOR4V = BOR40V   // Brown-out Reset Selection bit (Brown-out Reset set to 4.0V)
+#pragma config WRT = OFF        // Flash Program Memory Self Write Enable bits (Write protection off)
+
+#include <xc.h>
+#include <stdint.h>
+
+// 1 ms tick without drift
+// Reloading TMR0 in isr() with '=' throws away the counts made between the
+// overflow and the reload, and that time depends on what the CPU was doing
+// when the interrupt came. Adding the reload value keeps them. Two more
+// things lose time on every TMR0 write: it clears the prescaler, and TMR0
+// does not count for the next 2 instruction cycles. Without the prescaler
+// (assigned to the WDT) the first goes away and the second is always exactly
+// 2 counts, which are added back. Then every tick is exactly
+// TICK_CYCLES instruction cycles, however late isr() gets to it.
+//   Fcy = 1 MHz / 4 = 250 kHz, 1 ms = 250 cycles (must be 256 or less)
+#define TICK_CYCLES               (_XTAL_FREQ / 4 / 1000)
+#define TMR0_WRITE_LOSS           2
+#define TMR0_RELOAD               (256 - TICK_CYCLES + TMR0_WRITE_LOSS)
+#if TICK_CYCLES > 256
+#error "1 ms is too long for Timer 0 without a prescaler at this _XTAL_FREQ"
+#endif
+
+volatile uint8_t tickCount = 0;             // 1 ms ticks, counted by isr()
+
+// Timer wheel
+// Timer i expires at swtExpires[i] (in ticks). It sits in one of the lists
+// below, chosen by how far away that is:
+//   level 0: due within 16 ticks, one list per tick
+//   level 1: within 256 ticks, one list per 16 ticks
+//   level 2: within 4096 ticks, one list per 256 ticks
+//   level 3: within 65536 ticks, one list per 4096 ticks
+//   far list: anything later
+// Every 16 ticks the next level 1 list is due and its timers are moved down
+// to level 0 (and so on for the higher levels), so a timer is moved at most
+// once per level on its way down. The lists are doubly linked by timer
+// number, which lets a timer be taken out without searching.
+//
+// Each timer costs 13 bytes of RAM (expiry and period 4 each, callback 2,
+// list links and list number 3) and the list heads 65 more. The PIC16F887
+// has 368 bytes: 16 timers take 273 of them, leaving about 95 for the rest
+// of the sketch, and 16 x 4 bytes of swtExpires[] still fit in one bank
+// (80 bytes in banks 1 to 3). Dozens of timers do not fit; 16 is the most
+// that leaves the sketch room to work.
+#define SWT_COUNT                 16        // timers available
+#define SWT_NONE                  0xFF
+#define WHEEL_BITS                4
+#define WHEEL_SLOTS               (1 << WHEEL_BITS)
+#define WHEEL_LEVELS              4
+#define WHEEL_FAR                 (WHEEL_LEVELS * WHEEL_SLOTS)  // list number of the far list
+
+typedef void (*swt_callback_t)(uint8_t id);
+
+// One array per field keeps each of them inside one RAM bank
+uint32_t swtExpires[SWT_COUNT];
+uint32_t swtPeriod[SWT_COUNT];              // 0 = one-shot
+swt_callback_t swtCallback[SWT_COUNT];
+uint8_t swtNext[SWT_COUNT];
+uint8_t swtPrev[SWT_COUNT];
+uint8_t swtList[SWT_COUNT];                 // list the timer is in, SWT_NONE if not armed
+uint8_t wheelHead[WHEEL_FAR + 1];           // first timer of each list
+uint32_t wheelNow = 0;                      // next tick to process
+
+void wheel_insert(uint8_t id)
+{
+    uint32_t expires = swtExpires[id];
+    uint32_t delta = expires - wheelNow;
+    uint8_t list;
+
+    if(delta >= 0x80000000UL)
+        delta = 0;                          // already due, run on the next tick
+    if(delta == 0)
+        expires = wheelNow;
+
+    if(delta < 0x10UL)
+        list = (uint8_t)(expires & 0x0F);
+    else if(delta < 0x100UL)
+        list = WHEEL_SLOTS + (uint8_t)((expires >> 4) & 0x0F);
+    else if(delta < 0x1000UL)
+        list = 2 * WHEEL_SLOTS + (uint8_t)((expires >> 8) & 0x0F);
+    else if(delta < 0x10000UL)
+        list = 3 * WHEEL_SLOTS + (uint8_t)((expires >> 12) & 0x0F);
+    else
+        list = WHEEL_FAR;
+
+    swtList[id] = list;
+    swtPrev[id] = SWT_NONE;
+    swtNext[id] = wheelHead[list];
+    if(wheelHead[list] != SWT_NONE)
+        swtPrev[wheelHead[list]] = id;
+    wheelHead[list] = id;
+}
+
+void wheel_remove(uint8_t id)
+{
+    if(swtPrev[id] != SWT_NONE)
+        swtNext[swtPrev[id]] = swtNext[id];
+    else
+        wheelHead[swtList[id]] = swtNext[id];
+    if(swtNext[id] != SWT_NONE)
+        swtPrev[swtNext[id]] = swtPrev[id];
+    swtList[id] = SWT_NONE;
+}
+
+// Put every timer of a list back in, one level further down
+uint8_t wheel_cascade(uint8_t list)
+{
+    uint8_t id = wheelHead[list];
+
+    wheelHead[list] = SWT_NONE;
+    while(id != SWT_NONE)
+    {
+        uint8_t next = swtNext[id];
+
+        wheel_insert(id);
+        id = next;
+    }
+    return list & (WHEEL_SLOTS - 1);
+}
+
+void swt_init()
+{
+    uint8_t i;
+
+    for(i = 0; i <= WHEEL_FAR; i++)
+        wheelHead[i] = SWT_NONE;
+    for(i = 0; i < SWT_COUNT; i++)
+        swtList[i] = SWT_NONE;
+}
+
+// Start timer 'id': callback(id) runs 'delay' ms from now, then every 'period'
+// ms after that (period 0 = only once). Re-arming a running timer restarts it.
+// A delay of 0 counts as 1: from a callback, 0 would put the timer back in
+// the list swt_tick() is working through, and it would run again forever.
+void swt_arm(uint8_t id, uint32_t delay, uint32_t period, swt_callback_t callback)
+{
+    if(delay == 0)
+        delay = 1;
+    if(swtList[id] != SWT_NONE)
+        wheel_remove(id);
+    swtExpires[id] = wheelNow + delay;
+    swtPeriod[id] = period;
+    swtCallback[id] = callback;
+    wheel_insert(id);
+}
+
+void swt_cancel(uint8_t id)
+{
+    if(swtList[id] != SWT_NONE)
+        wheel_remove(id);
+}
+
+// Process one tick: bring down the higher levels when their time has come,
+// then run every timer due now. Callbacks may arm or cancel any timer.
+void swt_tick()
+{
+    uint8_t slot = (uint8_t)(wheelNow & 0x0F);
+    uint8_t id;
+
+    if(slot == 0
+       && wheel_cascade(WHEEL_SLOTS + (uint8_t)((wheelNow >> 4) & 0x0F)) == 0
+       && wheel_cascade(2 * WHEEL_SLOTS + (uint8_t)((wheelNow >> 8) & 0x0F)) == 0
+       && wheel_cascade(3 * WHEEL_SLOTS + (uint8_t)((wheelNow >> 12) & 0x0F)) == 0)
+        wheel_cascade(WHEEL_FAR);
+
+    while((id = wheelHead[slot]) != SWT_NONE)
+    {
+        wheel_remove(id);
+        if(swtPeriod[id])
+        {
+            swtExpires[id] += swtPeriod[id];        // from when it was due, not from now
+            wheel_insert(id);
+        }
+        swtCallback[id](id);
+    }
+    wheelNow++;
+}
+
+void system_init()
+{
+    OSCCONbits.IRCF = 0b100;       // Select 1 MHz internal clock
+
+	// I/O
+		// ANSELx registers
+			ANSEL = 0x00;         // Set PORT ANS0 to ANS7 as Digital I/O
+			ANSELH = 0x00;        // Set PORT ANS8 to ANS11 as Digital I/O
+
+		// TRISx registers (This register specifies the data direction of each pin)
+			TRISA = 0x00;         // Set All on PORTA as Output
+			TRISB = 0x00;         // Set All on PORTB as Output
+			TRISC = 0x00;         // Set All on PORTC as Output
+            TRISD = 0x00;         // Set All on PORTD as Output
+            TRISE = 0x00;         // Set All on PORTE as Output
+
+		// PORT registers (hold the current digital state of the digital I/O)
+			PORTA = 0x00;         // Set PORTA all 0
+			PORTB = 0x00;         // Set PORTB all 0
+			PORTC = 0x00;         // Set PORTC all 0
+            PORTD = 0x00;         // Set PORTD all 0
+            PORTE = 0x00;         // Set PORTE all 0
+
+	// Timer Setup - Timer 0 (see main_timer_interrupt_long.c)
+		OPTION_REGbits.PSA = 1; 	// Prescaler assigned to the WDT: Timer 0 counts every instruction cycle
+		OPTION_REGbits.T0CS = 0;    // Use the instruction clock (Fcy) as the timer clock.
+		INTCONbits.T0IF = 0;        // Clear the Timer 0 interrupt flag
+		TMR0 = TMR0_RELOAD;         // First tick
+
+	// Interrupt setup
+		INTCONbits.T0IE = 1;        // Enable the Timer 0 interrupt
+		INTCONbits.GIE = 1;         // Set the Global Interrupt Enable
+}
+
+/*
+ * The PIC16F887 can only have one Interrupt Service Routine.
+ * Compiler should know which function is the interrupt handler.
+ * This is done by declaring the function with 'interrupt' prefix:
+ */
+void interrupt isr()
+{
+    if(INTCONbits.T0IF)
+    {
+        INTCONbits.T0IF = 0;        // Clear the Timer 0 interrupt flag
+        TMR0 += TMR0_RELOAD;        // Add, don't overwrite (see TMR0_RELOAD)
+        tickCount++;
+    }
+}
+
+void toggle_led(uint8_t id)
+{
+    PORTD ^= 1 << id;               // timer n toggles LED n
+}
+
+void main(void)
+{
+    uint8_t lastTick;
+
+    system_init();
+    swt_init();
+
+    swt_arm(0, 100, 100, toggle_led);                   // 100 ms
+    swt_arm(1, 250, 250, toggle_led);                   // 250 ms
+    swt_arm(2, 500, 500, toggle_led);                   // 0.5 s
+    swt_arm(3, 1000, 1000, toggle_led);                 // 1 s
+    swt_arm(4, 5000, 5000, toggle_led);                 // 5 s
+    swt_arm(5, 60000UL, 60000UL, toggle_led);           // 1 minute
+    swt_arm(6, 3600000UL, 3600000UL, toggle_led);       // 1 hour
+    swt_arm(7, 86400000UL, 86400000UL, toggle_led);     // 1 day
+
+    lastTick = tickCount;
+    while(1)
+    {
+        while(tickCount == lastTick)
+            NOP();                                      // idle until the next tick
+        while(lastTick != tickCount)                    // catch up if a tick was missed
+        {
+            lastTick++;
+            swt_tick();
+        }
+    }
+
+  return;
+}
@@ -0,0 +1,280 @@
+/*
+ * File:   main_trace.c
+ *
+ * Trace points (trace.h) on a small interrupt driven application
+ * The scheduler of main_scheduler.c runs three tasks on a 1 ms Timer 0
+ * tick; the ADC converts in the background and hands its result over in
+ * isr(). Interrupt entry/exit, ADC start/complete, every task run and
+ * every SW1 edge leave a record with its Timer 1 timestamp (see
+ * main_timer1_timestamp.c) in traceBuf, so the last TRACE_SIZE events can
+ * be read back after the fact:
+ *     sim/build/main_trace -t 2 -s 1.5:B=0 -d traceBuf=trace.bin
+ *     sim/build/trace_decode trace.bin
+ * Set TRACE_ENABLE (or one of the groups) to 0 below and the trace points
+ * compile to nothing. With TRACE_ISR on, the 1 ms tick fills most of the
+ * ring; turn it off to keep a longer history of the rest.
+ *
+ *  Board connection (PICKit 44-Pin Demo Board; PIC16F887):
+ *   PIN                	Module
+ * -------------------------------------------
+ *  RD0          			LED (blinks, 0.5 s)
+ *  RD1          			LED (on while SW1 is pressed)
+ *  RD4-RD6          		LED (potentiometer level)
+ *  RA0 (RP1)               POTENCIOMETER
+ *  RB0 (SW1)               BUTTON
+ *
+ */
+
+
+/* The __delay_ms() function is provided by XC8.
+It requires you define _XTAL_FREQ as the frequency of your system clock.
+The compiler then uses that value to calculate how many cycles are required to give the requested delay.
+There is also __delay_us() for microseconds and _delay() to delay for a specific number of clock cycles.
+Note that __delay_ms() and __delay_us() begin with a double underscore whereas _delay()
+begins with a single underscore.
+*/
+#define _XTAL_FREQ 8000000
+
+// PIC16F887 Configuration Bit Settings
+// 'C' source line config statements
+// CONFIG1
+#pragma config FOSC = INTRC_NOCLKOUT// Oscillator Selection bits (INTOSCIO oscillator: I/O function on RA6/OSC2/CLKOUT pin, I/O function on RA7/OSC1/CLKIN)
+#pragma config WDTE = OFF       // Watchdog Timer Enable bit (WDT disabled and can be enabled by SWDTEN bit of the WDTCON register)
+#pragma config PWRTE = OFF      // Power-up Timer Enable bit (PWRT disabled)
+#pragma config MCLRE = ON       // RE3/MCLR pin function select bit (RE3/MCLR pin function is MCLR)
+#pragma config CP = OFF         // Code Protection bit (Program memory code protection is disabled)
+#pragma config CPD = OFF        // Data Code Protection bit (Data memory code protection is disabled)
+#pragma config BOREN = ON       // Brown Out Reset Selection bits (BOR enabled)
+#pragma config IESO = ON        // Internal External Switchover bit (Internal/External Switchover mode is enabled)
+#pragma config FCMEN = ON       // Fail-Safe Clock Monitor Enabled bit (Fail-Safe Clock Monitor is enabled)
+#pragma config LVP = OFF        // Low Voltage Programming Enable bit (RB3 pin has digital I/O, HV on MCLR must be used for programming)
+
+// CONFIG2
+#pragma config BOR4V = BOR40V   // Brown-out Reset Selection bit (Brown-out Reset set to 4.0V)
+#pragma config WRT = OFF        // Flash Program Memory Self Write Enable bits (Write protection off)
+
+#include <xc.h>
+#include <stdint.h>
+
+// Trace switches, see trace.h
+#define TRACE_IMPL                  // traceBuf lives in this file
+#define TRACE_ENABLE      1
+#define TRACE_ISR         1
+#define TRACE_ADC         1
+#define TRACE_TASK        1
+#define TRACE_BUTTON      1
+#include "trace.h"
+
+#define TIMER_RESET_VALUE 6   // 1 ms tick: TMR0 = 256 - (0.001 * 8000000) / (4 * 8) = 6
+
+// isr() sources, the argument of TRACE_ISR_ENTER
+#define SRC_TIMER0        0x01
+#define SRC_TIMER1        0x02
+#define SRC_ADC           0x04
+
+volatile uint8_t tickCount = 0;                 // 1 ms ticks, counted by isr()
+volatile uint16_t tmr1Overflows = 0;            // upper 16 bits of the timestamp
+volatile uint8_t adcResult;                     // ADRESH of the last conversion
+volatile uint8_t adcReady = 0;                  // adcResult is new
+
+// Tasks
+void task_blink(void);
+void task_button(void);
+void task_adc(void);
+
+typedef struct
+{
+    void (*run)(void);
+    uint16_t period;              // ticks (ms) between two runs
+    uint16_t countdown;           // ticks until the next run
+} task_t;
+
+task_t tasks[] = {
+    { task_blink,  500, 1 },
+    { task_button,  10, 2 },
+    { task_adc,     20, 3 },
+};
+#define TASK_COUNT        (sizeof(tasks) / sizeof(tasks[0]))
+
+void system_init()
+{
+    OSCCON=0x70;          // Select 8 Mhz internal clock
+
+	// I/O
+		// ANSELx registers
+			ANSEL = 0x00;         // Set PORT ANS0 to ANS7 as Digital I/O
+			ANSELH = 0x00;        // Set PORT ANS8 to ANS11 as Digital I/O
+			ANSELbits.ANS0 = 1;   // Set RA0/AN0 to analog mode
+
+		// TRISx registers (This register specifies the data direction of each pin)
+			TRISA = 0x01;         // Set All on PORTA as Output, and AN0 as Input
+			TRISB = 0x01;         // Set All on PORTB as Output, and B0 (SW1) as Input
+			TRISC = 0x00;         // Set All on PORTC as Output
+            TRISD = 0x00;         // Set All on PORTD as Output
+            TRISE = 0x00;         // Set All on PORTE as Output
+
+		// PORT registers (hold the current digital state of the digital I/O)
+			PORTA = 0x00;         // Set PORTA all 0
+			PORTB = 0x00;         // Set PORTB all 0
+			PORTC = 0x00;         // Set PORTC all 0
+            PORTD = 0x00;         // Set PORTD all 0
+            PORTE = 0x00;         // Set PORTE all 0
+
+    // ADC setup (see main_adc.c)
+        ADCON1bits.ADFM = 0;   		// ADC result is left justified, ADRESH is enough here
+        ADCON0bits.ADCS = 0b10;     // Fosc/32 is the conversion clock (Tad = 4us at 8MHz)
+        ADCON0bits.CHS = 0;         // Select analog input - AN0
+        ADCON0bits.ADON = 1;    	// Turn on the ADC
+
+	// Timer Setup - Timer 0 (see main_timer_interrupt_long.c)
+		OPTION_REGbits.PSA = 0; 	// Prescaler assigned to Timer 0
+        OPTION_REGbits.PS = 0b010;  // Set the prescaler to 1:8
+		OPTION_REGbits.T0CS = 0;    // Use the instruction clock (Fcy/4) as the timer clock.
+		INTCONbits.T0IF = 0;        // Clear the Timer 0 interrupt flag
+		TMR0 = TIMER_RESET_VALUE;   // Load the starting value back into the timer
+
+	// Timer Setup - Timer 1 (see main_timer1_timestamp.c)
+		TMR1 = 0;                   // Start with zero Counter
+        T1CON = 0b00000001;         // Internal Clock (Fosc/4), Prescaler: 1:1, Timer1=On
+
+	// Interrupt setup
+        PIR1bits.TMR1IF = 0;        // Clear the Timer 1 interrupt flag
+        PIE1bits.TMR1IE = 1;        // Enable the Timer 1 interrupt
+        PIR1bits.ADIF = 0;          // Clear the ADC interrupt flag
+        PIE1bits.ADIE = 1;          // Enable the ADC interrupt
+        INTCONbits.PEIE = 1;        // Timer 1 and the ADC are peripheral interrupts
+		INTCONbits.T0IE = 1;        // Enable the Timer 0 interrupt
+		INTCONbits.GIE = 1;         // Set the Global Interrupt Enable
+}
+
+/*
+ * The PIC16F887 can only have one Interrupt Service Routine.
+ * Compiler should know which function is the interrupt handler.
+ * This is done by declaring the function with 'interrupt' prefix:
+ */
+void interrupt isr()
+{
+    uint8_t sources = 0;
+
+    if(INTCONbits.T0IF)
+        sources |= SRC_TIMER0;
+    if(PIR1bits.TMR1IF)
+        sources |= SRC_TIMER1;
+    if(PIR1bits.ADIF)
+        sources |= SRC_ADC;
+    TRACE_ISR_POINT(TRACE_ISR_ENTER, sources);
+
+    if(sources & SRC_TIMER0)
+    {
+        INTCONbits.T0IF = 0;        // Clear the Timer 0 interrupt flag
+        TMR0 += TIMER_RESET_VALUE;  // Add, don't overwrite (see main_scheduler.c)
+        tickCount++;
+    }
+    if(sources & SRC_TIMER1)
+    {
+        PIR1bits.TMR1IF = 0;        // Clear the Timer 1 interrupt flag
+        tmr1Overflows++;
+    }
+    if(sources & SRC_ADC)
+    {
+        PIR1bits.ADIF = 0;          // Clear the ADC interrupt flag
+        adcResult = ADRESH;
+        adcReady = 1;
+        TRACE_ADC_POINT(TRACE_ADC_DONE, adcResult);
+    }
+
+    TRACE_ISR_POINT(TRACE_ISR_EXIT, sources);
+}
+
+// The 32-bit timestamp of main_timer1_timestamp.c, which trace.h records
+uint32_t timestamp_now()
+{
+    uint16_t overflows;
+    uint8_t high, low, pending;
+
+    do
+    {
+        overflows = tmr1Overflows;
+        high = TMR1H;
+        low = TMR1L;
+        pending = PIR1bits.TMR1IF;
+    } while(high != TMR1H || overflows != tmr1Overflows);
+
+    if(pending && !(high & 0x80))
+        overflows++;                // wrapped, not counted yet
+
+    return ((uint32_t)overflows << 16) | ((uint16_t)high << 8) | low;
+}
+
+void task_blink()
+{
+    PORTDbits.RD0 = ~PORTDbits.RD0; // Toggle the LED
+}
+
+void task_button()
+{
+    static uint8_t pressed = 0;
+    uint8_t now = PORTBbits.RB0 == 0;               // RB0 == 0V (pressed)
+
+    if(now != pressed)
+    {
+        pressed = now;
+        PORTDbits.RD1 = now;
+        TRACE_BUTTON_POINT(TRACE_BUTTON_EDGE, now);
+    }
+}
+
+// Shows the result isr() delivered and starts the next conversion; the
+// 20 ms in between are a long enough acquisition time.
+void task_adc()
+{
+    if(adcReady)
+    {
+        adcReady = 0;
+        PORTD = (PORTD & 0x8F) | ((adcResult >> 1) & 0x70);   // top 3 bits on RD4-RD6
+    }
+    if(!ADCON0bits.GO_nDONE)
+    {
+        TRACE_ADC_POINT(TRACE_ADC_START, ADCON0bits.CHS);
+        ADCON0bits.GO_nDONE = 1;                    // Start the next conversion
+    }
+}
+
+void main(void)
+{
+    uint8_t lastTick;
+
+    system_init();
+
+    lastTick = tickCount;
+    while(1)
+    {
+        uint8_t elapsed;
+        uint8_t i;
+
+        while(tickCount == lastTick)
+            NOP();                                  // idle until the next tick
+        elapsed = tickCount - lastTick;
+        lastTick += elapsed;
+
+        for(i = 0; i < TASK_COUNT; i++)
+        {
+            task_t *task = &tasks[i];
+
+            if(task->countdown > elapsed)
+            {
+                task->countdown -= elapsed;
+                continue;
+            }
+            task->countdown += task->period - elapsed;
+            while(task->countdown == 0 || task->countdown > task->period)
+                task->countdown += task->period;    // missed a whole period
+
+            TRACE_TASK_POINT(TRACE_TASK_RUN, i);
+            task->run();
+            TRACE_TASK_POINT(TRACE_TASK_END, i);
+        }
+    }
+
+  return;
+}
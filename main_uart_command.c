@@ -0,0 +1,537 @@
+/*
+ * File:   main_uart_command.c
+ *
+ * Live reconfiguration over the EUSART
+ * Commands arrive on RX (RC7) as binary frames and change the PWM
+ * frequency and duty cycle, the LED mode and its period, and ADC
+ * streaming, or ask for the counters, without reflashing. The receive
+ * interrupt parses the frame byte by byte as it comes in and checks its
+ * CRC, so when the last byte arrives the command is already complete:
+ * main() only has to carry it out and reply. The time from the last byte
+ * until main() has carried the command out (PWM: handed it to the next
+ * period start) is measured with Timer 1 and reported by the COUNTERS
+ * reply, in instruction cycles on the chip. The simulator only charges
+ * cycles for SFR accesses, so there the figure is SFR cycles, a lower
+ * bound rather than a measured latency.
+ * Replies and ADC samples go out on TX (RC6) through the transmit ring
+ * buffer of uart_tx.h.
+ *
+ * Frame (both ways): 0xA5 | type | length | payload | CRC-8
+ *   CRC-8: polynomial 0x07, initial value 0, over type, length and payload
+ * Commands:
+ *   0x10 PWM       PR2, prescaler as its T2CKPS code (0: 1:1, 1: 1:4,
+ *                  2: 1:16, anything else is refused), duty (16 bit, 0..1023)
+ *   0x11 LED       mode (0 off, 1 blink, 2 rotate, 3 ADC bar), period in ms (16 bit)
+ *   0x12 STREAM    on, ADC channel (0..3), period in ms (16 bit)
+ *   0x13 COUNTERS  no payload
+ * Replies: type 0x80 | command with one status byte (0 ok, 1 bad length,
+ * 2 bad value, 3 unknown command); COUNTERS answers with
+ *   frames received, frames refused (16 bit each), receive overruns,
+ *   commands dropped, frames sent, frames dropped (16 bit each),
+ *   longest command latency in Timer 1 cycles (16 bit, SFR cycles in the simulator)
+ * Samples while streaming: type 0x01, seq, ADC low, ADC high, LEDs
+ * Multi-byte values are little endian. sim/build/uart_cmd builds command
+ * frames (it takes the prescaler as 1, 4 or 16 and sends the T2CKPS code)
+ * and sim/build/telemetry_read shows what comes back:
+ *     sim/build/uart_cmd pwm 124 4 256 led 2 100 counters > cmds.bin
+ *     sim/build/main_uart_command -t 2 -r 0.5:cmds.bin -u uart.bin
+ *     sim/build/telemetry_read uart.bin
+ *
+ *  Board connection (PICKit 44-Pin Demo Board; PIC16F887):
+ *   PIN                	Module
+ * -------------------------------------------
+ *  RD0-RD3          		LED (LED mode)
+ *  RD7 (P1D)          		LED (PWM)
+ *  RA0 (RP1)               POTENCIOMETER
+ *  RA1, RA2, RA3           analog inputs on the header
+ *  RC6 (TX)                serial adapter RX, 57600 8N1
+ *  RC7 (RX)                serial adapter TX
+ *
+ */
+
+
+/* The __delay_ms() function is provided by XC8.
+It requires you define _XTAL_FREQ as the frequency of your system clock.
+The compiler then uses that value to calculate how many cycles are required to give the requested delay.
+There is also __delay_us() for microseconds and _delay() to delay for a specific number of clock cycles.
+Note that __delay_ms() and __delay_us() begin with a double underscore whereas _delay()
+begins with a single underscore.
+*/
+#define _XTAL_FREQ 8000000
+
+// PIC16F887 Configuration Bit Settings
+// 'C' source line config statements
+// CONFIG1
+#pragma config FOSC = INTRC_NOCLKOUT// Oscillator Selection bits (INTOSCIO oscillator: I/O function on RA6/OSC2/CLKOUT pin, I/O function on RA7/OSC1/CLKIN)
+#pragma config WDTE = OFF       // Watchdog Timer Enable bit (WDT disabled and can be enabled by SWDTEN bit of the WDTCON register)
+#pragma config PWRTE = OFF      // Power-up Timer Enable bit (PWRT disabled)
+#pragma config MCLRE = ON       // RE3/MCLR pin function select bit (RE3/MCLR pin function is MCLR)
+#pragma config CP = OFF         // Code Protection bit (Program memory code protection is disabled)
+#pragma config CPD = OFF        // Data Code Protection bit (Data memory code protection is disabled)
+#pragma config BOREN = ON       // Brown Out Reset Selection bits (BOR enabled)
+#pragma config IESO = ON        // Internal External Switchover bit (Internal/External Switchover mode is enabled)
+#pragma config FCMEN = ON       // Fail-Safe Clock Monitor Enabled bit (Fail-Safe Clock Monitor is enabled)
+#pragma config LVP = OFF        // Low Voltage Programming Enable bit (RB3 pin has digital I/O, HV on MCLR must be used for programming)
+
+// CONFIG2
+#pragma config BOR4V = BOR40V   // Brown-out Reset Selection bit (Brown-out Reset set to 4.0V)
+#pragma config WRT = OFF        // Flash Program Memory Self Write Enable bits (Write protection off)
+
+#include <xc.h>
+#include <stdint.h>
+
+#define TIMER_RESET_VALUE         6         // 1 ms tick: TMR0 = 256 - (0.001 * 8000000) / (4 * 8) = 6
+
+// EUSART: BRG16 = 1 and BRGH = 1, so baud = Fosc / (4 * (SPBRGH:SPBRG + 1))
+#define UART_BAUD                 57600
+#define UART_BRG                  ((_XTAL_FREQ / 4 + UART_BAUD / 2) / UART_BAUD - 1)
+#define UART_ACTUAL               (_XTAL_FREQ / 4 / (UART_BRG + 1))
+#define UART_ERROR_PERMILLE       ((UART_ACTUAL > UART_BAUD ? UART_ACTUAL - UART_BAUD : UART_BAUD - UART_ACTUAL) * 1000 / UART_BAUD)
+#if UART_ERROR_PERMILLE > 20
+#error "UART_BAUD is more than 2% off with this _XTAL_FREQ"
+#endif
+
+// Frames (sync, overhead and CRC: see uart_tx.h)
+#define FRAME_SAMPLE              0x01
+#define FRAME_REPLY               0x80      // reply type: FRAME_REPLY | command
+#define CMD_PWM                   0x10
+#define CMD_LED                   0x11
+#define CMD_STREAM                0x12
+#define CMD_COUNTERS              0x13
+#define CMD_MAX_PAYLOAD           8
+
+#define STATUS_OK                 0
+#define STATUS_BAD_LENGTH         1
+#define STATUS_BAD_VALUE          2
+#define STATUS_UNKNOWN            3
+
+#define LED_OFF                   0
+#define LED_BLINK                 1
+#define LED_ROTATE                2
+#define LED_ADC_BAR               3
+
+// Receive parser states
+#define RX_SYNC                   0
+#define RX_TYPE                   1
+#define RX_LENGTH                 2
+#define RX_PAYLOAD                3
+#define RX_CRC                    4
+
+// Transmit ring buffer, power of two
+#define TX_BUFFER_SIZE            64
+#define UART_TX_IMPL                        // the ring buffer lives in this file
+#include "uart_tx.h"
+
+// Receive side, isr() only
+uint8_t rxState = RX_SYNC;
+uint8_t rxType, rxLength, rxCount, rxCrc;
+uint8_t rxPayload[CMD_MAX_PAYLOAD];
+uint16_t rxFrames = 0;                      // frames with a good CRC
+uint16_t rxErrors = 0;                      // frames refused (CRC, length)
+uint8_t rxOverruns = 0;
+uint8_t cmdDropped = 0;                     // arrived before main() took the previous one
+
+// Command mailbox: isr() fills it and sets cmdReady, main() empties it
+volatile uint8_t cmdReady = 0;
+uint8_t cmdType, cmdLength;
+uint8_t cmdPayload[CMD_MAX_PAYLOAD];
+uint16_t cmdStamp;                          // Timer 1 when the last byte arrived
+uint16_t cmdLatencyMax = 0;                 // Timer 1 cycles from the last byte to done
+
+volatile uint8_t tickCount = 0;             // 1 ms ticks, counted by isr()
+volatile uint16_t adcSample;
+volatile uint8_t sampleSeq = 0;
+
+// PWM settings cmd_pwm() leaves for pwm_apply(), as they will be written
+volatile uint8_t pwmNextPr2, pwmNextT2con, pwmNextHigh, pwmNextCon;
+
+// What the commands change
+uint8_t ledMode = LED_BLINK;
+uint16_t ledPeriod = 500;                   // ms
+uint8_t streamOn = 0;
+uint16_t streamPeriod = 10;                 // ms
+
+void system_init()
+{
+    OSCCON=0x70;          // Select 8 Mhz internal clock
+
+	// I/O
+		// ANSELx registers
+			ANSEL = 0x0F;         // Set AN0 to AN3 (RA0-RA3) to analog mode, ANS4 to ANS7 Digital I/O
+			ANSELH = 0x00;        // Set PORT ANS8 to ANS11 as Digital I/O
+
+		// TRISx registers (This register specifies the data direction of each pin)
+			TRISA = 0x0F;         // Set All on PORTA as Output, and AN0 to AN3 as Input
+			TRISB = 0x00;         // Set All on PORTB as Output
+			TRISC = 0x80;         // Set All on PORTC as Output, and RC7 (RX) as Input
+            TRISD = 0x00;         // Set All on PORTD as Output
+            TRISE = 0x00;         // Set All on PORTE as Output
+
+		// PORT registers (hold the current digital state of the digital I/O)
+			PORTA = 0x00;         // Set PORTA all 0
+			PORTB = 0x00;         // Set PORTB all 0
+			PORTC = 0x00;         // Set PORTC all 0
+            PORTD = 0x00;         // Set PORTD all 0
+            PORTE = 0x00;         // Set PORTE all 0
+
+    // ADC setup (see main_adc.c)
+        ADCON1bits.ADFM = 1;   		// ADC result is right justified
+        ADCON0bits.ADCS = 0b10;     // Fosc/32 is the conversion clock (Tad = 4us at 8MHz)
+        ADCON0bits.CHS = 0;         // Select analog input - AN0
+        ADCON0bits.ADON = 1;    	// Turn on the ADC
+
+	// PWM setup (see main_pwm.c), on P1D (RD7)
+        PR2 = 0x65;                 // 4.90 kHz with the 1:4 prescaler
+        PSTRCON = 0b00001000;       // Enable Pulse Steering on P1D (RD7)
+        CCP1CONbits.P1M = 0b00;     // Single output mode
+        CCP1CONbits.DC1B = 0x00;    // Start with zero Duty Cycle (LSB)
+        CCP1CONbits.CCP1M = 0b1100; // ECCP Mode PWM P1A, P1C active-high; P1B, P1D active-high
+        CCPR1L = 0;                 // Start with zero Duty Cycle (MSB)
+		TMR2 = 0;                   // Start with zero Counter
+        T2CON = 0b00000101;         // Postscale: 1:1, Timer2=On, Prescale = 1:4
+
+	// Timer Setup - Timer 0 (see main_timer_interrupt_long.c)
+		OPTION_REGbits.PSA = 0; 	// Prescaler assigned to Timer 0
+        OPTION_REGbits.PS = 0b010;  // Set the prescaler to 1:8
+		OPTION_REGbits.T0CS = 0;    // Use the instruction clock (Fcy/4) as the timer clock.
+		INTCONbits.T0IF = 0;        // Clear the Timer 0 interrupt flag
+		TMR0 = TIMER_RESET_VALUE;   // Load the starting value back into the timer
+
+	// Timer Setup - Timer 1, free running at Fcy, only read to measure time
+        T1CON = 0b00000001;         // Internal Clock (Fosc/4), Prescaler: 1:1, Timer1=On
+
+	// EUSART setup (see main_uart_telemetry.c for the registers)
+        BAUDCTLbits.BRG16 = 1;      // 16-bit baud rate generator
+        SPBRGH = (uint8_t)(UART_BRG >> 8);
+        SPBRG = (uint8_t)UART_BRG;  // 57600 baud (57143, -0.8%, at 8MHz)
+        TXSTA = 0b00100100;         // TXEN = 1, SYNC = 0, BRGH = 1
+        RCSTA = 0b10010000;         // SPEN = 1, CREN = 1 (receive)
+
+	// Interrupt setup
+        PIE1bits.RCIE = 1;          // Enable the EUSART receive interrupt
+        PIR1bits.ADIF = 0;          // Clear the ADC interrupt flag
+        PIE1bits.ADIE = 1;          // Enable the ADC interrupt
+        INTCONbits.PEIE = 1;        // ADC, EUSART and Timer 2 (PWM commands) are peripheral interrupts
+		INTCONbits.T0IE = 1;        // Enable the Timer 0 interrupt
+		INTCONbits.GIE = 1;         // Set the Global Interrupt Enable
+}
+
+// Timer 1 can carry from TMR1L into TMR1H between the two reads;
+// read TMR1H again and retry if it changed.
+uint16_t timer1_read()
+{
+    uint8_t high, low;
+
+    do
+    {
+        high = TMR1H;
+        low = TMR1L;
+    } while(high != TMR1H);
+    return ((uint16_t)high << 8) | low;
+}
+
+// One received byte through the frame parser (isr() only)
+void rx_byte(uint8_t c)
+{
+    switch(rxState)
+    {
+    case RX_SYNC:
+        if(c == FRAME_SYNC)
+            rxState = RX_TYPE;
+        break;
+    case RX_TYPE:
+        rxType = c;
+        rxCrc = crc8(0, c);
+        rxState = RX_LENGTH;
+        break;
+    case RX_LENGTH:
+        rxLength = c;
+        rxCrc = crc8(rxCrc, c);
+        rxCount = 0;
+        if(c > CMD_MAX_PAYLOAD)
+        {
+            rxErrors++;                     // cannot be one of ours, look for the next sync
+            rxState = RX_SYNC;
+        }
+        else
+            rxState = c ? RX_PAYLOAD : RX_CRC;
+        break;
+    case RX_PAYLOAD:
+        rxPayload[rxCount++] = c;
+        rxCrc = crc8(rxCrc, c);
+        if(rxCount == rxLength)
+            rxState = RX_CRC;
+        break;
+    case RX_CRC:
+        rxState = RX_SYNC;
+        if(c != rxCrc)
+        {
+            rxErrors++;
+            break;
+        }
+        rxFrames++;
+        if(cmdReady)
+        {
+            cmdDropped++;                   // main() has not taken the last one yet
+            break;
+        }
+        cmdType = rxType;
+        cmdLength = rxLength;
+        for(rxCount = 0; rxCount < rxLength; rxCount++)
+            cmdPayload[rxCount] = rxPayload[rxCount];
+        cmdStamp = timer1_read();
+        cmdReady = 1;
+        break;
+    }
+}
+
+// From isr() on TMR2IF: a period has just started and latched the old
+// duty, so all of the new settings go in together before the next one
+// (see pwm.h, PWM_SYNC). A new prescaler already clocks the rest of this
+// period; the new duty and PR2 apply from the next period start.
+void pwm_apply()
+{
+    PIR1bits.TMR2IF = 0;
+    PR2 = pwmNextPr2;
+    T2CON = pwmNextT2con;
+    CCP1CON = pwmNextCon;
+    CCPR1L = pwmNextHigh;
+    PIE1bits.TMR2IE = 0;        // one update per cmd_pwm()
+}
+
+/*
+ * The PIC16F887 can only have one Interrupt Service Routine.
+ * Compiler should know which function is the interrupt handler.
+ * This is done by declaring the function with 'interrupt' prefix:
+ */
+void interrupt isr()
+{
+    if(PIR1bits.RCIF)
+    {
+        if(RCSTAbits.OERR)
+        {
+            RCSTAbits.CREN = 0;     // An overrun stops the receiver until CREN is cleared
+            RCSTAbits.CREN = 1;
+            rxOverruns++;
+            rxState = RX_SYNC;      // the frame in progress lost a byte
+        }
+        while(PIR1bits.RCIF)
+            rx_byte(RCREG);         // reading RCREG clears RCIF once the FIFO is empty
+    }
+    if(PIE1bits.TXIE && PIR1bits.TXIF)
+        uart_tx_isr();              // next byte of the ring buffer
+    if(PIE1bits.TMR2IE && PIR1bits.TMR2IF)
+        pwm_apply();                // a PWM command is waiting for the period start
+    if(INTCONbits.T0IF)
+    {
+        INTCONbits.T0IF = 0;        // Clear the Timer 0 interrupt flag
+        TMR0 += TIMER_RESET_VALUE;  // Add, don't overwrite (see main_scheduler.c)
+        tickCount++;
+    }
+    if(PIR1bits.ADIF)
+    {
+        PIR1bits.ADIF = 0;          // Clear the ADC interrupt flag
+        adcSample = (uint16_t)((ADRESH << 8) + ADRESL);
+        sampleSeq++;
+    }
+}
+
+// 16-bit reads are not atomic, so keep isr() out while copying
+uint16_t ADC_GetSample()
+{
+    uint16_t value;
+
+    PIE1bits.ADIE = 0;
+    value = adcSample;
+    PIE1bits.ADIE = 1;
+    return value;
+}
+
+uint8_t cmd_pwm()
+{
+    uint16_t duty = cmdPayload[2] | ((uint16_t)cmdPayload[3] << 8);
+
+    if(cmdLength != 4)
+        return STATUS_BAD_LENGTH;
+    if(cmdPayload[1] > 2 || duty > 1023)
+        return STATUS_BAD_VALUE;            // T2CKPS 0b11 would be 1:16 too, keep one code each
+
+    // Written to the module by pwm_apply() at the next period start, so
+    // no period runs with half of the new settings
+    PIE1bits.TMR2IE = 0;                    // pwm_apply() must not see half of it
+    pwmNextPr2 = cmdPayload[0];
+    pwmNextT2con = 0b00000100 | cmdPayload[1];      // Postscale: 1:1, Timer2=On
+    pwmNextHigh = (uint8_t)(duty >> 2);             // MSB
+    pwmNextCon = (CCP1CON & 0xCF) | (uint8_t)((duty & 0b11) << 4);   // LSB in DC1B
+    PIR1bits.TMR2IF = 0;                    // a stale flag would apply it mid-period:
+    PIE1bits.TMR2IE = 1;                    //   wait for the next period start
+    return STATUS_OK;
+}
+
+uint8_t cmd_led()
+{
+    uint16_t period = cmdPayload[1] | ((uint16_t)cmdPayload[2] << 8);
+
+    if(cmdLength != 3)
+        return STATUS_BAD_LENGTH;
+    if(cmdPayload[0] > LED_ADC_BAR || period == 0)
+        return STATUS_BAD_VALUE;
+
+    ledMode = cmdPayload[0];
+    ledPeriod = period;
+    PORTD &= 0xF0;
+    return STATUS_OK;
+}
+
+uint8_t cmd_stream()
+{
+    uint16_t period = cmdPayload[2] | ((uint16_t)cmdPayload[3] << 8);
+
+    if(cmdLength != 4)
+        return STATUS_BAD_LENGTH;
+    if(cmdPayload[1] > 3 || period == 0)
+        return STATUS_BAD_VALUE;
+
+    streamOn = cmdPayload[0] != 0;
+    streamPeriod = period;
+    ADCON0bits.CHS = cmdPayload[1];         // a tick passes before the next conversion: acquisition time
+    return STATUS_OK;
+}
+
+void cmd_counters()
+{
+    uint8_t reply[12];
+
+    reply[0] = (uint8_t)rxFrames;
+    reply[1] = (uint8_t)(rxFrames >> 8);
+    reply[2] = (uint8_t)rxErrors;
+    reply[3] = (uint8_t)(rxErrors >> 8);
+    reply[4] = rxOverruns;
+    reply[5] = cmdDropped;
+    reply[6] = (uint8_t)framesSent;
+    reply[7] = (uint8_t)(framesSent >> 8);
+    reply[8] = (uint8_t)framesDropped;
+    reply[9] = (uint8_t)(framesDropped >> 8);
+    reply[10] = (uint8_t)cmdLatencyMax;
+    reply[11] = (uint8_t)(cmdLatencyMax >> 8);
+    uart_send_frame(FRAME_REPLY | CMD_COUNTERS, reply, 12);
+}
+
+void command_run()
+{
+    uint8_t status;
+    uint16_t latency;
+
+    switch(cmdType)
+    {
+    case CMD_PWM:
+        status = cmd_pwm();
+        break;
+    case CMD_LED:
+        status = cmd_led();
+        break;
+    case CMD_STREAM:
+        status = cmd_stream();
+        break;
+    case CMD_COUNTERS:
+        status = cmdLength ? STATUS_BAD_LENGTH : STATUS_OK;
+        break;
+    default:
+        status = STATUS_UNKNOWN;
+        break;
+    }
+
+    latency = timer1_read() - cmdStamp;     // the command has been carried out
+    if(latency > cmdLatencyMax)
+        cmdLatencyMax = latency;
+    cmdReady = 0;                           // isr() may fill the mailbox again
+
+    if(cmdType == CMD_COUNTERS && status == STATUS_OK)
+        cmd_counters();
+    else
+        uart_send_frame(FRAME_REPLY | (cmdType & 0x7F), &status, 1);
+}
+
+void led_step()
+{
+    static uint8_t rotate = 0x01;
+    uint8_t leds = 0;
+
+    switch(ledMode)
+    {
+    case LED_BLINK:
+        leds = (PORTD ^ 0x01) & 0x01;
+        break;
+    case LED_ROTATE:
+        rotate = rotate & 0x08 ? 0x01 : rotate << 1;
+        leds = rotate;
+        break;
+    case LED_ADC_BAR:
+        {
+            uint16_t sample = ADC_GetSample();
+
+            if(sample > 256)
+                leds |= 0x01;
+            if(sample > 512)
+                leds |= 0x02;
+            if(sample > 768)
+                leds |= 0x04;
+            if(sample > 1000)
+                leds |= 0x08;
+        }
+        break;
+    }
+    PORTD = (PORTD & 0xF0) | leds;          // RD7 is the PWM's
+}
+
+void main(void)
+{
+    uint8_t lastTick, seq;
+    uint16_t ledCountdown = 1;
+    uint16_t streamCountdown = 1;
+
+    system_init();
+
+    lastTick = tickCount;
+    seq = sampleSeq;
+    while(1)
+    {
+        while(!cmdReady && tickCount == lastTick && seq == sampleSeq)
+            NOP();                          // idle until isr() has something
+
+        if(cmdReady)
+            command_run();
+
+        if(seq != sampleSeq)
+        {
+            uint16_t sample = ADC_GetSample();
+            uint8_t frame[4];
+
+            seq = sampleSeq;
+            frame[0] = seq;
+            frame[1] = (uint8_t)sample;
+            frame[2] = (uint8_t)(sample >> 8);
+            frame[3] = PORTD;
+            if(streamOn)
+                uart_send_frame(FRAME_SAMPLE, frame, 4);
+        }
+
+        while(tickCount != lastTick)
+        {
+            lastTick++;
+            if(--ledCountdown == 0)
+            {
+                ledCountdown = ledPeriod;
+                led_step();
+            }
+            if(--streamCountdown == 0)
+            {
+                streamCountdown = streamPeriod;
+                if(streamOn || ledMode == LED_ADC_BAR)
+                    ADCON0bits.GO_nDONE = 1;    // isr() picks up the result
+            }
+        }
+    }
+
+  return;
+}
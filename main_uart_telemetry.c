@@ -0,0 +1,246 @@
+/*
+ * File:   main_uart_telemetry.c
+ *
+ * Streaming ADC samples and the LED state over the EUSART
+ * Timer 2 starts a conversion every 2 milliseconds, and every result goes
+ * out on TX (RC6) as a small binary frame together with the LEDs it
+ * produced. Transmitting never blocks main(): frames are copied into a
+ * ring buffer and the transmit interrupt (TXIF) feeds TXREG one byte at a
+ * time, like a DMA channel would. A frame that does not fit into the
+ * buffer is dropped whole and counted.
+ *
+ * Frame: 0xA5 | type | length | payload (length bytes) | CRC-8
+ *   CRC-8: polynomial 0x07, initial value 0, over type, length and payload
+ *   type 0x01 SAMPLE  seq, ADC low, ADC high, LEDs (PORTD)
+ *   type 0x02 STATS   frames sent (16 bit), frames dropped (16 bit), every second
+ * Multi-byte values are little endian.
+ * In the simulator, -u FILE captures the stream and sim/build/telemetry_read
+ * decodes it:
+ *     sim/build/main_uart_telemetry -t 5 -u uart.bin
+ *     sim/build/telemetry_read uart.bin
+ *
+ *  Board connection (PICKit 44-Pin Demo Board; PIC16F887):
+ *   PIN                	Module
+ * -------------------------------------------
+ *  RD0          			LED
+ *  RD1          			LED
+ *  RD2          			LED
+ *  RD3          			LED
+ *  RD7          			LED (on once a frame had to be dropped)
+ *  RA0 (RP1)               POTENCIOMETER
+ *  RC6 (TX)                serial adapter RX, 57600 8N1
+ *  RC7 (RX)                serial adapter TX (not used here)
+ *
+ */
+
+
+/* The __delay_ms() function is provided by XC8.
+It requires you define _XTAL_FREQ as the frequency of your system clock.
+The compiler then uses that value to calculate how many cycles are required to give the requested delay.
+There is also __delay_us() for microseconds and _delay() to delay for a specific number of clock cycles.
+Note that __delay_ms() and __delay_us() begin with a double underscore whereas _delay()
+begins with a single underscore.
+*/
+#define _XTAL_FREQ 8000000
+
+// PIC16F887 Configuration Bit Settings
+// 'C' source line config statements
+// CONFIG1
+#pragma config FOSC = INTRC_NOCLKOUT// Oscillator Selection bits (INTOSCIO oscillator: I/O function on RA6/OSC2/CLKOUT pin, I/O function on RA7/OSC1/CLKIN)
+#pragma config WDTE = OFF       // Watchdog Timer Enable bit (WDT disabled and can be enabled by SWDTEN bit of the WDTCON register)
+#pragma config PWRTE = OFF      // Power-up Timer Enable bit (PWRT disabled)
+#pragma config MCLRE = ON       // RE3/MCLR pin function select bit (RE3/MCLR pin function is MCLR)
+#pragma config CP = OFF         // Code Protection bit (Program memory code protection is disabled)
+#pragma config CPD = OFF        // Data Code Protection bit (Data memory code protection is disabled)
+#pragma config BOREN = ON       // Brown Out Reset Selection bits (BOR enabled)
+#pragma config IESO = ON        // Internal External Switchover bit (Internal/External Switchover mode is enabled)
+#pragma config FCMEN = ON       // Fail-Safe Clock Monitor Enabled bit (Fail-Safe Clock Monitor is enabled)
+#pragma config LVP = OFF        // Low Voltage Programming Enable bit (RB3 pin has digital I/O, HV on MCLR must be used for programming)
+
+// CONFIG2
+#pragma config BOR4V = BOR40V   // Brown-out Reset Selection bit (Brown-out Reset set to 4.0V)
+#pragma config WRT = OFF        // Flash Program Memory Self Write Enable bits (Write protection off)
+
+#include <xc.h>
+#include <stdint.h>
+
+// EUSART: BRG16 = 1 and BRGH = 1, so baud = Fosc / (4 * (SPBRGH:SPBRG + 1))
+#define UART_BAUD                 57600
+#define UART_BRG                  ((_XTAL_FREQ / 4 + UART_BAUD / 2) / UART_BAUD - 1)
+#define UART_ACTUAL               (_XTAL_FREQ / 4 / (UART_BRG + 1))
+#define UART_ERROR_PERMILLE       ((UART_ACTUAL > UART_BAUD ? UART_ACTUAL - UART_BAUD : UART_BAUD - UART_ACTUAL) * 1000 / UART_BAUD)
+#if UART_ERROR_PERMILLE > 20
+#error "UART_BAUD is more than 2% off with this _XTAL_FREQ"
+#endif
+
+// Frames (sync, overhead and CRC: see uart_tx.h)
+#define FRAME_SAMPLE              0x01
+#define FRAME_STATS               0x02
+#define STATS_EVERY               500       // samples between two STATS frames
+
+// Transmit ring buffer, power of two
+#define TX_BUFFER_SIZE            64
+#define UART_TX_IMPL                        // the ring buffer lives in this file
+#include "uart_tx.h"
+
+volatile uint16_t adcSample;                // last ADC result
+volatile uint8_t sampleSeq = 0;             // counts ADC results
+
+void system_init()
+{
+    OSCCON=0x70;          // Select 8 Mhz internal clock
+
+	// I/O
+		// ANSELx registers
+			ANSEL = 0x00;         // Set PORT ANS0 to ANS7 as Digital I/O
+			ANSELH = 0x00;        // Set PORT ANS8 to ANS11 as Digital I/O
+			ANSELbits.ANS0 = 1;   // Set RA0/AN0 to analog mode
+
+		// TRISx registers (This register specifies the data direction of each pin)
+			TRISA = 0x01;         // Set All on PORTA as Output, and AN0 as Input
+			TRISB = 0x00;         // Set All on PORTB as Output
+			TRISC = 0x80;         // Set All on PORTC as Output, and RC7 (RX) as Input
+            TRISD = 0x00;         // Set All on PORTD as Output
+            TRISE = 0x00;         // Set All on PORTE as Output
+
+		// PORT registers (hold the current digital state of the digital I/O)
+			PORTA = 0x00;         // Set PORTA all 0
+			PORTB = 0x00;         // Set PORTB all 0
+			PORTC = 0x00;         // Set PORTC all 0
+            PORTD = 0x00;         // Set PORTD all 0
+            PORTE = 0x00;         // Set PORTE all 0
+
+    // ADC setup (see main_adc.c)
+        ADCON1bits.ADFM = 1;   		// ADC result is right justified
+        ADCON0bits.ADCS = 0b10;     // Fosc/32 is the conversion clock (Tad = 4us at 8MHz)
+        ADCON0bits.CHS = 0;         // Select analog input - AN0
+        ADCON0bits.ADON = 1;    	// Turn on the ADC
+
+	// Timer Setup - Timer 2 (see main_timer2.c for T2CON)
+    // 500 Hz: 2 MHz / 4 (prescaler) / 125 (PR2 + 1) / 8 (postscaler)
+    // 8 byte frames at 500 Hz keep the 57600 baud line about 70% busy
+		TMR2 = 0;                   // Start with zero Counter
+        PR2 = 124;                  // Period
+        T2CON = 0b00111101;         // Postscaler: 1:8, Timer2=On, Prescaler: 1:4
+
+	// EUSART setup
+    /*
+	 * -------------------TXSTA-----------------------------------------------
+     * Bit#:  ---7----6----5----4-----3----2-----1-----0---
+     * :      -|CSRC|TX9|TXEN|SYNC|SENDB|BRGH|TRMT|TX9D|--
+     * ------------------------------------------------------------------------
+     * -------------------RCSTA-----------------------------------------------
+     * Bit#:  ---7----6----5----4-----3----2-----1-----0---
+     * :      -|SPEN|RX9|SREN|CREN|ADDEN|FERR|OERR|RX9D|--
+     * ------------------------------------------------------------------------
+     * -------------------BAUDCTL---------------------------------------------
+     * Bit#:  ----7------6-----5----4-----3-----2----1----0---
+     * :      -|ABDOVF|RCIDL|---|SCKP|BRG16|---|WUE|ABDEN|--
+     * ------------------------------------------------------------------------
+        TXEN: transmit enable     SYNC: 0 = asynchronous
+        BRGH: high baud rate      BRG16: 16-bit baud rate generator
+        SPEN: serial port enable, turns RC6/RC7 into TX/RX
+        TRMT: 1 = the shift register is empty
+     * TXREG is double buffered: TXIF is set while TXREG can take another
+     * byte, which is most of the time. That is why uart_tx.h only turns
+     * TXIE on while there is something to send.
+    */
+        BAUDCTLbits.BRG16 = 1;      // 16-bit baud rate generator
+        SPBRGH = (uint8_t)(UART_BRG >> 8);
+        SPBRG = (uint8_t)UART_BRG;  // 57600 baud (57143, -0.8%, at 8MHz)
+        TXSTA = 0b00100100;         // TXEN = 1, SYNC = 0, BRGH = 1
+        RCSTAbits.SPEN = 1;         // Turn on the serial port
+
+	// Interrupt setup
+        PIR1bits.TMR2IF = 0;        // Clear the Timer 2 interrupt flag
+        PIE1bits.TMR2IE = 1;        // Enable the Timer 2 interrupt
+        PIR1bits.ADIF = 0;          // Clear the ADC interrupt flag
+        PIE1bits.ADIE = 1;          // Enable the ADC interrupt
+        INTCONbits.PEIE = 1;        // Timer 2, ADC and EUSART are peripheral interrupts
+		INTCONbits.GIE = 1;         // Set the Global Interrupt Enable
+}
+
+/*
+ * The PIC16F887 can only have one Interrupt Service Routine.
+ * Compiler should know which function is the interrupt handler.
+ * This is done by declaring the function with 'interrupt' prefix:
+ */
+void interrupt isr()
+{
+    if(PIE1bits.TXIE && PIR1bits.TXIF)
+        uart_tx_isr();              // next byte of the ring buffer
+    if(PIR1bits.TMR2IF)
+    {
+        PIR1bits.TMR2IF = 0;        // Clear the Timer 2 interrupt flag
+        ADCON0bits.GO_nDONE = 1;    // The channel never changes, it has had 2 ms to acquire
+    }
+    if(PIR1bits.ADIF)
+    {
+        PIR1bits.ADIF = 0;          // Clear the ADC interrupt flag
+        adcSample = (uint16_t)((ADRESH << 8) + ADRESL);
+        sampleSeq++;
+    }
+}
+
+// 16-bit reads are not atomic, so keep isr() out while copying
+uint16_t ADC_GetSample()
+{
+    uint16_t value;
+
+    PIE1bits.ADIE = 0;
+    value = adcSample;
+    PIE1bits.ADIE = 1;
+    return value;
+}
+
+void main(void)
+{
+    uint8_t seq;
+    uint8_t frame[4];
+    uint8_t leds = 0;
+    uint16_t untilStats = STATS_EVERY;
+
+    system_init();
+
+    seq = sampleSeq;
+    while(1)
+    {
+        uint16_t sample;
+
+        while(seq == sampleSeq)
+            NOP();                          // nothing to do until the next sample
+        seq = sampleSeq;
+        sample = ADC_GetSample();
+
+        leds = 0;
+        if(sample > 256)
+            leds |= 0x01;
+        if(sample > 512)
+            leds |= 0x02;
+        if(sample > 768)
+            leds |= 0x04;
+        if(sample > 1000)
+            leds |= 0x08;
+        if(framesDropped)
+            leds |= 0x80;
+        PORTD = leds;                       // all LEDs in one write
+
+        frame[0] = seq;
+        frame[1] = (uint8_t)sample;
+        frame[2] = (uint8_t)(sample >> 8);
+        frame[3] = leds;
+        uart_send_frame(FRAME_SAMPLE, frame, 4);
+
+        if(--untilStats == 0)
+        {
+            untilStats = STATS_EVERY;
+            frame[0] = (uint8_t)framesSent;
+            frame[1] = (uint8_t)(framesSent >> 8);
+            frame[2] = (uint8_t)framesDropped;
+            frame[3] = (uint8_t)(framesDropped >> 8);
+            uart_send_frame(FRAME_STATS, frame, 4);
+        }
+    }
+
+  return;
+}
@@ -0,0 +1,130 @@
+/*
+ * File:   main_wdt_periodic.c
+ *
+ * Ultra-low-power periodic mode on the Watchdog Timer
+ * main_wdt.c sleeps once and stops. Here the WDT wakes the CPU every
+ * WDT_WAKE_MS (see wdt_wake.h for the range and the rounding), which
+ * samples the potentiometer with a short burst of work: ADC on, acquire,
+ * convert, ADC off, show the level on the LEDs. Then it goes back to
+ * Sleep. Everything except the WDT and the LEDs is off in Sleep, and the
+ * CPU is awake for some 50 us a period. The simulator report gives the
+ * share of time asleep, how long each burst took and the time from the
+ * WDT wake-up to the first register write of the burst.
+ *
+ *  Board connection (PICKit 44-Pin Demo Board; PIC16F887):
+ *   PIN                	Module
+ * -------------------------------------------
+ *  RD0-RD3          		LED (potentiometer level as a bar)
+ *  RD7          			LED (toggles every wake-up)
+ *  RA0 (RP1)               POTENCIOMETER
+ *
+ */
+
+
+
+/* The __delay_ms() function is provided by XC8.
+It requires you define _XTAL_FREQ as the frequency of your system clock.
+The compiler then uses that value to calculate how many cycles are required to give the requested delay.
+There is also __delay_us() for microseconds and _delay() to delay for a specific number of clock cycles.
+Note that __delay_ms() and __delay_us() begin with a double underscore whereas _delay()
+begins with a single underscore.
+*/
+#define _XTAL_FREQ 8000000
+
+// PIC16F887 Configuration Bit Settings
+// 'C' source line config statements
+// CONFIG1
+#pragma config FOSC = INTRC_NOCLKOUT// Oscillator Selection bits (INTOSCIO oscillator: I/O function on RA6/OSC2/CLKOUT pin, I/O function on RA7/OSC1/CLKIN)
+#pragma config WDTE = OFF       // Watchdog Timer Enable bit (WDT disabled and can be enabled by SWDTEN bit of the WDTCON register)
+#pragma config PWRTE = OFF      // Power-up Timer Enable bit (PWRT disabled)
+#pragma config MCLRE = ON       // RE3/MCLR pin function select bit (RE3/MCLR pin function is MCLR)
+#pragma config CP = OFF         // Code Protection bit (Program memory code protection is disabled)
+#pragma config CPD = OFF        // Data Code Protection bit (Data memory code protection is disabled)
+#pragma config BOREN = ON       // Brown Out Reset Selection bits (BOR enabled)
+#pragma config IESO = ON        // Internal External Switchover bit (Internal/External Switchover mode is enabled)
+#pragma config FCMEN = ON       // Fail-Safe Clock Monitor Enabled bit (Fail-Safe Clock Monitor is enabled)
+#pragma config LVP = OFF        // Low Voltage Programming Enable bit (RB3 pin has digital I/O, HV on MCLR must be used for programming)
+
+// CONFIG2
+#pragma config BOR4V = BOR40V   // Brown-out Reset Selection bit (Brown-out Reset set to 4.0V)
+#pragma config WRT = OFF        // Flash Program Memory Self Write Enable bits (Write protection off)
+
+#include <xc.h>
+#include <stdint.h>
+
+#define WDT_WAKE_MS               1000      // comes out as 1057 ms (32 x 2^10 / 31 kHz)
+#include "wdt_wake.h"
+
+#define ACQ_US_DELAY              5
+
+uint16_t wakeups = 0;
+
+void system_init()
+{
+    OSCCON=0x70;          // Select 8 Mhz internal clock
+
+	// I/O
+		// ANSELx registers
+			ANSEL = 0x00;         // Set PORT ANS0 to ANS7 as Digital I/O
+			ANSELH = 0x00;        // Set PORT ANS8 to ANS11 as Digital I/O
+            ANSELbits.ANS0 = 1;   // Set RA0/AN0 to analog mode
+
+		// TRISx registers (This register specifies the data direction of each pin)
+			TRISA = 0x00;         // Set All on PORTA as Output
+			TRISB = 0x00;         // Set All on PORTB as Output
+			TRISC = 0x00;         // Set All on PORTC as Output
+            TRISD = 0x00;         // Set All on PORTD as Output
+            TRISE = 0x00;         // Set All on PORTE as Output
+            TRISAbits.TRISA0 = 1; // Set RA0/AN0 as Input
+
+		// PORT registers (hold the current digital state of the digital I/O)
+			PORTA = 0x00;         // Set PORTA all 0
+			PORTB = 0x00;         // Set PORTB all 0
+			PORTC = 0x00;         // Set PORTC all 0
+            PORTD = 0x00;         // Set PORTD all 0
+            PORTE = 0x00;         // Set PORTE all 0
+
+    // ADC setup (see main_adc.c for the register description), only on during a burst
+        ADCON1bits.ADFM = 0;   		// ADC result is left justified: ADRESH has the top 8 bits
+        ADCON1bits.VCFG0 = 0;    	// Vref uses Vdd as reference
+        ADCON1bits.VCFG1 = 0;       // Vss as negative reference
+        ADCON0bits.ADCS = 0b10;     // Fosc/32 is the conversion clock (Tad = 4us at 8MHz)
+        ADCON0bits.CHS = 0;         // Select analog input - AN0
+
+    // Watchdog as the wake-up alarm
+        wdt_wake_init();
+}
+
+// The burst: one ADC sample shown as a bar on RD0-RD3
+void work()
+{
+    uint8_t level, bar;
+
+    ADCON0bits.ADON = 1;                    // Turn on the ADC
+    __delay_us(ACQ_US_DELAY);               // Acquisition time delay
+    ADCON0bits.GO_nDONE = 1;                // Start the conversion
+    while(ADCON0bits.GO_nDONE);             // Wait for the conversion to finish
+    level = ADRESH;
+    ADCON0bits.ADON = 0;                    // and off again until the next burst
+
+    bar = 0;
+    if(level >= 0x20) bar |= 0x01;
+    if(level >= 0x60) bar |= 0x02;
+    if(level >= 0xA0) bar |= 0x04;
+    if(level >= 0xE0) bar |= 0x08;
+    PORTD = (wakeups & 1 ? 0x80 : 0x00) | bar;
+    wakeups++;
+}
+
+void main(void)
+{
+    system_init();
+
+    while(1)
+    {
+        work();
+        wdt_wake_sleep();                   // WDT_WAKE_ACTUAL_MS of Sleep
+    }
+
+  return;
+}
@@ -0,0 +1,185 @@
+/*
+ * File:   pwm.h
+ *
+ * Hardware PWM driver (ECCP1 + Timer 2) with the period solved at compile time
+ * Set PWM_FREQ_HZ (and _XTAL_FREQ) before including this file. The
+ * preprocessor picks the Timer 2 prescaler and PR2 for it:
+ *     PWM period = (PR2 + 1) x 4 x Tosc x prescaler
+ * taking the smallest prescaler (1, 4 or 16) whose PR2 fits 8 bits, as
+ * that gives the most duty steps, and rounding PR2 to the nearest period.
+ * A target that cannot be met within PWM_FREQ_TOLERANCE percent stops the
+ * build with #error instead of running at some other frequency.
+ *
+ * What you get (all compile-time constants):
+ *   PWM_PR2, PWM_PRESCALE, PWM_T2CKPS   the Timer 2 setup
+ *   PWM_ACTUAL_HZ                       the frequency it really runs at
+ *   PWM_DUTY_STEPS                      4 (PR2 + 1): duty values 0..PWM_DUTY_STEPS
+ *                                       (PWM_DUTY_STEPS and above = 100%)
+ *   PWM_RESOLUTION_BITS                 whole bits of duty resolution,
+ *                                       log2(PWM_DUTY_STEPS) rounded down
+ *
+ * Optional: PWM_STEERING, the PSTRCON STRx bits of the outputs to drive
+ * (default P1A = RC2/CCP1), PWM_FREQ_TOLERANCE (default 2 percent) and
+ * PWM_SYNC (below).
+ *
+ * pwm_set_duty() takes a 10-bit duty. The module only copies CCPR1L and
+ * DC1B into its duty latch at the end of a period, so a period ends up
+ * with half an update if that moment falls between the two writes.
+ *   PWM_SYNC 0     both are written back to back with interrupts off: a
+ *                  period can at worst start with the new high bits and
+ *                  the old two low bits, 3 steps off for that one period.
+ *   PWM_SYNC 1     pwm_set_duty() only stores the duty; the TMR2IF
+ *                  interrupt at the next period start writes both, a whole
+ *                  period before they are latched, so no period is ever
+ *                  torn. The new duty shows up within two periods. Call
+ *                  pwm_commit() from isr() when TMR2IE and TMR2IF are set,
+ *                  and set PEIE and GIE. The pending duty is stored in the
+ *                  file that defines PWM_IMPL before including pwm.h.
+ */
+
+#ifndef PWM_H
+#define PWM_H
+
+#include <stdint.h>
+
+#ifndef PWM_FREQ_HZ
+#error "define PWM_FREQ_HZ before including pwm.h"
+#endif
+#ifndef PWM_FREQ_TOLERANCE
+#define PWM_FREQ_TOLERANCE  2                   // percent
+#endif
+#ifndef PWM_STEERING
+#define PWM_STEERING        0b0001              // STRA: P1A (RC2)
+#endif
+#ifndef PWM_SYNC
+#define PWM_SYNC            0
+#endif
+
+// PR2 for a prescaler, rounded to the nearest period
+#define PWM_PR2_FOR(pre)    ((_XTAL_FREQ + 2UL * (pre) * PWM_FREQ_HZ) / (4UL * (pre) * PWM_FREQ_HZ) - 1)
+
+#if 4UL * PWM_FREQ_HZ > _XTAL_FREQ
+#error "PWM_FREQ_HZ is above Fosc / 4"
+#elif PWM_PR2_FOR(1) <= 255
+#define PWM_PRESCALE        1
+#define PWM_T2CKPS          0b00
+#elif PWM_PR2_FOR(4) <= 255
+#define PWM_PRESCALE        4
+#define PWM_T2CKPS          0b01
+#elif PWM_PR2_FOR(16) <= 255
+#define PWM_PRESCALE        16
+#define PWM_T2CKPS          0b10
+#else
+#error "PWM_FREQ_HZ is below what Timer 2 can reach at this _XTAL_FREQ"
+#endif
+
+#define PWM_PR2             PWM_PR2_FOR(PWM_PRESCALE)
+#define PWM_ACTUAL_HZ       (_XTAL_FREQ / (4UL * PWM_PRESCALE * (PWM_PR2 + 1)))
+#define PWM_DUTY_STEPS      (4U * (PWM_PR2 + 1))
+
+#if PWM_ACTUAL_HZ > PWM_FREQ_HZ
+#define PWM_FREQ_ERROR      (PWM_ACTUAL_HZ - PWM_FREQ_HZ)
+#else
+#define PWM_FREQ_ERROR      (PWM_FREQ_HZ - PWM_ACTUAL_HZ)
+#endif
+#if PWM_FREQ_ERROR * 100 > PWM_FREQ_TOLERANCE * PWM_FREQ_HZ
+#error "PWM_FREQ_HZ cannot be reached within PWM_FREQ_TOLERANCE"
+#endif
+
+#if PWM_DUTY_STEPS >= 1024
+#define PWM_RESOLUTION_BITS 10
+#elif PWM_DUTY_STEPS >= 512
+#define PWM_RESOLUTION_BITS 9
+#elif PWM_DUTY_STEPS >= 256
+#define PWM_RESOLUTION_BITS 8
+#elif PWM_DUTY_STEPS >= 128
+#define PWM_RESOLUTION_BITS 7
+#elif PWM_DUTY_STEPS >= 64
+#define PWM_RESOLUTION_BITS 6
+#elif PWM_DUTY_STEPS >= 32
+#define PWM_RESOLUTION_BITS 5
+#elif PWM_DUTY_STEPS >= 16
+#define PWM_RESOLUTION_BITS 4
+#else
+#define PWM_RESOLUTION_BITS 3
+#endif
+
+// The setup sequence of the datasheet (see main_pwm.c), output enabled
+// once the first period has started. Leaves Timer 2 running and its
+// interrupt off.
+static inline void pwm_init()
+{
+    TRISCbits.TRISC2 = 1;                   // P1A driver off during setup
+    PR2 = PWM_PR2;
+    CCP1CON = 0b00001100;                   // Single output, PWM, active high, DC1B = 0
+    CCPR1L = 0;                             // 0% to start with
+    PSTRCON = PWM_STEERING;
+
+    PIR1bits.TMR2IF = 0;
+    T2CON = PWM_T2CKPS;                     // Postscaler 1:1 (unused by the PWM)
+    T2CONbits.TMR2ON = 1;
+    while(PIR1bits.TMR2IF == 0){}           // wait for the first period to start
+
+    if(PWM_STEERING & 0b0001)
+        TRISCbits.TRISC2 = 0;               // P1A
+    if(PWM_STEERING & 0b0010)
+        TRISDbits.TRISD5 = 0;               // P1B
+    if(PWM_STEERING & 0b0100)
+        TRISDbits.TRISD6 = 0;               // P1C
+    if(PWM_STEERING & 0b1000)
+        TRISDbits.TRISD7 = 0;               // P1D
+}
+
+#if PWM_SYNC
+// Next duty for pwm_commit(), CCPR1L and CCP1CON as they will be written
+extern volatile uint8_t pwmNextHigh;
+extern volatile uint8_t pwmNextCon;
+#ifdef PWM_IMPL
+volatile uint8_t pwmNextHigh;
+volatile uint8_t pwmNextCon;
+#endif
+#endif
+
+// duty: 0 (off) .. PWM_DUTY_STEPS (on), 10 bits at most
+static inline void pwm_set_duty(uint16_t duty)
+{
+    uint8_t high, con;
+#if !PWM_SYNC
+    uint8_t gie;
+#endif
+
+#if PWM_DUTY_STEPS > 1023
+    if(duty > 1023)
+        duty = 1023;                        // with PR2 = 255 100% is out of reach of 10 bits
+#endif
+    high = (uint8_t)(duty >> 2);
+    con = (CCP1CON & 0xCF) | (uint8_t)((duty & 0x03) << 4);
+
+#if PWM_SYNC
+    PIE1bits.TMR2IE = 0;                    // pwm_commit() must not see half of it
+    pwmNextHigh = high;
+    pwmNextCon = con;
+    PIR1bits.TMR2IF = 0;                    // a stale flag would commit mid-period:
+    PIE1bits.TMR2IE = 1;                    //   wait for the next period start
+#else
+    gie = INTCONbits.GIE;
+    INTCONbits.GIE = 0;                     // nothing may come between the two writes
+    CCP1CON = con;
+    CCPR1L = high;
+    INTCONbits.GIE = gie;
+#endif
+}
+
+#if PWM_SYNC
+// From isr() on TMR2IF: a period has just started and latched the old
+// duty, the new one has a whole period to get into CCPR1L and DC1B
+static inline void pwm_commit()
+{
+    PIR1bits.TMR2IF = 0;
+    CCP1CON = pwmNextCon;
+    CCPR1L = pwmNextHigh;
+    PIE1bits.TMR2IE = 0;                    // one commit per pwm_set_duty()
+}
+#endif
+
+#endif /* PWM_H */
@@ -0,0 +1,589 @@
+/*
+ * File:   pic16f887.h
+ *
+ * Host model of the PIC16F887 Special Function Registers.
+ *
+ * Every SFR lives at its datasheet address inside sim_reg[] (banks 0-3
+ * flattened, bank bits included in the address). The XC8 names used by
+ * the sketches (PORTD, PORTDbits.RD0, ADCON0bits.GO_nDONE, TMR1, ...) are
+ * macros that go through sim_sfr(): the simulator gets a chance to bring
+ * the register up to date before the sketch reads it and to notice what
+ * the sketch wrote to it afterwards.
+ *
+ * Bit-field layouts follow the XC8 pic16f887.h header (LSB first), so
+ * the sketches compile unmodified.
+ */
+
+#ifndef PIC16F887_H
+#define PIC16F887_H
+
+#include <stdint.h>
+
+#define SIM_REG_SIZE    0x200       // 4 banks x 128 bytes
+
+// Bank 0
+#define SFR_TMR0        0x001
+#define SFR_STATUS      0x003
+#define SFR_PORTA       0x005
+#define SFR_PORTB       0x006
+#define SFR_PORTC       0x007
+#define SFR_PORTD       0x008
+#define SFR_PORTE       0x009
+#define SFR_INTCON      0x00B
+#define SFR_PIR1        0x00C
+#define SFR_PIR2        0x00D
+#define SFR_TMR1L       0x00E
+#define SFR_TMR1H       0x00F
+#define SFR_T1CON       0x010
+#define SFR_TMR2        0x011
+#define SFR_T2CON       0x012
+#define SFR_CCPR1L      0x015
+#define SFR_CCPR1H      0x016
+#define SFR_CCP1CON     0x017
+#define SFR_RCSTA       0x018
+#define SFR_TXREG       0x019
+#define SFR_RCREG       0x01A
+#define SFR_ADRESH      0x01E
+#define SFR_ADCON0      0x01F
+// Bank 1
+#define SFR_OPTION_REG  0x081
+#define SFR_TRISA       0x085
+#define SFR_TRISB       0x086
+#define SFR_TRISC       0x087
+#define SFR_TRISD       0x088
+#define SFR_TRISE       0x089
+#define SFR_PIE1        0x08C
+#define SFR_PIE2        0x08D
+#define SFR_PCON        0x08E
+#define SFR_OSCCON      0x08F
+#define SFR_PR2         0x092
+#define SFR_WPUB        0x095
+#define SFR_IOCB        0x096
+#define SFR_TXSTA       0x098
+#define SFR_SPBRG       0x099
+#define SFR_SPBRGH      0x09A
+#define SFR_PWM1CON     0x09B
+#define SFR_ECCPAS      0x09C
+#define SFR_PSTRCON     0x09D
+#define SFR_ADRESL      0x09E
+#define SFR_ADCON1      0x09F
+// Bank 2
+#define SFR_WDTCON      0x105
+#define SFR_EEDAT       0x10C
+#define SFR_EEADR       0x10D
+#define SFR_EEDATH      0x10E
+#define SFR_EEADRH      0x10F
+// Bank 3
+#define SFR_BAUDCTL     0x187
+#define SFR_ANSEL       0x188
+#define SFR_ANSELH      0x189
+#define SFR_EECON1      0x18C
+#define SFR_EECON2      0x18D
+
+/*
+ * Register access hook (sim.c). Returns the storage of 'width' bytes at
+ * 'addr' after bringing it up to date. Any change the caller makes to it
+ * is picked up on the next simulator entry.
+ */
+volatile void *sim_sfr(uint16_t addr, uint8_t width);
+
+#define SIM_SFR8(addr, type)    (*(volatile type *)sim_sfr((addr), 1))
+#define SIM_SFR16(addr, type)   (*(volatile type *)sim_sfr((addr), 2))
+
+typedef union {
+    struct {
+        uint8_t C       :1;
+        uint8_t DC      :1;
+        uint8_t Z       :1;
+        uint8_t nPD     :1;
+        uint8_t nTO     :1;
+        uint8_t RP      :2;
+        uint8_t IRP     :1;
+    };
+    struct {
+        uint8_t         :5;
+        uint8_t RP0     :1;
+        uint8_t RP1     :1;
+    };
+} STATUSbits_t;
+
+typedef union {
+    struct {
+        uint8_t RA0 :1; uint8_t RA1 :1; uint8_t RA2 :1; uint8_t RA3 :1;
+        uint8_t RA4 :1; uint8_t RA5 :1; uint8_t RA6 :1; uint8_t RA7 :1;
+    };
+} PORTAbits_t;
+
+typedef union {
+    struct {
+        uint8_t RB0 :1; uint8_t RB1 :1; uint8_t RB2 :1; uint8_t RB3 :1;
+        uint8_t RB4 :1; uint8_t RB5 :1; uint8_t RB6 :1; uint8_t RB7 :1;
+    };
+} PORTBbits_t;
+
+typedef union {
+    struct {
+        uint8_t RC0 :1; uint8_t RC1 :1; uint8_t RC2 :1; uint8_t RC3 :1;
+        uint8_t RC4 :1; uint8_t RC5 :1; uint8_t RC6 :1; uint8_t RC7 :1;
+    };
+} PORTCbits_t;
+
+typedef union {
+    struct {
+        uint8_t RD0 :1; uint8_t RD1 :1; uint8_t RD2 :1; uint8_t RD3 :1;
+        uint8_t RD4 :1; uint8_t RD5 :1; uint8_t RD6 :1; uint8_t RD7 :1;
+    };
+} PORTDbits_t;
+
+typedef union {
+    struct {
+        uint8_t RE0 :1; uint8_t RE1 :1; uint8_t RE2 :1; uint8_t RE3 :1;
+    };
+} PORTEbits_t;
+
+typedef union {
+    struct {
+        uint8_t TRISA0 :1; uint8_t TRISA1 :1; uint8_t TRISA2 :1; uint8_t TRISA3 :1;
+        uint8_t TRISA4 :1; uint8_t TRISA5 :1; uint8_t TRISA6 :1; uint8_t TRISA7 :1;
+    };
+} TRISAbits_t;
+
+typedef union {
+    struct {
+        uint8_t TRISB0 :1; uint8_t TRISB1 :1; uint8_t TRISB2 :1; uint8_t TRISB3 :1;
+        uint8_t TRISB4 :1; uint8_t TRISB5 :1; uint8_t TRISB6 :1; uint8_t TRISB7 :1;
+    };
+} TRISBbits_t;
+
+typedef union {
+    struct {
+        uint8_t TRISC0 :1; uint8_t TRISC1 :1; uint8_t TRISC2 :1; uint8_t TRISC3 :1;
+        uint8_t TRISC4 :1; uint8_t TRISC5 :1; uint8_t TRISC6 :1; uint8_t TRISC7 :1;
+    };
+} TRISCbits_t;
+
+typedef union {
+    struct {
+        uint8_t TRISD0 :1; uint8_t TRISD1 :1; uint8_t TRISD2 :1; uint8_t TRISD3 :1;
+        uint8_t TRISD4 :1; uint8_t TRISD5 :1; uint8_t TRISD6 :1; uint8_t TRISD7 :1;
+    };
+} TRISDbits_t;
+
+typedef union {
+    struct {
+        uint8_t TRISE0 :1; uint8_t TRISE1 :1; uint8_t TRISE2 :1; uint8_t TRISE3 :1;
+    };
+} TRISEbits_t;
+
+typedef union {
+    struct {
+        uint8_t RBIF    :1;
+        uint8_t INTF    :1;
+        uint8_t T0IF    :1;
+        uint8_t RBIE    :1;
+        uint8_t INTE    :1;
+        uint8_t T0IE    :1;
+        uint8_t PEIE    :1;
+        uint8_t GIE     :1;
+    };
+    struct {
+        uint8_t         :2;
+        uint8_t TMR0IF  :1;
+        uint8_t         :2;
+        uint8_t TMR0IE  :1;
+    };
+} INTCONbits_t;
+
+typedef union {
+    struct {
+        uint8_t TMR1IF  :1;
+        uint8_t TMR2IF  :1;
+        uint8_t CCP1IF  :1;
+        uint8_t SSPIF   :1;
+        uint8_t TXIF    :1;
+        uint8_t RCIF    :1;
+        uint8_t ADIF    :1;
+    };
+} PIR1bits_t;
+
+typedef union {
+    struct {
+        uint8_t TMR1IE  :1;
+        uint8_t TMR2IE  :1;
+        uint8_t CCP1IE  :1;
+        uint8_t SSPIE   :1;
+        uint8_t TXIE    :1;
+        uint8_t RCIE    :1;
+        uint8_t ADIE    :1;
+    };
+} PIE1bits_t;
+
+typedef union {
+    struct {
+        uint8_t CCP2IF  :1;
+        uint8_t         :1;
+        uint8_t ULPWUIF :1;
+        uint8_t BCLIF   :1;
+        uint8_t EEIF    :1;
+        uint8_t C1IF    :1;
+        uint8_t C2IF    :1;
+        uint8_t OSFIF   :1;
+    };
+} PIR2bits_t;
+
+typedef union {
+    struct {
+        uint8_t CCP2IE  :1;
+        uint8_t         :1;
+        uint8_t ULPWUIE :1;
+        uint8_t BCLIE   :1;
+        uint8_t EEIE    :1;
+        uint8_t C1IE    :1;
+        uint8_t C2IE    :1;
+        uint8_t OSFIE   :1;
+    };
+} PIE2bits_t;
+
+typedef union {
+    struct {
+        uint8_t TMR1ON  :1;
+        uint8_t TMR1CS  :1;
+        uint8_t nT1SYNC :1;
+        uint8_t T1OSCEN :1;
+        uint8_t T1CKPS  :2;
+        uint8_t TMR1GE  :1;
+        uint8_t T1GINV  :1;
+    };
+    struct {
+        uint8_t         :4;
+        uint8_t T1CKPS0 :1;
+        uint8_t T1CKPS1 :1;
+    };
+} T1CONbits_t;
+
+typedef union {
+    struct {
+        uint8_t T2CKPS  :2;
+        uint8_t TMR2ON  :1;
+        uint8_t TOUTPS  :4;
+    };
+    struct {
+        uint8_t T2CKPS0 :1;
+        uint8_t T2CKPS1 :1;
+        uint8_t         :1;
+        uint8_t TOUTPS0 :1;
+        uint8_t TOUTPS1 :1;
+        uint8_t TOUTPS2 :1;
+        uint8_t TOUTPS3 :1;
+    };
+} T2CONbits_t;
+
+typedef union {
+    struct {
+        uint8_t CCP1M   :4;
+        uint8_t DC1B    :2;
+        uint8_t P1M     :2;
+    };
+    struct {
+        uint8_t CCP1M0  :1;
+        uint8_t CCP1M1  :1;
+        uint8_t CCP1M2  :1;
+        uint8_t CCP1M3  :1;
+        uint8_t DC1B0   :1;
+        uint8_t DC1B1   :1;
+        uint8_t P1M0    :1;
+        uint8_t P1M1    :1;
+    };
+} CCP1CONbits_t;
+
+typedef union {
+    struct {
+        uint8_t ADON    :1;
+        uint8_t GO_nDONE:1;
+        uint8_t CHS     :4;
+        uint8_t ADCS    :2;
+    };
+    struct {
+        uint8_t         :1;
+        uint8_t GO      :1;
+        uint8_t CHS0    :1;
+        uint8_t CHS1    :1;
+        uint8_t CHS2    :1;
+        uint8_t CHS3    :1;
+        uint8_t ADCS0   :1;
+        uint8_t ADCS1   :1;
+    };
+    struct {
+        uint8_t         :1;
+        uint8_t nDONE   :1;
+    };
+    struct {
+        uint8_t         :1;
+        uint8_t GO_DONE :1;
+    };
+} ADCON0bits_t;
+
+typedef union {
+    struct {
+        uint8_t         :4;
+        uint8_t VCFG0   :1;
+        uint8_t VCFG1   :1;
+        uint8_t         :1;
+        uint8_t ADFM    :1;
+    };
+} ADCON1bits_t;
+
+typedef union {
+    struct {
+        uint8_t PS      :3;
+        uint8_t PSA     :1;
+        uint8_t T0SE    :1;
+        uint8_t T0CS    :1;
+        uint8_t INTEDG  :1;
+        uint8_t nRBPU   :1;
+    };
+    struct {
+        uint8_t PS0     :1;
+        uint8_t PS1     :1;
+        uint8_t PS2     :1;
+    };
+} OPTION_REGbits_t;
+
+typedef union {
+    struct {
+        uint8_t nBOR    :1;
+        uint8_t nPOR    :1;
+        uint8_t         :2;
+        uint8_t SBOREN  :1;
+        uint8_t ULPWUE  :1;
+    };
+} PCONbits_t;
+
+typedef union {
+    struct {
+        uint8_t SCS     :1;
+        uint8_t LTS     :1;
+        uint8_t HTS     :1;
+        uint8_t OSTS    :1;
+        uint8_t IRCF    :3;
+    };
+    struct {
+        uint8_t         :4;
+        uint8_t IRCF0   :1;
+        uint8_t IRCF1   :1;
+        uint8_t IRCF2   :1;
+    };
+} OSCCONbits_t;
+
+typedef union {
+    struct {
+        uint8_t WPUB0 :1; uint8_t WPUB1 :1; uint8_t WPUB2 :1; uint8_t WPUB3 :1;
+        uint8_t WPUB4 :1; uint8_t WPUB5 :1; uint8_t WPUB6 :1; uint8_t WPUB7 :1;
+    };
+} WPUBbits_t;
+
+typedef union {
+    struct {
+        uint8_t IOCB0 :1; uint8_t IOCB1 :1; uint8_t IOCB2 :1; uint8_t IOCB3 :1;
+        uint8_t IOCB4 :1; uint8_t IOCB5 :1; uint8_t IOCB6 :1; uint8_t IOCB7 :1;
+    };
+} IOCBbits_t;
+
+typedef union {
+    struct {
+        uint8_t PDC     :7;
+        uint8_t PRSEN   :1;
+    };
+} PWM1CONbits_t;
+
+typedef union {
+    struct {
+        uint8_t PSSBD   :2;
+        uint8_t PSSAC   :2;
+        uint8_t ECCPAS  :3;
+        uint8_t ECCPASE :1;
+    };
+} ECCPASbits_t;
+
+typedef union {
+    struct {
+        uint8_t STRA    :1;
+        uint8_t STRB    :1;
+        uint8_t STRC    :1;
+        uint8_t STRD    :1;
+        uint8_t STRSYNC :1;
+    };
+} PSTRCONbits_t;
+
+typedef union {
+    struct {
+        uint8_t SWDTEN  :1;
+        uint8_t WDTPS   :4;
+    };
+    struct {
+        uint8_t         :1;
+        uint8_t WDTPS0  :1;
+        uint8_t WDTPS1  :1;
+        uint8_t WDTPS2  :1;
+        uint8_t WDTPS3  :1;
+    };
+} WDTCONbits_t;
+
+typedef union {
+    struct {
+        uint8_t ANS0 :1; uint8_t ANS1 :1; uint8_t ANS2 :1; uint8_t ANS3 :1;
+        uint8_t ANS4 :1; uint8_t ANS5 :1; uint8_t ANS6 :1; uint8_t ANS7 :1;
+    };
+} ANSELbits_t;
+
+typedef union {
+    struct {
+        uint8_t ANS8 :1; uint8_t ANS9 :1; uint8_t ANS10 :1; uint8_t ANS11 :1;
+        uint8_t ANS12 :1; uint8_t ANS13 :1;
+    };
+} ANSELHbits_t;
+
+typedef union {
+    struct {
+        uint8_t RD      :1;
+        uint8_t WR      :1;
+        uint8_t WREN    :1;
+        uint8_t WRERR   :1;
+        uint8_t         :3;
+        uint8_t EEPGD   :1;
+    };
+} EECON1bits_t;
+
+typedef union {
+    struct {
+        uint8_t TX9D    :1;
+        uint8_t TRMT    :1;
+        uint8_t BRGH    :1;
+        uint8_t SENDB   :1;
+        uint8_t SYNC    :1;
+        uint8_t TXEN    :1;
+        uint8_t TX9     :1;
+        uint8_t CSRC    :1;
+    };
+} TXSTAbits_t;
+
+typedef union {
+    struct {
+        uint8_t RX9D    :1;
+        uint8_t OERR    :1;
+        uint8_t FERR    :1;
+        uint8_t ADDEN   :1;
+        uint8_t CREN    :1;
+        uint8_t SREN    :1;
+        uint8_t RX9     :1;
+        uint8_t SPEN    :1;
+    };
+} RCSTAbits_t;
+
+typedef union {
+    struct {
+        uint8_t ABDEN   :1;
+        uint8_t WUE     :1;
+        uint8_t         :1;
+        uint8_t BRG16   :1;
+        uint8_t SCKP    :1;
+        uint8_t         :1;
+        uint8_t RCIDL   :1;
+        uint8_t ABDOVF  :1;
+    };
+} BAUDCTLbits_t;
+
+#define TMR0            SIM_SFR8(SFR_TMR0, uint8_t)
+#define STATUS          SIM_SFR8(SFR_STATUS, uint8_t)
+#define STATUSbits      SIM_SFR8(SFR_STATUS, STATUSbits_t)
+#define PORTA           SIM_SFR8(SFR_PORTA, uint8_t)
+#define PORTAbits       SIM_SFR8(SFR_PORTA, PORTAbits_t)
+#define PORTB           SIM_SFR8(SFR_PORTB, uint8_t)
+#define PORTBbits       SIM_SFR8(SFR_PORTB, PORTBbits_t)
+#define PORTC           SIM_SFR8(SFR_PORTC, uint8_t)
+#define PORTCbits       SIM_SFR8(SFR_PORTC, PORTCbits_t)
+#define PORTD           SIM_SFR8(SFR_PORTD, uint8_t)
+#define PORTDbits       SIM_SFR8(SFR_PORTD, PORTDbits_t)
+#define PORTE           SIM_SFR8(SFR_PORTE, uint8_t)
+#define PORTEbits       SIM_SFR8(SFR_PORTE, PORTEbits_t)
+#define INTCON          SIM_SFR8(SFR_INTCON, uint8_t)
+#define INTCONbits      SIM_SFR8(SFR_INTCON, INTCONbits_t)
+#define PIR1            SIM_SFR8(SFR_PIR1, uint8_t)
+#define PIR1bits        SIM_SFR8(SFR_PIR1, PIR1bits_t)
+#define PIR2            SIM_SFR8(SFR_PIR2, uint8_t)
+#define PIR2bits        SIM_SFR8(SFR_PIR2, PIR2bits_t)
+#define TMR1            SIM_SFR16(SFR_TMR1L, uint16_t)
+#define TMR1L           SIM_SFR8(SFR_TMR1L, uint8_t)
+#define TMR1H           SIM_SFR8(SFR_TMR1H, uint8_t)
+#define T1CON           SIM_SFR8(SFR_T1CON, uint8_t)
+#define T1CONbits       SIM_SFR8(SFR_T1CON, T1CONbits_t)
+#define TMR2            SIM_SFR8(SFR_TMR2, uint8_t)
+#define T2CON           SIM_SFR8(SFR_T2CON, uint8_t)
+#define T2CONbits       SIM_SFR8(SFR_T2CON, T2CONbits_t)
+#define CCPR1L          SIM_SFR8(SFR_CCPR1L, uint8_t)
+#define CCPR1H          SIM_SFR8(SFR_CCPR1H, uint8_t)
+#define CCP1CON         SIM_SFR8(SFR_CCP1CON, uint8_t)
+#define CCP1CONbits     SIM_SFR8(SFR_CCP1CON, CCP1CONbits_t)
+#define RCSTA           SIM_SFR8(SFR_RCSTA, uint8_t)
+#define RCSTAbits       SIM_SFR8(SFR_RCSTA, RCSTAbits_t)
+#define TXREG           SIM_SFR8(SFR_TXREG, uint8_t)
+#define RCREG           SIM_SFR8(SFR_RCREG, uint8_t)
+#define ADRESH          SIM_SFR8(SFR_ADRESH, uint8_t)
+#define ADCON0          SIM_SFR8(SFR_ADCON0, uint8_t)
+#define ADCON0bits      SIM_SFR8(SFR_ADCON0, ADCON0bits_t)
+#define OPTION_REG      SIM_SFR8(SFR_OPTION_REG, uint8_t)
+#define OPTION_REGbits  SIM_SFR8(SFR_OPTION_REG, OPTION_REGbits_t)
+#define TRISA           SIM_SFR8(SFR_TRISA, uint8_t)
+#define TRISAbits       SIM_SFR8(SFR_TRISA, TRISAbits_t)
+#define TRISB           SIM_SFR8(SFR_TRISB, uint8_t)
+#define TRISBbits       SIM_SFR8(SFR_TRISB, TRISBbits_t)
+#define TRISC           SIM_SFR8(SFR_TRISC, uint8_t)
+#define TRISCbits       SIM_SFR8(SFR_TRISC, TRISCbits_t)
+#define TRISD           SIM_SFR8(SFR_TRISD, uint8_t)
+#define TRISDbits       SIM_SFR8(SFR_TRISD, TRISDbits_t)
+#define TRISE           SIM_SFR8(SFR_TRISE, uint8_t)
+#define TRISEbits       SIM_SFR8(SFR_TRISE, TRISEbits_t)
+#define PIE1            SIM_SFR8(SFR_PIE1, uint8_t)
+#define PIE1bits        SIM_SFR8(SFR_PIE1, PIE1bits_t)
+#define PIE2            SIM_SFR8(SFR_PIE2, uint8_t)
+#define PIE2bits        SIM_SFR8(SFR_PIE2, PIE2bits_t)
+#define PCON            SIM_SFR8(SFR_PCON, uint8_t)
+#define PCONbits        SIM_SFR8(SFR_PCON, PCONbits_t)
+#define OSCCON          SIM_SFR8(SFR_OSCCON, uint8_t)
+#define OSCCONbits      SIM_SFR8(SFR_OSCCON, OSCCONbits_t)
+#define PR2             SIM_SFR8(SFR_PR2, uint8_t)
+#define WPUB            SIM_SFR8(SFR_WPUB, uint8_t)
+#define WPUBbits        SIM_SFR8(SFR_WPUB, WPUBbits_t)
+#define IOCB            SIM_SFR8(SFR_IOCB, uint8_t)
+#define IOCBbits        SIM_SFR8(SFR_IOCB, IOCBbits_t)
+#define TXSTA           SIM_SFR8(SFR_TXSTA, uint8_t)
+#define TXSTAbits       SIM_SFR8(SFR_TXSTA, TXSTAbits_t)
+#define SPBRG           SIM_SFR8(SFR_SPBRG, uint8_t)
+#define SPBRGH          SIM_SFR8(SFR_SPBRGH, uint8_t)
+#define PWM1CON         SIM_SFR8(SFR_PWM1CON, uint8_t)
+#define PWM1CONbits     SIM_SFR8(SFR_PWM1CON, PWM1CONbits_t)
+#define ECCPAS          SIM_SFR8(SFR_ECCPAS, uint8_t)
+#define ECCPASbits      SIM_SFR8(SFR_ECCPAS, ECCPASbits_t)
+#define PSTRCON         SIM_SFR8(SFR_PSTRCON, uint8_t)
+#define PSTRCONbits     SIM_SFR8(SFR_PSTRCON, PSTRCONbits_t)
+#define ADRESL          SIM_SFR8(SFR_ADRESL, uint8_t)
+#define ADCON1          SIM_SFR8(SFR_ADCON1, uint8_t)
+#define ADCON1bits      SIM_SFR8(SFR_ADCON1, ADCON1bits_t)
+#define WDTCON          SIM_SFR8(SFR_WDTCON, uint8_t)
+#define WDTCONbits      SIM_SFR8(SFR_WDTCON, WDTCONbits_t)
+#define BAUDCTL         SIM_SFR8(SFR_BAUDCTL, uint8_t)
+#define BAUDCTLbits     SIM_SFR8(SFR_BAUDCTL, BAUDCTLbits_t)
+#define ANSEL           SIM_SFR8(SFR_ANSEL, uint8_t)
+#define ANSELbits       SIM_SFR8(SFR_ANSEL, ANSELbits_t)
+#define ANSELH          SIM_SFR8(SFR_ANSELH, uint8_t)
+#define ANSELHbits      SIM_SFR8(SFR_ANSELH, ANSELHbits_t)
+#define EEDAT           SIM_SFR8(SFR_EEDAT, uint8_t)
+#define EEDATA          EEDAT
+#define EEADR           SIM_SFR8(SFR_EEADR, uint8_t)
+#define EEDATH          SIM_SFR8(SFR_EEDATH, uint8_t)
+#define EEADRH          SIM_SFR8(SFR_EEADRH, uint8_t)
+#define EECON1          SIM_SFR8(SFR_EECON1, uint8_t)
+#define EECON1bits      SIM_SFR8(SFR_EECON1, EECON1bits_t)
+#define EECON2          SIM_SFR8(SFR_EECON2, uint8_t)
+
+#endif /* PIC16F887_H */
@@ -0,0 +1,1025 @@
+/*
+ * File:   sim.c
+ *
+ * PIC16F887 host simulator core.
+ *
+ * A sketch is compiled natively with -Dmain=sketch_main and linked against
+ * the simulator, so the sketch code runs as host code while all of its SFR
+ * traffic goes through sim_sfr(). The core:
+ *   - keeps the register file (sim_reg[], datasheet addresses)
+ *   - detects writes by comparing the last accessed register against a
+ *     snapshot taken when it was handed out (sim_commit)
+ *   - runs the instruction clock: Fosc follows OSCCON IRCF, and every
+ *     instruction cycle (SFR access, delay loop iteration, interrupt
+ *     entry/exit) advances simulated time by 4 Tosc
+ *   - is event driven: time jumps from one peripheral event (timer
+ *     overflow, ADC completion, WDT time-out, input edge, EUSART frame)
+ *     to the next, and delays, Sleep and polling loops are skipped over
+ *     in one go
+ *   - dispatches isr() when an enabled interrupt flag is pending and GIE
+ *     is set, the way the PIC vectors to 0x0004
+ *   - models Sleep: the CPU clock stops until a WDT time-out or an enabled
+ *     interrupt flag wakes it up
+ *   - stops the run once the time or cycle budget is used up and prints
+ *     a report
+ *
+ * Usage: <sketch> [-t seconds] [-n cycles] [-p PORT=level] [-s T:PORT=level[,ms]]
+ *                 [-l PORT] [-m PORT] [-a CH=code[,noise]] [-e FILE] [-b FILE] [-d SYMBOL=FILE]
+ *                 [-u FILE] [-r T:FILE] [-v]
+ */
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <link.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sim.h"
+
+sim_t   sim;
+uint8_t sim_reg[SIM_REG_SIZE];
+
+void sketch_main(void);             // the sketch's main(), renamed at build time
+void isr(void) __attribute__((weak));
+
+static sim_read_fn  read_hook[SIM_REG_SIZE];
+static sim_write_fn write_hook[SIM_REG_SIZE];
+static uint8_t      strobe[SIM_REG_SIZE];
+
+// register handed out by the last sim_sfr() call and its contents back then
+static struct {
+    uint16_t addr;
+    uint8_t  width;
+    uint8_t  snap[2];
+} pending;
+
+static sigjmp_buf done;
+
+// What happens around each wake-up, for the Sleep figures of the report
+static struct {
+    uint64_t woke;              // time of the last wake-up
+    int      waiting;           // no work done since then yet
+    uint64_t latency_min, latency_max, latency_sum, latencies;
+    uint64_t awake_max, awake_sum, awakes;
+} wake = { .latency_min = UINT64_MAX };
+
+// Time run at each IRCF setting, Sleep left out
+static struct {
+    int      ircf;
+    uint64_t since;             // accounted up to here
+    uint64_t slept;             //   with this much Sleep behind it
+    uint64_t ran[8];
+    uint64_t switches;
+} osc;
+
+#define RUN_FINISHED    1
+#define RUN_WDT_RESET   2
+#define RUN_PARKED      3
+
+// Calls from the sketch into the simulator: how deep, and how many so far
+static volatile sig_atomic_t sim_depth;
+static volatile sig_atomic_t sim_entries;
+
+// OSCCON IRCF<2:0> -> HFINTOSC/LFINTOSC frequency
+static const uint32_t ircf_hz[8] = {
+    31250, 125000, 250000, 500000, 1000000, 2000000, 4000000, 8000000
+};
+
+// Power-on reset values (datasheet "Value on POR, BOR" column)
+static const struct { uint16_t addr; uint8_t val; } por_values[] = {
+    { SFR_STATUS,     0x18 },
+    { SFR_OPTION_REG, 0xFF },
+    { SFR_TRISA,      0xFF },
+    { SFR_TRISB,      0xFF },
+    { SFR_TRISC,      0xFF },
+    { SFR_TRISD,      0xFF },
+    { SFR_TRISE,      0x0F },
+    { SFR_PCON,       0x10 },
+    { SFR_OSCCON,     0x60 },
+    { SFR_PR2,        0xFF },
+    { SFR_WPUB,       0xFF },
+    { SFR_PSTRCON,    0x01 },
+    { SFR_WDTCON,     0x08 },
+    { SFR_ANSEL,      0xFF },
+    { SFR_ANSELH,     0x3F },
+    { SFR_TXSTA,      0x02 },
+    { SFR_BAUDCTL,    0x40 },
+};
+
+void sim_hook(uint16_t addr, sim_read_fn rd, sim_write_fn wr)
+{
+    read_hook[addr] = rd;
+    write_hook[addr] = wr;
+}
+
+// Every store to addr is a write, even of the value it already holds
+// (TXREG: sending the same byte twice). Only for write-only registers.
+void sim_strobe(uint16_t addr)
+{
+    strobe[addr] = 1;
+}
+
+void sim_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if(!sim.verbose)
+        return;
+    printf("%12.6f  ", (double)sim.now / SIM_HZ);
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+    putchar('\n');
+}
+
+void sim_finish(void)
+{
+    siglongjmp(done, RUN_FINISHED);
+}
+
+void sim_wdt_reset(void)
+{
+    sim_log("WDT reset");
+    sim.wdt_resets++;
+    siglongjmp(done, RUN_WDT_RESET);
+}
+
+void sim_wake(void)
+{
+    sim.asleep = 0;
+}
+
+#define RUN_THROUGH     0               // advance(): go all the way to the target
+#define STOP_ON_IRQ     1               //   stop when the CPU has an interrupt or wake-up to take
+#define STOP_ON_EVENT   2               //   stop at the first peripheral event
+
+static uint32_t irq_active(void);
+static void irq_track(uint64_t t);
+static int irq_dispatchable(void);
+
+static uint64_t next_event(void)
+{
+    uint64_t next = timer_next_event();
+    uint64_t ev;
+
+    if((ev = adc_next_event()) < next)
+        next = ev;
+    if((ev = io_next_event()) < next)
+        next = ev;
+    if((ev = eeprom_next_event()) < next)
+        next = ev;
+    if((ev = eusart_next_event()) < next)
+        next = ev;
+    return next;
+}
+
+static void sync_all(uint64_t t)
+{
+    timer_sync(t);
+    adc_sync(t);
+    io_sync(t);
+    eeprom_sync(t);
+    eusart_sync(t);
+    power_sync(t);
+}
+
+// Move the clock to t; instruction cycles only run while awake
+static void set_now(uint64_t t)
+{
+    if(!sim.asleep)
+    {
+        uint64_t ticks = sim.cycle_ticks + (t - sim.now);
+
+        sim.cycles += ticks / sim.tcy;
+        sim.cycle_ticks = ticks % sim.tcy;
+    }
+    sim.now = t;
+}
+
+static void check_limits(void)
+{
+    if(sim.now >= sim.time_limit || sim.cycles >= sim.cycle_limit)
+        sim_finish();
+}
+
+/*
+ * Run simulated time forward to 'target', jumping from one peripheral
+ * event to the next instead of stepping instruction cycles. Returns 1 if
+ * it stopped early as requested by 'mode'; when awake, it then stops on
+ * the instruction cycle boundary that follows the event.
+ */
+static int advance(uint64_t target, int mode)
+{
+    uint64_t start = sim.now;
+    int was_asleep = sim.asleep;
+    uint64_t ev;
+
+    if(target > sim.time_limit)
+        target = sim.time_limit;
+    if(!sim.asleep && sim.cycle_limit != UINT64_MAX)
+    {
+        uint64_t left = (sim.cycle_limit - sim.cycles) * sim.tcy - sim.cycle_ticks;
+
+        if(target - sim.now > left)
+            target = sim.now + left;
+    }
+
+    while((ev = next_event()) <= target)
+    {
+        if(ev < sim.now)
+            ev = sim.now;
+        set_now(ev);
+        sync_all(ev);
+        irq_track(ev);
+        sim.events++;
+        if(mode == RUN_THROUGH)
+            continue;
+        if(mode == STOP_ON_EVENT || sim.asleep != was_asleep
+           || (sim.asleep ? irq_active() != 0 : irq_dispatchable()))
+        {
+            if(!sim.asleep)
+            {
+                uint64_t t = start + (ev - start + sim.tcy - 1) / sim.tcy * sim.tcy;
+
+                advance(t < target ? t : target, RUN_THROUGH);
+            }
+            check_limits();
+            return 1;
+        }
+    }
+    set_now(target);
+    sync_all(target);
+    check_limits();
+    return 0;
+}
+
+void sim_cycles(uint32_t n)
+{
+    advance(sim.now + (uint64_t)n * sim.tcy, RUN_THROUGH);
+}
+
+// Interrupt, Sleep and clock housekeeping does not count as work
+static int housekeeping(uint16_t addr)
+{
+    switch(addr)
+    {
+    case SFR_STATUS:
+    case SFR_INTCON:
+    case SFR_PIR1:
+    case SFR_PIR2:
+    case SFR_PIE1:
+    case SFR_PIE2:
+    case SFR_OPTION_REG:
+    case SFR_OSCCON:
+    case SFR_WDTCON:
+        return 1;
+    }
+    return 0;
+}
+
+// First write of real work after a wake-up
+static void wake_work(uint16_t addr)
+{
+    uint64_t latency = sim.now - wake.woke;
+
+    if(housekeeping(addr))
+        return;
+    wake.waiting = 0;
+    if(latency < wake.latency_min)
+        wake.latency_min = latency;
+    if(latency > wake.latency_max)
+        wake.latency_max = latency;
+    wake.latency_sum += latency;
+    wake.latencies++;
+}
+
+/*
+ * Hand the previous access over to the peripheral models: whatever the
+ * sketch changed in that register since sim_sfr() returned it is a write.
+ */
+int sim_commit(void)
+{
+    int wrote = 0;
+    uint8_t i;
+
+    if(!pending.width)
+        return 0;
+    for(i = 0; i < pending.width; i++)
+    {
+        uint16_t addr = pending.addr + i;
+        uint8_t val = sim_reg[addr];
+
+        if(val == pending.snap[i] && !strobe[addr])
+            continue;
+        wrote = 1;
+        if(wake.waiting)
+            wake_work(addr);
+        if(write_hook[addr])
+            write_hook[addr](addr, pending.snap[i], val);
+    }
+    pending.width = 0;
+    if(wrote)
+        power_sync(sim.now);
+    return wrote;
+}
+
+// Enabled interrupt flags, regardless of GIE: INTCON<2:0>, PIR1 << 8, PIR2 << 16
+static uint32_t irq_active(void)
+{
+    uint8_t intcon = sim_reg[SFR_INTCON];
+    uint32_t active;
+
+    active = intcon & (intcon >> 3) & 0x07;             // T0IF/INTF/RBIF vs. their IE bits
+    if(intcon & 0x40)                                   // PEIE
+        active |= (uint32_t)(sim_reg[SFR_PIR1] & sim_reg[SFR_PIE1]) << 8
+                | (uint32_t)(sim_reg[SFR_PIR2] & sim_reg[SFR_PIE2]) << 16;
+    return active;
+}
+
+// When each enabled flag went up, for the interrupt latency figures
+static struct {
+    uint32_t seen;
+    uint64_t since[24];
+} irq_age;
+
+static void irq_track(uint64_t t)
+{
+    uint32_t active = irq_active();
+    uint32_t raised = active & ~irq_age.seen;
+    int i;
+
+    for(i = 0; raised; i++, raised >>= 1)
+        if(raised & 1)
+            irq_age.since[i] = t;
+    irq_age.seen = active;
+}
+
+// Time since the oldest enabled flag went up
+static uint64_t irq_waiting(void)
+{
+    uint64_t oldest = sim.now;
+    int i;
+
+    for(i = 0; i < 24; i++)
+        if((irq_age.seen >> i & 1) && irq_age.since[i] < oldest)
+            oldest = irq_age.since[i];
+    return sim.now - oldest;
+}
+
+static int irq_dispatchable(void)
+{
+    return (sim_reg[SFR_INTCON] & 0x80) && !sim.in_isr && isr && irq_active();
+}
+
+void sim_irq_check(void)
+{
+    uint64_t entry, latency;
+
+    irq_track(sim.now);
+    if(!irq_dispatchable())
+        return;
+
+    sim_reg[SFR_INTCON] &= ~0x80;                       // hardware clears GIE
+    sim.in_isr = 1;
+    sim.irq_count++;
+    entry = sim.cycles;
+    sim_cycles(SIM_IRQ_LATENCY + SIM_ISR_PROLOGUE);
+    latency = irq_waiting() / sim.tcy;
+    isr();
+    sim_commit();
+    sim_cycles(SIM_ISR_EPILOGUE + SIM_RETFIE_CYCLES);
+    sim_reg[SFR_INTCON] |= 0x80;                        // RETFIE sets GIE
+    sim.in_isr = 0;
+    irq_track(sim.now);
+    bench_irq(latency, sim.cycles - entry);
+}
+
+static void run_read_hooks(uint16_t addr, uint8_t width)
+{
+    uint8_t i;
+
+    for(i = 0; i < width; i++)
+        if(read_hook[addr + i])
+            read_hook[addr + i](addr + i);
+}
+
+/*
+ * The same register read over and over from the same place in the sketch,
+ * with nothing written in between and the same value each time, is a
+ * polling loop ('while(!INTCONbits.T0IF);'). Nothing the loop does can
+ * change the outcome, so skip to the next peripheral event instead of
+ * spinning through it. The call site matters: a run of bit stores that
+ * happen not to change anything looks the same from the register side.
+ *
+ * A wait on a flag in RAM ('while(!sampleReady) NOP();') reads no register
+ * at all; sim_nop() below deals with those.
+ */
+
+static struct {
+    uint16_t    addr;
+    const void *site;
+    uint8_t     val;
+    int         count;
+} poll;
+
+static int polling(uint16_t addr, const void *site, int wrote)
+{
+    uint8_t val = sim_reg[addr];
+
+    if(wrote || addr != poll.addr || site != poll.site || val != poll.val)
+    {
+        poll.addr = addr;
+        poll.site = site;
+        poll.val = val;
+        poll.count = 0;
+        return 0;
+    }
+    if(++poll.count < SIM_SPIN_POLLS)
+        return 0;
+    poll.count = 0;
+    return 1;
+}
+
+volatile void *sim_sfr(uint16_t addr, uint8_t width)
+{
+    uint8_t i;
+    int wrote;
+
+    sim_depth++;
+    sim_entries++;
+    wrote = sim_commit();
+    sim.sfr_accesses++;
+    sim_cycles(SIM_SFR_CYCLES);
+    sim_irq_check();
+
+    run_read_hooks(addr, width);
+    if(!sim.in_isr && polling(addr, __builtin_return_address(0), wrote))
+    {
+        sim.spins++;
+        advance(SIM_NEVER, STOP_ON_EVENT);
+        sim_irq_check();
+        run_read_hooks(addr, width);
+    }
+
+    pending.addr = addr;
+    pending.width = width;
+    for(i = 0; i < width; i++)
+        pending.snap[i] = sim_reg[addr + i];
+    sim_depth--;
+    return &sim_reg[addr];
+}
+
+// 'cycles' instruction cycles with interrupts serviced as they come
+static void run_cycles(uint32_t cycles)
+{
+    sim_irq_check();
+    while(cycles)
+    {
+        uint64_t start = sim.now;
+
+        if(!advance(start + (uint64_t)cycles * sim.tcy, STOP_ON_IRQ))
+            break;
+        cycles -= (uint32_t)((sim.now - start) / sim.tcy);
+        sim_irq_check();
+    }
+    sim_irq_check();
+}
+
+/*
+ * Busy-wait of 'cycles' instruction cycles. Interrupts are serviced while
+ * the delay runs and, as on the part, the time spent in isr() is added on
+ * top of the delay rather than taken out of it.
+ */
+void sim_delay(uint32_t cycles)
+{
+    int wrote, timed = cycles != 1;
+
+    sim_depth++;
+    sim_entries++;
+    wrote = sim_commit();
+
+    if(wrote || timed)
+        poll.site = NULL;
+    if(timed)
+        bench_delay_begin(__builtin_return_address(0));
+    run_cycles(cycles);
+    if(timed)
+        bench_delay_end(__builtin_return_address(0));
+    sim_depth--;
+}
+
+/*
+ * NOP(). A loop waiting on a flag in RAM that only isr() can set
+ * ('while(!sampleReady) NOP();') comes back to the same NOP() with
+ * nothing else in between: no SFR access, delay or interrupt, and the
+ * sketch itself unchanged, that is its globals, its stack and the
+ * registers it keeps across the call. From there it can only do the same
+ * thing again until an interrupt changes something, so it is parked until
+ * the next one. A counted loop ('for(i = 0; i < 10; i++) NOP();') changes
+ * its counter every time round and still costs one cycle per NOP().
+ *
+ * The sketch's globals are its data and bss sections, renamed by the
+ * Makefile so the linker marks where they start and end. Its stack runs
+ * from sim_nop()'s frame, where __builtin_unwind_init() has put the
+ * callee-saved registers, up to main()'s frame.
+ */
+extern uint8_t __start_sketch_data[] __attribute__((weak));
+extern uint8_t __stop_sketch_data[] __attribute__((weak));
+extern uint8_t __start_sketch_bss[] __attribute__((weak));
+extern uint8_t __stop_sketch_bss[] __attribute__((weak));
+
+static const uint8_t *stack_top;        // in main()'s frame, above sketch_main()'s
+
+static struct {
+    const void   *site;
+    sig_atomic_t  entries;              // sim_entries when it returned
+    uint8_t      *state;                // globals and stack at that NOP()
+    size_t        size;
+} idle;
+
+// Compare the sketch with the last snapshot and take a new one
+static int idle_same(const uint8_t *low)
+{
+    size_t data = __stop_sketch_data - __start_sketch_data;
+    size_t bss = __stop_sketch_bss - __start_sketch_bss;
+    size_t stack = stack_top - low;
+    size_t size = data + bss + stack;
+    uint8_t *state;
+
+    if(size == idle.size
+       && !memcmp(idle.state, __start_sketch_data, data)
+       && !memcmp(idle.state + data, __start_sketch_bss, bss)
+       && !memcmp(idle.state + data + bss, low, stack))
+        return 1;
+
+    if(size != idle.size)
+    {
+        if(!(state = realloc(idle.state, size)))
+        {
+            perror("sim_nop");
+            exit(1);
+        }
+        idle.state = state;
+        idle.size = size;
+    }
+    memcpy(idle.state, __start_sketch_data, data);
+    memcpy(idle.state + data, __start_sketch_bss, bss);
+    memcpy(idle.state + data + bss, low, stack);
+    return 0;
+}
+
+static __attribute__((noinline)) void nop(const void *site)
+{
+    const uint8_t *low = __builtin_dwarf_cfa();     // sim_nop()'s frame
+    int wrote, same;
+
+    sim_depth++;
+    sim_entries++;
+    wrote = sim_commit();
+
+    if(wrote)
+        poll.site = NULL;
+    same = idle_same(low);
+    if(same && !wrote && !sim.in_isr && site == idle.site && sim_entries == idle.entries + 1)
+    {
+        uint64_t irqs = sim.irq_count;
+
+        sim.spins++;
+        sim_irq_check();
+        if(sim.irq_count == irqs)           // isr() may just have set the flag
+        {
+            advance(SIM_NEVER, STOP_ON_IRQ);
+            sim_irq_check();
+        }
+        sim_irq_check();                    // as run_cycles(): one more right after RETFIE
+    }
+    else
+        run_cycles(1);
+    idle.site = site;
+    idle.entries = sim_entries;
+    sim_depth--;
+}
+
+void sim_nop(void)
+{
+    __builtin_unwind_init();                // callee-saved registers onto the stack
+    nop(__builtin_return_address(0));
+    __asm__ volatile("" ::: "memory");      // keep this frame: no tail call
+}
+
+void sim_sleep(void)
+{
+    sim_depth++;
+    sim_entries++;
+    sim_commit();
+    poll.site = NULL;
+    sim_cycles(1);
+    wdt_clear();
+    sim_reg[SFR_STATUS] = (sim_reg[SFR_STATUS] & ~0x08) | 0x10;    // nPD = 0, nTO = 1
+    sync_all(sim.now);
+    adc_sleep();
+    if(sim.wakeups)
+    {
+        uint64_t awake = sim.now - wake.woke;
+
+        if(awake > wake.awake_max)
+            wake.awake_max = awake;
+        wake.awake_sum += awake;
+        wake.awakes++;
+    }
+    sim.asleep = 1;
+    sim.sleep_since = sim.now;
+    power_sync(sim.now);
+    sim_log("SLEEP");
+    if(!irq_active())
+        advance(SIM_NEVER, STOP_ON_IRQ);
+    sync_all(sim.now);
+    sim.asleep = 0;
+    sim.slept += sim.now - sim.sleep_since;
+    power_sync(sim.now);
+    sim.wakeups++;
+    wake.woke = sim.now;
+    wake.waiting = 1;
+    sim_log("wake-up");
+    sim_cycles(1);                              // instruction after SLEEP
+    sim_irq_check();
+    sim_depth--;
+}
+
+void sim_clrwdt(void)
+{
+    sim_depth++;
+    sim_entries++;
+    sim_commit();
+    poll.site = NULL;
+    sim_cycles(1);
+    wdt_clear();
+    sim_reg[SFR_STATUS] |= 0x18;                // nPD = 1, nTO = 1
+    sim_depth--;
+}
+
+static uint64_t slept_so_far(void)
+{
+    return sim.slept + (sim.asleep ? sim.now - sim.sleep_since : 0);
+}
+
+static void osc_account(void)
+{
+    uint64_t slept = slept_so_far();
+
+    osc.ran[osc.ircf] += sim.now - osc.since - (slept - osc.slept);
+    osc.since = sim.now;
+    osc.slept = slept;
+}
+
+static void osccon_write(uint16_t addr, uint8_t old, uint8_t val)
+{
+    uint8_t ircf = (val >> 4) & 7;
+
+    (void)addr; (void)old;
+    if(sim.tcy)
+        sync_all(sim.now);
+    osc_account();
+    if(sim.tcy && ircf != osc.ircf)
+        osc.switches++;
+    osc.ircf = ircf;
+    sim.fosc = ircf_hz[ircf];
+    sim.tcy = (uint32_t)(4 * SIM_HZ / sim.fosc);
+    sim.cycle_ticks = 0;
+    // internal oscillator, stable at once: HTS for HFINTOSC, LTS for LFINTOSC
+    sim_reg[SFR_OSCCON] = (val & 0x71) | (ircf ? 0x04 : 0x02);
+    sim_log("Fosc %u Hz", sim.fosc);
+}
+
+static void reset(void)
+{
+    size_t i;
+
+    memset(sim_reg, 0, sizeof(sim_reg));
+    for(i = 0; i < sizeof(por_values) / sizeof(por_values[0]); i++)
+        sim_reg[por_values[i].addr] = por_values[i].val;
+    pending.width = 0;
+    sim.in_isr = 0;
+    sim.asleep = 0;
+    timer_init();
+    ccp_init();
+    adc_init();
+    eeprom_init();
+    eusart_init();
+    sim_hook(SFR_OSCCON, NULL, osccon_write);
+    osccon_write(SFR_OSCCON, 0, sim_reg[SFR_OSCCON]);
+    power_sync(sim.now);
+}
+
+/*
+ * A sketch that ends in an empty 'while(1){}' never calls back into the
+ * simulator. A host interval timer notices that the sketch has not called
+ * in for two ticks in a row while outside the simulator, and jumps back to
+ * main(), which carries on without it: the CPU is parked in a loop, so
+ * only the peripherals and isr() can still do anything. The handler only
+ * looks at two counters and jumps; everything else happens in park().
+ * Simulated time stands still while the sketch spins, so the run does not
+ * depend on how long the host took to notice.
+ */
+static void park_watch(int sig)
+{
+    static sig_atomic_t last_entries, strikes;
+
+    (void)sig;
+    if(sim_depth || sim_entries != last_entries)
+    {
+        last_entries = sim_entries;
+        strikes = 0;
+        return;
+    }
+    if(++strikes < 2)
+        return;
+    strikes = 0;
+    siglongjmp(done, RUN_PARKED);
+}
+
+static void park_watch_arm(int on)
+{
+    struct itimerval every = { { 0, on ? 100000 : 0 }, { 0, on ? 100000 : 0 } };
+
+    setitimer(ITIMER_REAL, &every, NULL);
+}
+
+static void park(void)
+{
+    sim_commit();
+    sim_log("main() is spinning without touching any SFR");
+    for(;;)
+    {
+        sim_irq_check();
+        advance(SIM_NEVER, STOP_ON_IRQ);
+    }
+}
+
+// WDT reset: registers go back to their reset values, port latches are kept
+static void wdt_reset(void)
+{
+    reset();
+    sim_reg[SFR_STATUS] &= ~0x10;               // nTO = 0
+}
+
+static void report(FILE *out, double host_seconds)
+{
+    double seconds = (double)sim.now / SIM_HZ;
+
+    fprintf(out, "sketch:       %s\n", sim.name);
+    fprintf(out, "sim time:     %.6f s\n", seconds);
+    fprintf(out, "Fosc:         %u Hz\n", sim.fosc);
+    fprintf(out, "cycles:       %llu\n", (unsigned long long)sim.cycles);
+    fprintf(out, "sfr accesses: %llu\n", (unsigned long long)sim.sfr_accesses);
+    fprintf(out, "interrupts:   %llu\n", (unsigned long long)sim.irq_count);
+    fprintf(out, "events:       %llu (%llu polling loops skipped)\n",
+            (unsigned long long)sim.events, (unsigned long long)sim.spins);
+    fprintf(out, "WDT resets:   %llu\n", (unsigned long long)sim.wdt_resets);
+    if(osc.switches)
+    {
+        uint64_t ran = 0;
+        int i;
+
+        osc_account();
+        for(i = 0; i < 8; i++)
+            ran += osc.ran[i];
+        fprintf(out, "clock:        %llu switches, running at", (unsigned long long)osc.switches);
+        for(i = 7; i >= 0; i--)
+            if(osc.ran[i])
+                fprintf(out, i >= 4 ? "  %g MHz %.2f%%" : "  %g kHz %.2f%%",
+                        i >= 4 ? ircf_hz[i] / 1e6 : ircf_hz[i] / 1e3, 100.0 * osc.ran[i] / ran);
+        fprintf(out, "\n");
+    }
+    if(sim.wakeups || sim.asleep)
+    {
+        uint64_t slept = slept_so_far();
+
+        fprintf(out, "asleep:       %.6f s (%.2f%%)  wake-ups %llu\n", (double)slept / SIM_HZ,
+                sim.now ? 100.0 * slept / sim.now : 0.0, (unsigned long long)sim.wakeups);
+        if(wake.awakes)
+            fprintf(out, "              awake per wake-up %.1f us avg, %.1f us max\n",
+                    1e6 * wake.awake_sum / wake.awakes / SIM_HZ, 1e6 * wake.awake_max / SIM_HZ);
+        if(wake.latencies)
+            fprintf(out, "              wake-up to first work %.1f / %.1f / %.1f us (min/avg/max)\n",
+                    1e6 * wake.latency_min / SIM_HZ, 1e6 * wake.latency_sum / wake.latencies / SIM_HZ,
+                    1e6 * wake.latency_max / SIM_HZ);
+    }
+    fprintf(out, "host time:    %.3f s (%.0fx real time)\n", host_seconds,
+            host_seconds > 0 ? seconds / host_seconds : 0.0);
+    io_report(out);
+    timer_report(out);
+    ccp_report(out);
+    adc_report(out);
+    eeprom_report(out);
+    eusart_report(out);
+    power_report(out);
+}
+
+// Write the bytes of a sketch global to a file, the way a debugger memory
+// dump would. The size comes from the symbol table (-rdynamic exports it).
+static void dump_symbol(const char *spec)
+{
+    char name[64];
+    const char *eq = strchr(spec, '=');
+    const ElfW(Sym) *sym = NULL;
+    Dl_info info;
+    void *addr;
+    FILE *f;
+
+    if(!eq || eq - spec >= (int)sizeof(name))
+        return;
+    memcpy(name, spec, eq - spec);
+    name[eq - spec] = 0;
+    addr = dlsym(RTLD_DEFAULT, name);
+    if(!addr || !dladdr1(addr, &info, (void **)&sym, RTLD_DL_SYMENT) || !sym || !sym->st_size)
+    {
+        fprintf(stderr, "%s: no variable '%s' to dump\n", sim.name, name);
+        return;
+    }
+    f = fopen(eq + 1, "wb");
+    if(!f || fwrite(addr, 1, sym->st_size, f) != sym->st_size)
+        fprintf(stderr, "%s: cannot write %s\n", sim.name, eq + 1);
+    if(f)
+        fclose(f);
+}
+
+// -r T:FILE
+static void serial_input(double at, const char *path)
+{
+    uint8_t data[4096];
+    size_t n;
+    FILE *f = fopen(path, "rb");
+
+    if(!f)
+    {
+        perror(path);
+        exit(1);
+    }
+    while((n = fread(data, 1, sizeof(data), f)) > 0)
+        eusart_add_input((uint64_t)(at * SIM_HZ), data, n);
+    fclose(f);
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "usage: %s [-t seconds] [-n cycles] [-p PORT=level] [-s T:PORT=level[,ms]]\n"
+        "          [-l PORT] [-m PORT] [-a CH=code[,noise]] [-e FILE] [-b FILE] [-d SYMBOL=FILE]\n"
+        "          [-u FILE] [-r T:FILE] [-v]\n"
+        "  -t seconds      simulated time to run (default 10)\n"
+        "  -n cycles       instruction cycle budget (default unlimited)\n"
+        "  -p PORT=level   external level on the input pins of PORTA..PORTE,\n"
+        "                  e.g. -p B=0x00 holds SW1 (RB0) pressed\n"
+        "  -s T:PORT=level change the external level at T seconds,\n"
+        "                  e.g. -s 1.5:B=0x00 -s 1.7:B=0x01 presses SW1\n"
+        "  -s T:PORT=level,ms\n"
+        "                  the same, with the changed pins bouncing for ms\n"
+        "  -l PORT         measure how long PORT takes to answer each input\n"
+        "                  change, e.g. -l D for the LEDs\n"
+        "  -m PORT         report the duty cycle of every output pin of PORT\n"
+        "  -a CH=code[,noise]\n"
+        "                  input of analog channel CH in LSB, fractions allowed,\n"
+        "                  plus Gaussian noise of the given RMS (AN0 default 512)\n"
+        "  -e FILE         data EEPROM image, loaded at start and saved at the end\n"
+        "  -b FILE         append SFR cycles per call, interrupt latency and loop\n"
+        "                  timing to FILE as a tab separated table\n"
+        "  -d SYMBOL=FILE  write the sketch variable SYMBOL to FILE at the end,\n"
+        "                  e.g. -d traceBuf=trace.bin (may be repeated)\n"
+        "  -u FILE         write the bytes the EUSART transmits to FILE (a file,\n"
+        "                  a FIFO or a pseudo-terminal)\n"
+        "  -r T:FILE       the bytes of FILE arrive on the EUSART from T seconds on\n"
+        "  -v              log every output pin change\n",
+        sim.name);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    struct timespec t0, t1;
+    const char *slash;
+    char *end;
+    double at, level;
+    static const char *bench_path;  // static: live across sigsetjmp()
+    const char *dumps[8];
+    int dump_count = 0;
+    int opt;
+
+    slash = strrchr(argv[0], '/');
+    sim.name = slash ? slash + 1 : argv[0];
+    sim.time_limit = 10 * SIM_HZ;
+    sim.cycle_limit = UINT64_MAX;
+    io_init();
+    reset();
+
+    while((opt = getopt(argc, argv, "t:n:p:s:l:m:a:e:b:d:u:r:vh")) != -1)
+    {
+        switch(opt)
+        {
+        case 't':
+            sim.time_limit = (uint64_t)(strtod(optarg, NULL) * SIM_HZ);
+            break;
+        case 'n':
+            sim.cycle_limit = strtoull(optarg, NULL, 0);
+            break;
+        case 'p':
+            if(optarg[0] < 'A' || optarg[0] > 'E' || optarg[1] != '=')
+                usage();
+            io_set_input(optarg[0] - 'A', (uint8_t)strtoul(optarg + 2, NULL, 0));
+            break;
+        case 's':
+            at = strtod(optarg, &end);
+            if(*end != ':' || end[1] < 'A' || end[1] > 'E' || end[2] != '=')
+                usage();
+            opt = end[1] - 'A';
+            level = strtoul(end + 3, &end, 0);
+            io_add_stimulus((uint64_t)(at * SIM_HZ), opt, (uint8_t)level,
+                            *end == ',' ? (uint64_t)(strtod(end + 1, NULL) / 1e3 * SIM_HZ) : 0);
+            break;
+        case 'l':
+        case 'm':
+            if(optarg[0] < 'A' || optarg[0] > 'E' || optarg[1])
+                usage();
+            if(opt == 'l')
+                io_watch(optarg[0] - 'A');
+            else
+                io_measure_duty(optarg[0] - 'A');
+            break;
+        case 'a':
+            opt = (int)strtol(optarg, &end, 10);
+            if(*end != '=')
+                usage();
+            level = strtod(end + 1, &end);
+            adc_set_input(opt, level, *end == ',' ? strtod(end + 1, NULL) : 0);
+            break;
+        case 'e':
+            eeprom_load(optarg);
+            break;
+        case 'b':
+            bench_path = optarg;
+            break;
+        case 'd':
+            if(!strchr(optarg, '=') || dump_count == 8)
+                usage();
+            dumps[dump_count++] = optarg;
+            break;
+        case 'u':
+            eusart_open(optarg);
+            break;
+        case 'r':
+            at = strtod(optarg, &end);
+            if(*end != ':')
+                usage();
+            serial_input(at, end + 1);
+            break;
+        case 'v':
+            sim.verbose = 1;
+            break;
+        default:
+            usage();
+        }
+    }
+
+    signal(SIGALRM, park_watch);
+    stack_top = __builtin_frame_address(0);
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    switch(sigsetjmp(done, 1))
+    {
+    case RUN_WDT_RESET:
+        // C globals keep their values: there is no XC8 startup code to re-run
+        sim_depth = 0;
+        wdt_reset();
+        bench_restart();
+        /* fall through */
+    case 0:
+        park_watch_arm(1);
+        sketch_main();
+        sim_commit();
+        sim_log("main() returned");
+        break;
+    case RUN_PARKED:
+        park_watch_arm(0);
+        park();
+        break;
+    case RUN_FINISHED:
+        break;
+    }
+    park_watch_arm(0);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    report(stdout, (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9);
+    if(bench_path)
+        bench_report(bench_path);
+    for(opt = 0; opt < dump_count; opt++)
+        dump_symbol(dumps[opt]);
+    eeprom_save();
+    eusart_close();
+    return 0;
+}
@@ -0,0 +1,145 @@
+/*
+ * File:   sim.h
+ *
+ * Internal interface of the PIC16F887 host simulator.
+ *
+ * sim.c owns the register file, the clock and the interrupt logic; every
+ * peripheral model (sim_io.c, sim_timer.c, ...) attaches itself to the
+ * registers it implements with sim_hook().
+ *
+ * Peripherals are event driven. Each one exports
+ *   xxx_next_event()   absolute time of the next thing it will do on its
+ *                      own (set a flag, wake the CPU), or SIM_NEVER
+ *   xxx_sync(t)        bring its state up to time t, firing any event due
+ * and relies on the core to call xxx_sync(now) before sim.tcy or
+ * sim.asleep change, so that both are constant between two syncs.
+ *
+ * Simulated time is kept in ticks of SIM_HZ. 512 MHz is the smallest rate
+ * that divides into a whole number of ticks every clock the part can run
+ * from: HFINTOSC/LFINTOSC (8 MHz .. 31.25 kHz) and the 32.768 kHz Timer1
+ * crystal.
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "pic16f887.h"
+
+// Cycles charged by the core for things the host compiler does not see
+#define SIM_SFR_CYCLES      1       // MOVF/MOVWF/BSF/BCF on an SFR
+#define SIM_IRQ_LATENCY     3       // interrupt entry (datasheet: 3-4 Tcy)
+#define SIM_ISR_PROLOGUE    6       // XC8 context save (W, STATUS, PCLATH)
+#define SIM_ISR_EPILOGUE    6       // context restore
+#define SIM_RETFIE_CYCLES   2
+
+#define SIM_SPIN_POLLS      3       // identical reads in a row that make a polling loop
+
+#define SIM_HZ              512000000ULL
+#define SIM_NEVER           UINT64_MAX
+#define SIM_LFINTOSC_TICKS  (SIM_HZ / 31250)    // WDT clock
+#define SIM_T1OSC_TICKS     (SIM_HZ / 32768)    // Timer1 crystal
+
+typedef void (*sim_read_fn)(uint16_t addr);
+typedef void (*sim_write_fn)(uint16_t addr, uint8_t old, uint8_t val);
+
+typedef struct {
+    uint64_t now;               // simulated time, SIM_HZ ticks
+    uint64_t time_limit;        // stop once now reaches this
+    uint32_t fosc;              // current system clock, Hz
+    uint32_t tcy;               // ticks per instruction cycle (4 Tosc)
+    uint64_t cycles;            // instruction cycles executed so far
+    uint64_t cycle_limit;       // stop once cycles reaches this
+    uint32_t cycle_ticks;       // ticks of the instruction cycle in progress
+    uint64_t sfr_accesses;
+    uint64_t events;            // peripheral events the core stopped at
+    uint64_t spins;             // polling loops fast-forwarded
+    uint64_t irq_count;
+    int      verbose;
+    int      in_isr;
+    int      asleep;
+    uint64_t slept;             // ticks spent in Sleep, up to sleep_since
+    uint64_t sleep_since;
+    uint64_t wakeups;
+    uint64_t wdt_resets;
+    const char *name;           // sketch name for reports
+} sim_t;
+
+extern sim_t   sim;
+extern uint8_t sim_reg[SIM_REG_SIZE];
+
+// sim.c
+void sim_hook(uint16_t addr, sim_read_fn rd, sim_write_fn wr);
+void sim_strobe(uint16_t addr);
+void sim_cycles(uint32_t n);
+int sim_commit(void);
+void sim_irq_check(void);
+void sim_finish(void);
+void sim_log(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+void sim_wdt_reset(void);
+void sim_wake(void);
+
+// sim_io.c
+#define SIM_PORT_COUNT  5       // PORTA..PORTE
+void io_init(void);
+uint64_t io_next_event(void);
+void io_sync(uint64_t t);
+void io_set_input(int port, uint8_t level);
+void io_option_write(void);
+void io_add_stimulus(uint64_t at, int port, uint8_t level, uint64_t bounce);
+void io_watch(int port);
+void io_measure_duty(int port);
+uint8_t io_pins(int port);
+void io_report(FILE *out);
+
+// sim_timer.c
+void timer_init(void);
+uint64_t timer_next_event(void);
+void timer_sync(uint64_t t);
+void wdt_clear(void);
+void timer_report(FILE *out);
+
+// sim_ccp.c
+void ccp_init(void);
+void ccp_periods(uint64_t n, uint8_t pr2, uint32_t prescale);
+double ccp_duty(void);
+void ccp_report(FILE *out);
+
+// sim_adc.c
+void adc_init(void);
+uint64_t adc_next_event(void);
+void adc_sync(uint64_t t);
+void adc_set_input(int channel, double value, double noise);
+void adc_sleep(void);
+void adc_report(FILE *out);
+
+// sim_eeprom.c
+void eeprom_init(void);
+uint64_t eeprom_next_event(void);
+void eeprom_sync(uint64_t t);
+void eeprom_load(const char *path);
+void eeprom_save(void);
+void eeprom_report(FILE *out);
+
+// sim_eusart.c
+void eusart_init(void);
+uint64_t eusart_next_event(void);
+void eusart_sync(uint64_t t);
+void eusart_add_input(uint64_t at, const uint8_t *data, size_t n);
+void eusart_open(const char *path);
+void eusart_close(void);
+void eusart_report(FILE *out);
+
+// sim_power.c
+void power_sync(uint64_t t);
+void power_report(FILE *out);
+
+// sim_bench.c
+void bench_irq(uint64_t latency, uint64_t cycles);
+void bench_delay_begin(const void *site);
+void bench_delay_end(const void *site);
+void bench_restart(void);
+void bench_report(const char *path);
+
+#endif /* SIM_H */
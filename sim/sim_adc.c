@@ -0,0 +1,179 @@
+/*
+ * File:   sim_adc.c
+ *
+ * 10-bit A/D converter.
+ *
+ * Setting GO/DONE with ADON = 1 starts a conversion of the channel
+ * selected by CHS. It takes 11 TAD, TAD being Fosc/2, Fosc/8, Fosc/32
+ * (ADCS = 00/01/10) or the ~4 us dedicated FRC oscillator (ADCS = 11).
+ * On completion GO/DONE is cleared, ADIF is set and the result is stored
+ * in ADRESH:ADRESL justified according to ADFM.
+ *
+ * The channel is sampled when GO/DONE is set. The holding capacitor must
+ * have been connected to that channel for at least ADC_TACQ since CHS last
+ * changed (or since ADON/the previous conversion); shorter acquisitions
+ * are counted and reported, the result is taken as if it had settled.
+ *
+ * Channel inputs are analog levels in LSB (fractions allowed) plus an
+ * optional Gaussian noise of the given RMS in LSB, rounded to a 10-bit
+ * code at GO; noise makes oversampling gain resolution as on a real
+ * board. AN0 defaults to mid-scale, the
+ * position of the RP1 potentiometer on the demo board. CHS = 14 is CVREF
+ * (the comparator reference is not modelled and reads 0) and CHS = 15 the
+ * 0.6 V fixed reference.
+ *
+ * Only the FRC clock keeps running in Sleep: a conversion clocked from
+ * Fosc is aborted by SLEEP, one on FRC completes and its ADIF can wake
+ * the CPU (the low-noise way to convert).
+ */
+
+#include "sim.h"
+
+#define ADC_CHANNELS    16
+#define ADC_TAD_CYCLES  11
+#define ADC_FRC_TAD     (SIM_HZ * 4 / 1000000)      // 4 us
+#define ADC_TACQ        (SIM_HZ * 5 / 1000000)      // 5 us, as main_adc.c waits
+
+static struct {
+    double   input[ADC_CHANNELS];               // LSB
+    double   noise[ADC_CHANNELS];               // RMS, LSB
+    uint32_t rng;
+    int      busy;
+    uint16_t sample;                            // code latched at GO
+    uint64_t acq_from;                          // holding capacitor on CHS since
+    uint64_t done_at;
+    uint64_t conversions;
+    uint64_t short_acq;
+} adc = {
+    .input = { [0] = 512, [15] = 123 },         // 0.6 V reference with Vdd = 5 V
+    .rng = 2463534242u,
+};
+
+static double gauss(void)
+{
+    double sum = 0;
+    int i;
+
+    for(i = 0; i < 12; i++)                     // Irwin-Hall, close enough
+    {
+        adc.rng ^= adc.rng << 13;               // xorshift32
+        adc.rng ^= adc.rng >> 17;
+        adc.rng ^= adc.rng << 5;
+        sum += adc.rng / 4294967296.0;
+    }
+    return sum - 6;
+}
+
+static uint16_t sample(uint8_t chs)
+{
+    double v = adc.input[chs];
+
+    if(adc.noise[chs] > 0)
+        v += adc.noise[chs] * gauss();
+    v += 0.5;
+    if(v < 0)
+        return 0;
+    if(v >= 1023)
+        return 1023;
+    return (uint16_t)v;
+}
+
+static uint64_t tad_ticks(void)
+{
+    static const uint8_t tosc_per_tad[3] = { 2, 8, 32 };
+    uint8_t adcs = sim_reg[SFR_ADCON0] >> 6;
+
+    if(adcs == 3)
+        return ADC_FRC_TAD;
+    return (uint64_t)(sim.tcy / 4) * tosc_per_tad[adcs];
+}
+
+static void complete(void)
+{
+    uint16_t value = adc.sample;
+
+    if(sim_reg[SFR_ADCON1] & 0x80)              // ADFM: right justified
+    {
+        sim_reg[SFR_ADRESH] = value >> 8;
+        sim_reg[SFR_ADRESL] = value & 0xFF;
+    }
+    else
+    {
+        sim_reg[SFR_ADRESH] = value >> 2;
+        sim_reg[SFR_ADRESL] = (value & 3) << 6;
+    }
+    sim_reg[SFR_ADCON0] &= ~0x02;               // GO/DONE
+    sim_reg[SFR_PIR1] |= 0x40;                  // ADIF
+    adc.busy = 0;
+    adc.acq_from = sim.now;
+    adc.conversions++;
+}
+
+static void adcon0_write(uint16_t addr, uint8_t old, uint8_t val)
+{
+    (void)addr;
+    if(!(val & 0x01))                           // ADON = 0 aborts any conversion
+    {
+        sim_reg[SFR_ADCON0] &= ~0x02;
+        adc.busy = 0;
+        return;
+    }
+    if(!(old & 0x01) || ((val ^ old) & 0x3C))   // ADON or CHS changed
+        adc.acq_from = sim.now;
+    if((val & 0x02) && !(old & 0x02))
+    {
+        if(sim.now - adc.acq_from < ADC_TACQ)
+        {
+            adc.short_acq++;
+            if(sim.verbose)
+                sim_log("ADC: AN%d acquired for only %.2f us", (val >> 2) & 0x0F,
+                        (double)(sim.now - adc.acq_from) * 1e6 / SIM_HZ);
+        }
+        adc.busy = 1;
+        adc.sample = sample((val >> 2) & 0x0F);
+        adc.done_at = sim.now + ADC_TAD_CYCLES * tad_ticks();
+    }
+}
+
+uint64_t adc_next_event(void)
+{
+    return adc.busy ? adc.done_at : SIM_NEVER;
+}
+
+void adc_sync(uint64_t t)
+{
+    if(adc.busy && t >= adc.done_at)
+        complete();
+}
+
+// SLEEP stops Fosc: a conversion that is not clocked by FRC is lost
+void adc_sleep(void)
+{
+    if(adc.busy && (sim_reg[SFR_ADCON0] >> 6) != 3)
+    {
+        sim_reg[SFR_ADCON0] &= ~0x02;
+        adc.busy = 0;
+        sim_log("ADC conversion aborted by SLEEP (clock is not FRC)");
+    }
+}
+
+void adc_set_input(int channel, double value, double noise)
+{
+    if(channel >= 0 && channel < ADC_CHANNELS)
+    {
+        adc.input[channel] = value;
+        adc.noise[channel] = noise;
+    }
+}
+
+void adc_init(void)
+{
+    adc.busy = 0;
+    sim_hook(SFR_ADCON0, NULL, adcon0_write);
+}
+
+void adc_report(FILE *out)
+{
+    fprintf(out, "ADC:          conversions %llu  short acquisitions %llu\n",
+            (unsigned long long)adc.conversions, (unsigned long long)adc.short_acq);
+}
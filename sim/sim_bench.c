@@ -0,0 +1,238 @@
+/*
+ * File:   sim_bench.c
+ *
+ * SFR cycle counts for the benchmark table (-b FILE).
+ *
+ * Only SFR accesses (SIM_SFR_CYCLES each), delays and interrupt entry/exit
+ * cost cycles in the simulator; plain RAM arithmetic, branches, calls and
+ * the instructions around an SFR access are free. The table counts those
+ * "SFR cycles", not instructions: a lower bound, good for comparing how
+ * often two versions of the same code touch the hardware, not for reading
+ * off execution time. Size timing budgets from an XC8 listing instead.
+ *
+ * The sketches are built with -finstrument-functions, so every function
+ * of a sketch reports its entry and exit here. Per function the table
+ * gives the SFR cycles per call; those spent in isr() while main() code
+ * was running are taken out, so a slow isr() does not show up as a slow
+ * ADC_GetConversion().
+ *
+ * The core adds
+ *   isr            SFR cycles per interrupt, entry latency to RETFIE
+ *   irq latency    cycles from an enabled flag being set to the first
+ *                  instruction of isr(), and their spread (jitter)
+ *   <fn> loop      SFR cycles of work between two passes through the same
+ *                  __delay_ms()/__delay_us() call, i.e. one iteration of
+ *                  a 'do something, wait' loop minus the wait
+ *
+ * Rows are tab separated with a header line, appended to FILE so that
+ * 'make bench' can collect every sketch into one table.
+ */
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <link.h>
+#include <string.h>
+
+#include "sim.h"
+
+#define NO_INSTRUMENT   __attribute__((no_instrument_function))
+#define BENCH_ITEMS     64
+#define BENCH_DEPTH     32
+
+enum { ITEM_FUNC, ITEM_LOOP, ITEM_ISR, ITEM_LATENCY };
+
+static const char *const kind_name[] = { "func", "loop", "isr", "latency" };
+
+typedef struct {
+    const void *key;
+    int         kind;
+    uint64_t    calls;
+    uint64_t    min;
+    uint64_t    max;
+    uint64_t    sum;
+} item_t;
+
+static struct {
+    item_t   item[BENCH_ITEMS];
+    int      items;
+    struct { const void *fn; uint64_t cycles; uint64_t isr_cycles; } stack[BENCH_DEPTH];
+    int      depth;
+    uint64_t isr_cycles;            // total spent in interrupts so far
+    const void *delay_site;         // last delay and where main() was after it
+    uint64_t delay_end;
+    uint64_t delay_isr_cycles;
+} bench;
+
+void isr(void) __attribute__((weak));
+
+static NO_INSTRUMENT void record(const void *key, int kind, uint64_t cycles)
+{
+    item_t *it;
+    int i;
+
+    for(i = 0; i < bench.items; i++)
+        if(bench.item[i].key == key && bench.item[i].kind == kind)
+            break;
+    if(i == bench.items)
+    {
+        if(bench.items == BENCH_ITEMS)
+            return;
+        bench.items++;
+        bench.item[i] = (item_t){ .key = key, .kind = kind, .min = UINT64_MAX };
+    }
+    it = &bench.item[i];
+    it->calls++;
+    it->sum += cycles;
+    if(cycles < it->min)
+        it->min = cycles;
+    if(cycles > it->max)
+        it->max = cycles;
+}
+
+NO_INSTRUMENT void __cyg_profile_func_enter(void *fn, void *site)
+{
+    (void)site;
+    if(bench.depth < BENCH_DEPTH)
+    {
+        bench.stack[bench.depth].fn = fn;
+        bench.stack[bench.depth].cycles = sim.cycles;
+        bench.stack[bench.depth].isr_cycles = bench.isr_cycles;
+    }
+    bench.depth++;
+}
+
+NO_INSTRUMENT void __cyg_profile_func_exit(void *fn, void *site)
+{
+    (void)site;
+    if(bench.depth == 0 || --bench.depth >= BENCH_DEPTH || bench.stack[bench.depth].fn != fn)
+        return;
+    if(fn == (void *)isr)                       // the core times the whole interrupt
+        return;
+    record(fn, ITEM_FUNC, sim.cycles - bench.stack[bench.depth].cycles
+                          - (bench.isr_cycles - bench.stack[bench.depth].isr_cycles));
+}
+
+void bench_irq(uint64_t latency, uint64_t cycles)
+{
+    bench.isr_cycles += cycles;
+    record((void *)isr, ITEM_ISR, cycles);
+    record((void *)isr, ITEM_LATENCY, latency);
+}
+
+void bench_delay_begin(const void *site)
+{
+    if(sim.in_isr)
+        return;
+    if(site == bench.delay_site)
+        record(site, ITEM_LOOP, sim.cycles - bench.delay_end
+                                - (bench.isr_cycles - bench.delay_isr_cycles));
+}
+
+void bench_delay_end(const void *site)
+{
+    if(sim.in_isr)
+        return;
+    bench.delay_site = site;
+    bench.delay_end = sim.cycles;
+    bench.delay_isr_cycles = bench.isr_cycles;
+}
+
+// main() starts over (WDT reset): whatever was on the call stack is gone
+void bench_restart(void)
+{
+    bench.depth = 0;
+    bench.delay_site = NULL;
+}
+
+// dladdr() only sees exported symbols. A static function (board_init() of
+// board.h, say) is looked up in the executable's own symbol table instead.
+static int static_name(const void *addr, const void *base, char *buf, size_t len)
+{
+    FILE *f = fopen("/proc/self/exe", "rb");
+    ElfW(Ehdr) eh;
+    ElfW(Shdr) sh, strtab;
+    ElfW(Sym) sym;
+    uintptr_t want;
+    size_t n;
+    int i, found = 0;
+
+    if(!f)
+        return 0;
+    if(fread(&eh, sizeof(eh), 1, f) != 1)
+        goto out;
+    want = (uintptr_t)addr - (eh.e_type == ET_DYN ? (uintptr_t)base : 0);
+    for(i = 0; i < eh.e_shnum && !found; i++)
+    {
+        if(fseek(f, (long)(eh.e_shoff + i * eh.e_shentsize), SEEK_SET) || fread(&sh, sizeof(sh), 1, f) != 1)
+            break;
+        if(sh.sh_type != SHT_SYMTAB)
+            continue;
+        if(fseek(f, (long)(eh.e_shoff + sh.sh_link * eh.e_shentsize), SEEK_SET)
+           || fread(&strtab, sizeof(strtab), 1, f) != 1 || fseek(f, (long)sh.sh_offset, SEEK_SET))
+            break;
+        for(n = 0; n < sh.sh_size / sizeof(sym) && fread(&sym, sizeof(sym), 1, f) == 1; n++)
+            if(ELF64_ST_TYPE(sym.st_info) == STT_FUNC      // same for ELF32
+               && want >= sym.st_value && want < sym.st_value + sym.st_size)
+            {
+                found = !fseek(f, (long)(strtab.sh_offset + sym.st_name), SEEK_SET)
+                        && fgets(buf, (int)len, f) != NULL;
+                break;
+            }
+    }
+out:
+    fclose(f);
+    return found;
+}
+
+static void item_name(const item_t *it, char *buf, size_t len)
+{
+    Dl_info info;
+    const char *name = NULL;
+    char local[48];
+
+    if(it->kind == ITEM_LATENCY)
+    {
+        snprintf(buf, len, "irq latency");
+        return;
+    }
+    if(!dladdr(it->key, &info))
+        info.dli_fbase = NULL;
+    else if(info.dli_sname && (it->kind == ITEM_LOOP || info.dli_saddr == it->key))
+        name = info.dli_sname;
+    if(!name && info.dli_fbase && static_name(it->key, info.dli_fbase, local, sizeof(local)))
+        name = local;
+    if(name && strcmp(name, "sketch_main") == 0)
+        name = "main";
+    if(!name)
+        snprintf(buf, len, "%p", it->key);
+    else if(it->kind == ITEM_LOOP)
+        snprintf(buf, len, "%s loop", name);
+    else
+        snprintf(buf, len, "%s", name);
+}
+
+void bench_report(const char *path)
+{
+    FILE *out = fopen(path, "a");
+    char name[64];
+    int i;
+
+    if(!out)
+    {
+        perror(path);
+        return;
+    }
+    if(ftell(out) == 0)
+        fprintf(out, "sketch\tkind\titem\tcalls\tsfr_min\tsfr_avg\tsfr_max\tsfr_spread\n");
+    for(i = 0; i < bench.items; i++)
+    {
+        const item_t *it = &bench.item[i];
+
+        item_name(it, name, sizeof(name));
+        fprintf(out, "%s\t%s\t%s\t%llu\t%llu\t%.1f\t%llu\t%llu\n",
+                sim.name, kind_name[it->kind], name, (unsigned long long)it->calls,
+                (unsigned long long)it->min, (double)it->sum / it->calls,
+                (unsigned long long)it->max, (unsigned long long)(it->max - it->min));
+    }
+    fclose(out);
+}
@@ -0,0 +1,154 @@
+/*
+ * File:   sim_ccp.c
+ *
+ * ECCP1 in PWM mode.
+ *
+ * The duty cycle is double buffered as on the part: CCPR1L and DC1B
+ * (CCP1CON<5:4>) only reach the duty latch, and CCPR1H, when TMR2
+ * matches PR2, so a new value takes effect at the start of the next
+ * period. CCPR1H is read-only in PWM mode.
+ *
+ * Timer 2 reports every batch of periods it completes (ccp_periods()).
+ * The duty registers are cached and only change after Timer 2 has been
+ * brought up to date, so each batch is settled in one go: its first
+ * period still runs with the old latch, the rest with the registers.
+ * The output pins are not driven; the report gives the PWM frequency,
+ * the resolution and the average duty cycle instead.
+ *
+ * Torn periods: when CCPR1L and DC1B both change within a quarter period
+ * they are taken as one update, and if the duty was latched between the
+ * two writes, the periods that ran with half of it are counted.
+ */
+
+#include "sim.h"
+
+#define CCP1CON_DC1B    0x30
+#define CCP1M_PWM       0x0C            // CCP1M = 11xx
+
+static struct {
+    uint8_t  con;                       // CCP1CON the module runs with
+    uint8_t  ccpr1l;
+    uint16_t latch;                     // 10-bit duty of the current period
+    uint32_t steps;                     // duty steps per period, 4 (PR2 + 1)
+    uint32_t step_ticks;                // ticks per duty step, Tosc x prescaler
+    uint64_t periods;
+    uint64_t half_at[2];                // last change of CCPR1L [0] and DC1B [1]
+    uint64_t half_periods[2];           //   and the period count back then
+    uint64_t torn;                      // periods latched with half an update
+    uint64_t high;                      // ticks the output was high
+    uint64_t total;                     // ticks in PWM mode
+} ccp;
+
+static int pwm_mode(void)
+{
+    return (ccp.con & CCP1M_PWM) == CCP1M_PWM;
+}
+
+static uint16_t duty_registers(void)
+{
+    return (uint16_t)(ccp.ccpr1l << 2) | ((ccp.con & CCP1CON_DC1B) >> 4);
+}
+
+static void run(uint16_t duty, uint64_t n)
+{
+    uint64_t period = (uint64_t)ccp.steps * ccp.step_ticks;
+
+    ccp.high += (duty < ccp.steps ? duty : ccp.steps) * (uint64_t)ccp.step_ticks * n;
+    ccp.total += period * n;
+    ccp.periods += n;
+}
+
+void ccp_periods(uint64_t n, uint8_t pr2, uint32_t prescale)
+{
+    if(!n || !pwm_mode())
+        return;
+    ccp.steps = 4 * (pr2 + 1);
+    ccp.step_ticks = prescale * (sim.tcy / 4);
+    run(ccp.latch, 1);
+    ccp.latch = duty_registers();
+    run(ccp.latch, n - 1);
+    sim_reg[SFR_CCPR1H] = (uint8_t)(ccp.latch >> 2);
+}
+
+// One half of the duty changed; if the other half changed just before,
+// count the periods latched in between
+static void half_written(int half)
+{
+    int other = !half;
+    uint64_t quarter = (uint64_t)ccp.steps * ccp.step_ticks / 4;
+
+    if(ccp.half_at[other] != SIM_NEVER && sim.now - ccp.half_at[other] < quarter)
+    {
+        if(ccp.periods != ccp.half_periods[other])
+        {
+            ccp.torn += ccp.periods - ccp.half_periods[other];
+            sim_log("PWM period latched between the CCPR1L and DC1B writes");
+        }
+        ccp.half_at[other] = SIM_NEVER;         // paired up
+        ccp.half_at[half] = SIM_NEVER;
+        return;
+    }
+    ccp.half_at[half] = sim.now;
+    ccp.half_periods[half] = ccp.periods;
+}
+
+static void duty_write(uint16_t addr, uint8_t old, uint8_t val)
+{
+    (void)old;
+    timer_sync(sim.now);                // finish the periods of the old duty
+    if(pwm_mode() && addr == SFR_CCPR1L && val != ccp.ccpr1l)
+        half_written(0);
+    if(pwm_mode() && addr == SFR_CCP1CON && ((val ^ ccp.con) & CCP1CON_DC1B))
+        half_written(1);
+    if(addr == SFR_CCPR1L)
+        ccp.ccpr1l = val;
+    else
+    {
+        if(!pwm_mode() && (val & CCP1M_PWM) == CCP1M_PWM)
+            ccp.latch = 0;              // output low until the first period ends
+        ccp.con = val;
+    }
+}
+
+static void ccpr1h_write(uint16_t addr, uint8_t old, uint8_t val)
+{
+    (void)val;
+    if(pwm_mode())
+    {
+        sim_reg[addr] = old;
+        sim_log("CCPR1H is read-only in PWM mode (the duty LSBs go to CCP1CON DC1B)");
+    }
+}
+
+// Duty cycle of the period in progress, 0..1
+double ccp_duty(void)
+{
+    if(!pwm_mode() || !ccp.steps)
+        return 0;
+    return ccp.latch < ccp.steps ? (double)ccp.latch / ccp.steps : 1.0;
+}
+
+void ccp_init(void)
+{
+    ccp = (typeof(ccp)){ .con = sim_reg[SFR_CCP1CON], .ccpr1l = sim_reg[SFR_CCPR1L],
+                         .half_at = { SIM_NEVER, SIM_NEVER } };
+    sim_hook(SFR_CCPR1L, NULL, duty_write);
+    sim_hook(SFR_CCP1CON, NULL, duty_write);
+    sim_hook(SFR_CCPR1H, NULL, ccpr1h_write);
+}
+
+void ccp_report(FILE *out)
+{
+    uint32_t bits;
+
+    if(!ccp.periods)
+        return;
+    for(bits = 0; (2u << bits) <= ccp.steps; bits++)
+        ;
+    fprintf(out, "CCP1:         PWM %.2f Hz  resolution %u bits (%u steps)  duty avg %.2f%%  now %u/%u\n",
+            (double)SIM_HZ / ((uint64_t)ccp.steps * ccp.step_ticks), bits, ccp.steps,
+            100.0 * ccp.high / ccp.total, ccp.latch, ccp.steps);
+    if(ccp.torn)
+        fprintf(out, "              torn periods %llu (duty latched between the CCPR1L and DC1B writes)\n",
+                (unsigned long long)ccp.torn);
+}
@@ -0,0 +1,152 @@
+/*
+ * File:   sim_eeprom.c
+ *
+ * 256 bytes of data EEPROM.
+ *
+ * Read: set EECON1.RD with EEADR loaded, EEDAT holds the byte on the
+ * next instruction. Write: EEADR/EEDAT loaded, WREN set, 0x55 then 0xAA
+ * written to EECON2 and WR set; WR reads back 1 until the cell has been
+ * written EE_WRITE_TIME later, then clears and sets EEIF. WR cannot be
+ * set without the EECON2 sequence right before it, nor cleared by
+ * software. A reset during a write loses the byte and sets WRERR.
+ *
+ * The contents survive a WDT reset, and with -e FILE also survive the
+ * run: they are loaded from FILE at start-up and written back at the end.
+ * Program memory access (EEPGD = 1) is not modelled.
+ */
+
+#include "sim.h"
+
+#define EE_SIZE         256
+#define EE_WRITE_TIME   (SIM_HZ * 5 / 1000)     // 5 ms typical
+
+static struct {
+    uint8_t     data[EE_SIZE];
+    int         unlock;                 // EECON2 sequence: 0, 1 after 0x55, 2 after 0xAA
+    int         busy;
+    uint8_t     addr;
+    uint8_t     val;
+    uint64_t    done_at;
+    uint64_t    reads;
+    uint64_t    writes;
+    uint64_t    refused;                // WR set without the unlock sequence
+    const char *path;
+} ee = {
+    .data = { [0 ... EE_SIZE - 1] = 0xFF },     // erased
+};
+
+static void complete(void)
+{
+    ee.data[ee.addr] = ee.val;
+    ee.busy = 0;
+    ee.writes++;
+    sim_reg[SFR_EECON1] &= ~0x02;               // WR
+    sim_reg[SFR_PIR2] |= 0x10;                  // EEIF
+    sim_log("EEPROM[0x%02X] = 0x%02X", ee.addr, ee.val);
+}
+
+static void eecon1_write(uint16_t addr, uint8_t old, uint8_t val)
+{
+    int unlocked = ee.unlock == 2;
+
+    (void)addr;
+    ee.unlock = 0;
+    if(val & 0x80)                              // EEPGD: program memory
+    {
+        sim_reg[SFR_EECON1] &= ~0x03;
+        return;
+    }
+    if(val & 0x01)                              // RD
+    {
+        sim_reg[SFR_EEDAT] = ee.data[sim_reg[SFR_EEADR]];
+        sim_reg[SFR_EECON1] &= ~0x01;
+        ee.reads++;
+    }
+    if(ee.busy)
+        sim_reg[SFR_EECON1] |= 0x02;            // WR only clears by itself
+    else if((val & 0x02) && !(old & 0x02))
+    {
+        if(unlocked && (val & 0x04))
+        {
+            ee.busy = 1;
+            ee.addr = sim_reg[SFR_EEADR];
+            ee.val = sim_reg[SFR_EEDAT];
+            ee.done_at = sim.now + EE_WRITE_TIME;
+        }
+        else
+        {
+            sim_reg[SFR_EECON1] &= ~0x02;
+            ee.refused++;
+            sim_log("EEPROM write refused: %s", unlocked ? "WREN = 0" : "no 0x55/0xAA sequence");
+        }
+    }
+}
+
+// EECON2 is not a physical register and reads as 0
+static void eecon2_write(uint16_t addr, uint8_t old, uint8_t val)
+{
+    (void)old;
+    if(val == 0x55)
+        ee.unlock = 1;
+    else if(val == 0xAA && ee.unlock == 1)
+        ee.unlock = 2;
+    else
+        ee.unlock = 0;
+    sim_reg[addr] = 0;
+}
+
+uint64_t eeprom_next_event(void)
+{
+    return ee.busy ? ee.done_at : SIM_NEVER;
+}
+
+void eeprom_sync(uint64_t t)
+{
+    if(ee.busy && t >= ee.done_at)
+        complete();
+}
+
+void eeprom_init(void)
+{
+    if(ee.busy)
+    {
+        sim_reg[SFR_EECON1] |= 0x08;            // WRERR: reset during a write
+        sim_log("EEPROM write to 0x%02X lost", ee.addr);
+    }
+    ee.busy = 0;
+    ee.unlock = 0;
+    sim_hook(SFR_EECON1, NULL, eecon1_write);
+    sim_hook(SFR_EECON2, NULL, eecon2_write);
+}
+
+void eeprom_load(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+
+    ee.path = path;
+    if(!f)
+        return;                                 // first run: erased
+    if(fread(ee.data, 1, EE_SIZE, f) != EE_SIZE)
+        fprintf(stderr, "%s: short EEPROM image, rest left erased\n", path);
+    fclose(f);
+}
+
+void eeprom_save(void)
+{
+    FILE *f;
+
+    if(!ee.path)
+        return;
+    if(!(f = fopen(ee.path, "wb")) || fwrite(ee.data, 1, EE_SIZE, f) != EE_SIZE)
+        perror(ee.path);
+    if(f)
+        fclose(f);
+}
+
+void eeprom_report(FILE *out)
+{
+    if(ee.reads || ee.writes || ee.refused)
+        fprintf(out, "EEPROM:       reads %llu  writes %llu  refused %llu\n",
+                (unsigned long long)ee.reads, (unsigned long long)ee.writes,
+                (unsigned long long)ee.refused);
+}
@@ -0,0 +1,299 @@
+/*
+ * File:   sim_eusart.c
+ *
+ * EUSART, asynchronous mode.
+ *
+ * The baud rate generator follows the datasheet table: SPBRGH:SPBRG + 1
+ * periods of Fosc/64, Fosc/16 or Fosc/4 per bit depending on BRGH and
+ * BRG16. A frame is start + 8 data + stop bits (TX9 is not modelled).
+ * TXREG is double buffered as on the part: a byte written while the shift
+ * register is idle starts at once and TXREG is free again; a second one
+ * waits in TXREG with TXIF clear until the first has gone out. TXIF and
+ * TRMT are read-only, TXIF follows TXEN and the TXREG buffer. Clearing
+ * TXEN aborts the transmission.
+ *
+ * The receiver has the two-byte FIFO of the part: RCIF is set while it
+ * holds a byte and each RCREG read takes one out. A byte that completes
+ * while the FIFO is full sets OERR and is lost, and nothing more is
+ * received until CREN is cleared. Bytes arriving with SPEN or CREN clear
+ * are ignored. RCIF, OERR and FERR are read-only; framing errors do not
+ * happen here.
+ *
+ * With -u FILE every transmitted byte is written to FILE when its stop
+ * bit ends: a plain file, a FIFO (mkfifo) for a reader to follow the
+ * stream, or a pseudo-terminal, which makes it a virtual serial port.
+ * With -r T:FILE the bytes of FILE arrive on RX from T seconds on, back
+ * to back at the baud rate the EUSART is set to.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+
+#define FRAME_BITS      10
+
+#define TXSTA_TRMT      0x02
+#define TXSTA_BRGH      0x04
+#define TXSTA_SYNC      0x10
+#define TXSTA_TXEN      0x20
+#define RCSTA_OERR      0x02
+#define RCSTA_FERR      0x04
+#define RCSTA_CREN      0x10
+#define RCSTA_SPEN      0x80
+#define BAUDCTL_BRG16   0x08
+#define PIR1_TXIF       0x10
+#define PIR1_RCIF       0x20
+
+typedef struct {
+    uint64_t at;                        // earliest start of the start bit
+    uint8_t  byte;
+} rx_byte_t;
+
+static struct {
+    uint8_t     txreg;
+    int         txreg_full;
+    uint8_t     tsr;
+    uint64_t    tx_done;                // stop bit of the byte in the shift register ends
+    uint64_t    tx_bytes;
+    uint64_t    tx_lost;                // written to a full TXREG
+    uint64_t    tx_busy;                // ticks the TX line was busy
+    FILE       *out;
+    uint8_t     fifo[2];                // receive FIFO
+    int         fifo_count;
+    rx_byte_t  *rx;                     // bytes to receive, sorted by time
+    size_t      rx_count;
+    size_t      rx_next;
+    uint64_t    rx_free;                // end of the last stop bit on RX
+    uint64_t    rx_bytes;
+    uint64_t    rx_overruns;
+    uint64_t    rx_ignored;             // arrived with the receiver off
+} ua = { .tx_done = SIM_NEVER };
+
+// Ticks per bit from the baud rate generator settings
+static uint64_t bit_ticks(void)
+{
+    uint16_t brg = sim_reg[SFR_SPBRG] | (sim_reg[SFR_SPBRGH] << 8);
+    int brgh = (sim_reg[SFR_TXSTA] & TXSTA_BRGH) != 0;
+    int brg16 = (sim_reg[SFR_BAUDCTL] & BAUDCTL_BRG16) != 0;
+    uint32_t div = brg16 ? (brgh ? 4 : 16) : (brgh ? 16 : 64);
+
+    if(!brg16)
+        brg &= 0xFF;
+    return (uint64_t)div * (brg + 1) * (SIM_HZ / sim.fosc);
+}
+
+static int tx_enabled(void)
+{
+    return (sim_reg[SFR_TXSTA] & (TXSTA_TXEN | TXSTA_SYNC)) == TXSTA_TXEN
+        && (sim_reg[SFR_RCSTA] & RCSTA_SPEN);
+}
+
+static int rx_enabled(void)
+{
+    return (sim_reg[SFR_RCSTA] & (RCSTA_SPEN | RCSTA_CREN)) == (RCSTA_SPEN | RCSTA_CREN)
+        && !(sim_reg[SFR_TXSTA] & TXSTA_SYNC);
+}
+
+static void update_flags(void)
+{
+    if(ua.fifo_count)
+        sim_reg[SFR_PIR1] |= PIR1_RCIF;
+    else
+        sim_reg[SFR_PIR1] &= ~PIR1_RCIF;
+    if(tx_enabled() && !ua.txreg_full)
+        sim_reg[SFR_PIR1] |= PIR1_TXIF;
+    else
+        sim_reg[SFR_PIR1] &= ~PIR1_TXIF;
+    if(ua.tx_done == SIM_NEVER)
+        sim_reg[SFR_TXSTA] |= TXSTA_TRMT;
+    else
+        sim_reg[SFR_TXSTA] &= ~TXSTA_TRMT;
+}
+
+// TXREG -> shift register, starting at time t
+static void tx_load(uint64_t t)
+{
+    uint64_t frame = FRAME_BITS * bit_ticks();
+
+    ua.tsr = ua.txreg;
+    ua.txreg_full = 0;
+    ua.tx_done = t + frame;
+    ua.tx_busy += frame;
+}
+
+static void txreg_write(uint16_t addr, uint8_t old, uint8_t val)
+{
+    (void)addr; (void)old;
+    if(ua.txreg_full)
+    {
+        ua.tx_lost++;
+        sim_log("EUSART TXREG overwritten");
+    }
+    ua.txreg = val;
+    ua.txreg_full = 1;
+    if(tx_enabled() && ua.tx_done == SIM_NEVER)
+        tx_load(sim.now);
+    update_flags();
+}
+
+static void control_write(uint16_t addr, uint8_t old, uint8_t val)
+{
+    if(addr == SFR_TXSTA)
+        sim_reg[addr] = (val & ~TXSTA_TRMT) | (old & TXSTA_TRMT);
+    else
+    {
+        uint8_t status = RCSTA_OERR | RCSTA_FERR;
+
+        sim_reg[addr] = (val & ~status) | (old & status);
+        if(!(val & RCSTA_CREN))
+            sim_reg[addr] &= ~RCSTA_OERR;       // clearing CREN clears an overrun
+        if(!(val & RCSTA_SPEN))
+            ua.fifo_count = 0;
+    }
+    if(!tx_enabled())
+    {
+        if(ua.tx_done != SIM_NEVER)
+            sim_log("EUSART transmission aborted");
+        ua.tx_done = SIM_NEVER;
+        ua.txreg_full = 0;
+    }
+    else if(ua.txreg_full && ua.tx_done == SIM_NEVER)
+        tx_load(sim.now);
+    update_flags();
+}
+
+// TXIF and RCIF are read-only: whatever the sketch stores into PIR1, they keep their state
+static void pir1_write(uint16_t addr, uint8_t old, uint8_t val)
+{
+    uint8_t flags = PIR1_TXIF | PIR1_RCIF;
+
+    sim_reg[addr] = (val & ~flags) | (old & flags);
+}
+
+// Reading RCREG takes the oldest byte out of the FIFO
+static void rcreg_read(uint16_t addr)
+{
+    if(!ua.fifo_count)
+        return;
+    sim_reg[addr] = ua.fifo[0];
+    ua.fifo[0] = ua.fifo[1];
+    ua.fifo_count--;
+    update_flags();
+}
+
+static void receive(uint8_t byte)
+{
+    if(!rx_enabled())
+        ua.rx_ignored++;
+    else if(sim_reg[SFR_RCSTA] & RCSTA_OERR)
+        ua.rx_overruns++;                       // receiver stopped
+    else if(ua.fifo_count == 2)
+    {
+        sim_reg[SFR_RCSTA] |= RCSTA_OERR;
+        ua.rx_overruns++;
+        sim_log("EUSART receive overrun");
+    }
+    else
+    {
+        ua.fifo[ua.fifo_count++] = byte;
+        ua.rx_bytes++;
+    }
+}
+
+// End of the stop bit of the next byte to receive
+static uint64_t rx_done(void)
+{
+    uint64_t start;
+
+    if(ua.rx_next == ua.rx_count)
+        return SIM_NEVER;
+    start = ua.rx[ua.rx_next].at > ua.rx_free ? ua.rx[ua.rx_next].at : ua.rx_free;
+    return start + FRAME_BITS * bit_ticks();
+}
+
+void eusart_add_input(uint64_t at, const uint8_t *data, size_t n)
+{
+    size_t i, pos;
+
+    ua.rx = realloc(ua.rx, (ua.rx_count + n) * sizeof(*ua.rx));
+    for(pos = ua.rx_count; pos > 0 && ua.rx[pos - 1].at > at; pos--)
+        ;
+    memmove(&ua.rx[pos + n], &ua.rx[pos], (ua.rx_count - pos) * sizeof(*ua.rx));
+    for(i = 0; i < n; i++)
+        ua.rx[pos + i] = (rx_byte_t){ at, data[i] };
+    ua.rx_count += n;
+}
+
+uint64_t eusart_next_event(void)
+{
+    uint64_t rx = rx_done();
+
+    return rx < ua.tx_done ? rx : ua.tx_done;
+}
+
+void eusart_sync(uint64_t t)
+{
+    uint64_t done;
+
+    while((done = rx_done()) <= t)
+    {
+        receive(ua.rx[ua.rx_next++].byte);
+        ua.rx_free = done;
+    }
+    while(ua.tx_done <= t)
+    {
+        uint64_t done = ua.tx_done;
+
+        ua.tx_bytes++;
+        if(ua.out)
+            fputc(ua.tsr, ua.out);
+        ua.tx_done = SIM_NEVER;
+        if(ua.txreg_full)
+            tx_load(done);
+    }
+    update_flags();
+}
+
+void eusart_init(void)
+{
+    ua.txreg_full = 0;
+    ua.tx_done = SIM_NEVER;
+    ua.fifo_count = 0;
+    sim_hook(SFR_TXREG, NULL, txreg_write);
+    sim_hook(SFR_RCREG, rcreg_read, NULL);
+    sim_strobe(SFR_TXREG);
+    sim_hook(SFR_TXSTA, NULL, control_write);
+    sim_hook(SFR_RCSTA, NULL, control_write);
+    sim_hook(SFR_PIR1, NULL, pir1_write);
+}
+
+void eusart_open(const char *path)
+{
+    ua.out = fopen(path, "wb");
+    if(!ua.out)
+        perror(path);
+}
+
+void eusart_close(void)
+{
+    if(ua.out)
+        fclose(ua.out);
+    ua.out = NULL;
+}
+
+void eusart_report(FILE *out)
+{
+    uint64_t bits;
+
+    if(!ua.tx_bytes && !ua.tx_lost && !ua.rx_count)
+        return;
+    bits = bit_ticks();
+    fprintf(out, "EUSART:       %.0f baud  sent %llu bytes  lost %llu  line busy %.1f%%\n",
+            (double)SIM_HZ / bits, (unsigned long long)ua.tx_bytes,
+            (unsigned long long)ua.tx_lost, sim.now ? 100.0 * ua.tx_busy / sim.now : 0.0);
+    if(ua.rx_count)
+        fprintf(out, "              received %llu bytes  overruns %llu  ignored %llu  pending %zu\n",
+                (unsigned long long)ua.rx_bytes, (unsigned long long)ua.rx_overruns,
+                (unsigned long long)ua.rx_ignored, ua.rx_count - ua.rx_next);
+}
@@ -0,0 +1,468 @@
+/*
+ * File:   sim_io.c
+ *
+ * Digital I/O ports PORTA..PORTE.
+ *
+ * Like the real part, a PORTx write goes to the output latch and a PORTx
+ * read returns the pin levels: the latch for output pins, the external
+ * level for digital input pins and 0 for pins in analog mode (ANSEL,
+ * ANSELH). Read-modify-write sequences such as
+ *     PORTDbits.RD0 = ~PORTDbits.RD0;
+ * therefore behave exactly as they do on silicon.
+ *
+ * The external levels default to the PICKit 44-Pin Demo Board idle state:
+ * SW1 on RB0 is pulled up, nothing else is driven. An input pin nobody
+ * drives reads low, except on PORTB where the weak pull-ups (nRBPU = 0
+ * and the pin's WPUB bit set) make it read high, as buttons to ground
+ * do when released. A level set with -p or a stimulus drives every pin of
+ * that port from then on. A stimulus list changes the levels at given
+ * times; an edge on RB0/INT in the direction selected by INTEDG sets INTF.
+ *
+ * A stimulus can bounce: for the given time after it, the pins it changes
+ * chatter between the old and new level at random intervals of 20 us to
+ * 1 ms before settling, each pin on its own, like real contacts. With a
+ * response port chosen (-l), every input pin n that a stimulus changes
+ * waits for the next change of pin n of that port; the report gives how
+ * many were answered, the latency from the first edge and from the pin
+ * settling, and any further edges before the next stimulus, which a
+ * working debouncer never produces.
+ *
+ * With -m PORT the time each output pin of PORT spends high is added up,
+ * and the report gives the duty cycle of every pin: software PWM and
+ * LED brightness.
+ *
+ * Interrupt-on-change: PORTB input pins enabled in IOCB are compared with
+ * their level at the last PORTB read or write, and any difference (the
+ * mismatch) sets RBIF. As on the part, RBIF cannot be cleared for good
+ * until PORTB has been read: it comes straight back while the mismatch
+ * lasts.
+ */
+
+#include <stdlib.h>
+
+#include "sim.h"
+
+typedef struct {
+    uint8_t  latch;
+    uint8_t  input;             // level driven onto the pins from outside
+    uint8_t  driven;            // pins 'input' applies to, the others float
+    uint8_t  pins;              // last output pin state that was logged
+    uint64_t writes;            // stores that changed the latch
+    uint64_t edges;             // output pin transitions
+    uint64_t high[8];           // ticks each output pin was high, up to 'since'
+    uint64_t since;
+} port_t;
+
+static port_t port[SIM_PORT_COUNT];
+static uint8_t ioc_old;         // PORTB pins at the last PORTB access
+static uint8_t int_level;       // RB0/INT pin level, for the edge detector
+static uint64_t ioc_changes;    // mismatches that set RBIF
+static int duty_port = -1;      // -m PORT
+
+typedef struct {
+    uint64_t at;
+    uint64_t bounce;            // chatter time, ticks
+    uint8_t  port;
+    uint8_t  level;
+} stimulus_t;
+
+static struct {
+    stimulus_t *list;           // sorted by time
+    size_t      count;
+    size_t      next;
+} stim;
+
+static struct {
+    int      port;
+    uint8_t  target;            // level once settled
+    uint8_t  mask;              // pins that chatter
+    uint64_t next;              // next chatter edge, SIM_NEVER when settled
+    uint64_t until;
+    uint32_t seed;
+} chatter = { .next = SIM_NEVER, .seed = 1 };
+
+#define CHATTER_MIN_TICKS   (SIM_HZ / 50000)    // 20 us
+#define CHATTER_MAX_TICKS   (SIM_HZ / 1000)     // 1 ms
+
+static struct {
+    int      port;              // response port, -1 for none
+    uint64_t first[8];          // per pin: first edge of the change waiting for its answer
+    uint64_t settled[8];        //   and its last edge
+    uint8_t  waiting;           // pins whose change has not been answered yet
+    uint8_t  answered;          // pins whose change has been answered
+    uint64_t stimuli;
+    uint64_t answers;
+    uint64_t extra;             // output changes after the answer
+    uint64_t min, max, sum;     // latency from the first edge
+    uint64_t settle_min, settle_max;
+} resp = { .port = -1 };
+
+static const uint8_t port_mask[SIM_PORT_COUNT] = { 0xFF, 0xFF, 0xFF, 0xFF, 0x0F };
+
+// ANSEL/ANSELH bit -> port/pin of AN0..AN13
+static const struct { uint8_t port; uint8_t pin; } an_pin[14] = {
+    { 0, 0 }, { 0, 1 }, { 0, 2 }, { 0, 3 }, { 0, 5 },  // AN0-AN4  RA0-RA3, RA5
+    { 4, 0 }, { 4, 1 }, { 4, 2 },                       // AN5-AN7  RE0-RE2
+    { 1, 2 }, { 1, 3 }, { 1, 1 }, { 1, 4 },             // AN8-AN11 RB2, RB3, RB1, RB4
+    { 1, 0 }, { 1, 5 },                                 // AN12-AN13 RB0, RB5
+};
+
+static uint8_t analog_mask(int p)
+{
+    uint16_t ans = sim_reg[SFR_ANSEL] | ((uint16_t)sim_reg[SFR_ANSELH] << 8);
+    uint8_t mask = 0;
+    int i;
+
+    for(i = 0; i < 14; i++)
+        if((ans >> i) & 1 && an_pin[i].port == p)
+            mask |= 1 << an_pin[i].pin;
+    return mask;
+}
+
+// Level on the pins as the outside leaves them: driven, or pulled up
+static uint8_t outside(int p)
+{
+    uint8_t pullup = 0;
+
+    if(p == 1 && !(sim_reg[SFR_OPTION_REG] & 0x80))
+        pullup = sim_reg[SFR_WPUB];             // nRBPU = 0
+    return (port[p].input & port[p].driven) | (pullup & ~port[p].driven);
+}
+
+static uint8_t pin_levels(int p)
+{
+    uint8_t tris = sim_reg[SFR_TRISA + p];
+    uint8_t levels = (port[p].latch & ~tris) | (outside(p) & tris & ~analog_mask(p));
+
+    return levels & port_mask[p];
+}
+
+static void ioc_check(void)
+{
+    uint8_t mask = sim_reg[SFR_IOCB] & sim_reg[SFR_TRISB] & ~analog_mask(1);
+
+    if((pin_levels(1) ^ ioc_old) & mask && !(sim_reg[SFR_INTCON] & 0x01))
+    {
+        sim_reg[SFR_INTCON] |= 0x01;            // RBIF
+        ioc_changes++;
+    }
+}
+
+// Pins of the response port changed: answers to the input changes, or extra edges
+static void response(uint8_t changed)
+{
+    int n;
+
+    for(n = 0; n < 8; n++)
+    {
+        uint64_t latency, settled;
+
+        if(!(changed & (1 << n)))
+            continue;
+        if(resp.answered & (1 << n))
+            resp.extra++;
+        if(!(resp.waiting & (1 << n)))
+            continue;
+        resp.waiting &= ~(1 << n);
+        resp.answered |= 1 << n;
+        latency = sim.now - resp.first[n];
+        settled = sim.now > resp.settled[n] ? sim.now - resp.settled[n] : 0;
+        if(!resp.answers++)
+            resp.min = resp.settle_min = UINT64_MAX;
+        if(latency < resp.min)
+            resp.min = latency;
+        if(latency > resp.max)
+            resp.max = latency;
+        resp.sum += latency;
+        if(settled < resp.settle_min)
+            resp.settle_min = settled;
+        if(settled > resp.settle_max)
+            resp.settle_max = settled;
+    }
+}
+
+// Add the time since the last change to the pins that were high
+static void add_high(int p)
+{
+    int n;
+
+    for(n = 0; n < 8; n++)
+        if(port[p].pins & (1 << n))
+            port[p].high[n] += sim.now - port[p].since;
+    port[p].since = sim.now;
+}
+
+// Log and count changes on the pins that are driven by the PIC
+static void update_outputs(int p)
+{
+    uint8_t tris = sim_reg[SFR_TRISA + p];
+    uint8_t out = port[p].latch & ~tris & port_mask[p];
+    uint8_t changed = out ^ (port[p].pins & ~tris);
+
+    if(changed)
+    {
+        if(p == resp.port)
+            response(changed);
+        if(p == duty_port)
+            add_high(p);
+        port[p].edges += __builtin_popcount(changed);
+        sim_log("PORT%c  0x%02X -> 0x%02X", 'A' + p, port[p].pins & ~tris & port_mask[p], out);
+    }
+    port[p].pins = out;
+}
+
+static void port_read(uint16_t addr)
+{
+    sim_reg[addr] = pin_levels(addr - SFR_PORTA);
+    if(addr == SFR_PORTB)
+        ioc_old = sim_reg[addr];                // ends the mismatch
+}
+
+static void port_write(uint16_t addr, uint8_t old, uint8_t val)
+{
+    int p = addr - SFR_PORTA;
+
+    (void)old;
+    port[p].latch = val & port_mask[p];
+    port[p].writes++;
+    update_outputs(p);
+    if(p == 1)
+        ioc_old = pin_levels(p);
+}
+
+static void tris_write(uint16_t addr, uint8_t old, uint8_t val)
+{
+    int p = addr - SFR_TRISA;
+
+    (void)old;
+    if(p == 4)
+        val |= 0x08;                // TRISE3 is read-only, RE3/MCLR is an input
+    sim_reg[addr] = val & port_mask[p];
+    update_outputs(p);
+}
+
+static void ioc_write(uint16_t addr, uint8_t old, uint8_t val)
+{
+    (void)addr; (void)old; (void)val;
+    ioc_check();
+}
+
+// Clearing RBIF while the mismatch lasts does not stick
+static void intcon_write(uint16_t addr, uint8_t old, uint8_t val)
+{
+    (void)addr;
+    if((old & 0x01) && !(val & 0x01))
+        ioc_check();
+}
+
+// PORTB input levels may have changed: RB0/INT edge and interrupt-on-change
+static void portb_check(void)
+{
+    uint8_t rb0 = (sim_reg[SFR_TRISB] & 0x01 ? outside(1) : port[1].latch) & 0x01;
+
+    if(rb0 != int_level)
+    {
+        uint8_t intedg = (sim_reg[SFR_OPTION_REG] >> 6) & 0x01;
+
+        int_level = rb0;
+        if(rb0 == intedg)
+            sim_reg[SFR_INTCON] |= 0x02;        // INTF
+    }
+    ioc_check();
+}
+
+// WPUB, and nRBPU through io_option_write(), switch the pull-ups
+static void wpub_write(uint16_t addr, uint8_t old, uint8_t val)
+{
+    (void)addr; (void)old; (void)val;
+    portb_check();
+}
+
+void io_option_write(void)
+{
+    portb_check();
+}
+
+void io_set_input(int p, uint8_t level)
+{
+    port[p].input = level & port_mask[p];
+    port[p].driven = port_mask[p];
+    if(p == 1)
+        portb_check();
+}
+
+void io_add_stimulus(uint64_t at, int p, uint8_t level, uint64_t bounce)
+{
+    size_t i;
+
+    stim.list = realloc(stim.list, (stim.count + 1) * sizeof(*stim.list));
+    for(i = stim.count; i > 0 && stim.list[i - 1].at > at; i--)
+        stim.list[i] = stim.list[i - 1];
+    stim.list[i] = (stimulus_t){ at, bounce, (uint8_t)p, level };
+    stim.count++;
+}
+
+void io_watch(int p)
+{
+    resp.port = p;
+}
+
+void io_measure_duty(int p)
+{
+    duty_port = p;
+}
+
+// Output pins driven high
+uint8_t io_pins(int p)
+{
+    return port[p].pins;
+}
+
+static uint32_t chatter_random(void)
+{
+    chatter.seed ^= chatter.seed << 13;
+    chatter.seed ^= chatter.seed >> 17;
+    chatter.seed ^= chatter.seed << 5;
+    return chatter.seed;
+}
+
+static uint64_t chatter_after(uint64_t t)
+{
+    uint64_t next = t + CHATTER_MIN_TICKS + chatter_random() % (CHATTER_MAX_TICKS - CHATTER_MIN_TICKS);
+
+    return next < chatter.until ? next : chatter.until;
+}
+
+static void settle_pins(uint8_t pins, uint64_t t)
+{
+    int n;
+
+    for(n = 0; n < 8; n++)
+        if(pins & (1 << n))
+            resp.settled[n] = t;
+}
+
+// One chatter edge at chatter.next: some of the bouncing pins flip, or at
+// the end all of them take their final level
+static void chatter_step(void)
+{
+    uint64_t t = chatter.next;
+    uint8_t flip;
+
+    if(t >= chatter.until)
+    {
+        chatter.next = SIM_NEVER;
+        settle_pins(port[chatter.port].input ^ chatter.target, t);
+        io_set_input(chatter.port, chatter.target);
+        return;
+    }
+    flip = chatter_random() & chatter.mask;
+    if(!flip)
+        flip = chatter.mask;
+    io_set_input(chatter.port, port[chatter.port].input ^ flip);
+    settle_pins(flip, t);
+    chatter.next = chatter_after(t);
+}
+
+static void apply(const stimulus_t *s)
+{
+    uint8_t changed;
+
+    if(chatter.next != SIM_NEVER)
+    {
+        chatter.next = SIM_NEVER;                       // cut short by the next stimulus
+        io_set_input(chatter.port, chatter.target);
+    }
+    changed = (outside(s->port) ^ s->level) & port_mask[s->port];
+    sim_log("PORT%c  input 0x%02X%s", 'A' + s->port, s->level, s->bounce ? " (bouncing)" : "");
+    io_set_input(s->port, s->level);
+    if(changed && resp.port >= 0 && s->port != resp.port)
+    {
+        int n;
+
+        for(n = 0; n < 8; n++)
+            if(changed & (1 << n))
+                resp.first[n] = resp.settled[n] = s->at;
+        resp.waiting |= changed;
+        resp.answered &= ~changed;
+        resp.stimuli += __builtin_popcount(changed);
+    }
+    if(changed && s->bounce)
+    {
+        chatter.port = s->port;
+        chatter.target = s->level;
+        chatter.mask = changed;
+        chatter.until = s->at + s->bounce;
+        chatter.next = chatter_after(s->at);
+    }
+}
+
+uint64_t io_next_event(void)
+{
+    uint64_t next = stim.next < stim.count ? stim.list[stim.next].at : SIM_NEVER;
+
+    return chatter.next < next ? chatter.next : next;
+}
+
+void io_sync(uint64_t t)
+{
+    uint64_t next;
+
+    while((next = io_next_event()) <= t)
+    {
+        if(chatter.next == next)
+            chatter_step();
+        else
+            apply(&stim.list[stim.next++]);
+    }
+}
+
+void io_init(void)
+{
+    int p;
+
+    for(p = 0; p < SIM_PORT_COUNT; p++)
+    {
+        port[p] = (port_t){ 0 };
+        sim_hook(SFR_PORTA + p, port_read, port_write);
+        sim_hook(SFR_TRISA + p, NULL, tris_write);
+    }
+    port[1].input = 0x01;           // SW1 pull-up on RB0
+    port[1].driven = 0x01;
+    ioc_old = 0;
+    int_level = 0x01;
+    sim_hook(SFR_IOCB, NULL, ioc_write);
+    sim_hook(SFR_WPUB, NULL, wpub_write);
+    sim_hook(SFR_INTCON, NULL, intcon_write);
+}
+
+void io_report(FILE *out)
+{
+    int p;
+
+    for(p = 0; p < SIM_PORT_COUNT; p++)
+        fprintf(out, "PORT%c:        latch 0x%02X  tris 0x%02X  writes %llu  edges %llu\n",
+                'A' + p, port[p].latch, sim_reg[SFR_TRISA + p],
+                (unsigned long long)port[p].writes, (unsigned long long)port[p].edges);
+    if(duty_port >= 0 && sim.now)
+    {
+        add_high(duty_port);
+        fprintf(out, "PORT%c duty:  ", 'A' + duty_port);
+        for(p = 0; p < 8; p++)
+            fprintf(out, " R%c%d %.2f%%", 'A' + duty_port, p, 100.0 * port[duty_port].high[p] / sim.now);
+        fputc('\n', out);
+    }
+    if(resp.port >= 0)
+    {
+        fprintf(out, "Response:     PORT%c  answered %llu of %llu pin changes  extra edges %llu\n",
+                'A' + resp.port, (unsigned long long)resp.answers,
+                (unsigned long long)resp.stimuli, (unsigned long long)resp.extra);
+        if(resp.answers)
+            fprintf(out, "              latency %.3f / %.3f / %.3f ms (min/avg/max)  after settling %.3f / %.3f ms (min/max)\n",
+                    1e3 * resp.min / SIM_HZ, 1e3 * resp.sum / resp.answers / SIM_HZ,
+                    1e3 * resp.max / SIM_HZ, 1e3 * resp.settle_min / SIM_HZ,
+                    1e3 * resp.settle_max / SIM_HZ);
+    }
+    if(ioc_changes)
+        fprintf(out, "IOC:          RBIF set %llu times\n", (unsigned long long)ioc_changes);
+}
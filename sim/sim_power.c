@@ -0,0 +1,131 @@
+/*
+ * File:   sim_power.c
+ *
+ * Supply current estimate.
+ *
+ * The current is taken as constant between two changes of whatever draws
+ * it, and those only happen on an SFR write, a peripheral event or on
+ * entering and leaving Sleep. The core calls power_sync() after each of
+ * them: the time since the last call is charged at the current of back
+ * then, and the current is worked out afresh for what comes next.
+ *
+ * The figures are the typical values of the DC characteristics at 5 V and
+ * 25 C; a real board varies by some tens of percent, so use the report to
+ * compare sketches rather than to size a battery to the last mAh.
+ *
+ * What is counted:
+ *   core       by IRCF while awake (HFINTOSC runs at full speed and is
+ *              divided down, hence the base current at the low settings)
+ *   sleep      the power-down base current
+ *   WDT        while SWDTEN is set (LFINTOSC plus the counter)
+ *   T1OSC      while T1OSCEN is set, awake or asleep
+ *   ADC        a little while ADON is set, much more during a conversion
+ *   LEDs       PORTD pins driven high, through the demo board's LEDs and
+ *              470R resistors; pins PSTRCON steers the single output PWM
+ *              to count at the current duty cycle
+ * Not counted: BOR (some 40 uA more with BOREN = ON, the simulator does
+ * not see the configuration bits), the EUSART, EEPROM writes and loads
+ * on other pins.
+ */
+
+#include "sim.h"
+
+#define POWER_VDD       5.0
+
+// Typical supply current in uA, 5 V, 25 C
+static const double core_ua[8] = {      // IRCF 000 (LFINTOSC) .. 111 (8 MHz)
+    23, 230, 260, 330, 450, 700, 1200, 2200
+};
+#define SLEEP_UA        0.35            // IPD base
+#define WDT_UA          3.0
+#define T1OSC_UA        6.0
+#define ADC_ON_UA       2.0
+#define ADC_CONVERT_UA  180.0
+#define LED_UA          6400.0          // (5 V - 2 V) / 470R
+
+enum { CORE, SLEEP, WDT, T1OSC, ADC, LEDS, PARTS };
+
+static const char *const part_name[PARTS] = { "core", "sleep", "WDT", "T1OSC", "ADC", "LEDs" };
+
+static struct {
+    uint64_t since;                     // accounted up to here
+    double   ua[PARTS];                 //   and drawing this since
+    double   charge[PARTS];             // uA x ticks
+} power;
+
+// Current of the PORTD LEDs right now, uA
+static double led_ua(void)
+{
+    uint8_t lit = io_pins(3);
+    double ua = 0;
+    int n;
+
+    if((sim_reg[SFR_CCP1CON] & 0xCC) == 0x0C)
+    {
+        // P1M = 00, single output: P1B..P1D on RD5..RD7 follow the PWM
+        // where STRB..STRD steer it. The half and full-bridge modes drive
+        // the pins their own way and ignore PSTRCON; the latch counts there.
+        uint8_t pwm = (uint8_t)((sim_reg[SFR_PSTRCON] & 0x0E) << 4) & ~sim_reg[SFR_TRISD];
+
+        ua += __builtin_popcount(pwm) * LED_UA * ccp_duty();
+        lit &= ~pwm;
+    }
+    for(n = 0; n < 8; n++)
+        if(lit & (1 << n))
+            ua += LED_UA;
+    return ua;
+}
+
+void power_sync(uint64_t t)
+{
+    uint8_t adcon0 = sim_reg[SFR_ADCON0];
+    int i;
+
+    if(t > power.since)
+    {
+        for(i = 0; i < PARTS; i++)
+            power.charge[i] += power.ua[i] * (double)(t - power.since);
+        power.since = t;
+    }
+
+    power.ua[CORE] = sim.asleep ? 0 : core_ua[(sim_reg[SFR_OSCCON] >> 4) & 7];
+    power.ua[SLEEP] = sim.asleep ? SLEEP_UA : 0;
+    power.ua[WDT] = (sim_reg[SFR_WDTCON] & 0x01) ? WDT_UA : 0;
+    power.ua[T1OSC] = (sim_reg[SFR_T1CON] & 0x08) ? T1OSC_UA : 0;
+    power.ua[ADC] = !(adcon0 & 0x01) ? 0 : (adcon0 & 0x02) ? ADC_CONVERT_UA : ADC_ON_UA;
+    power.ua[LEDS] = led_ua();
+}
+
+static void print_current(FILE *out, double ua)
+{
+    if(ua >= 1000)
+        fprintf(out, "%.3f mA", ua / 1000);
+    else
+        fprintf(out, "%.2f uA", ua);
+}
+
+void power_report(FILE *out)
+{
+    double total = 0;
+    int i;
+
+    if(!sim.now)
+        return;
+    power_sync(sim.now);
+    for(i = 0; i < PARTS; i++)
+        total += power.charge[i];
+    total /= sim.now;                   // average uA
+    fprintf(out, "Current:      avg ");
+    print_current(out, total);
+    fprintf(out, " at %.1f V  energy per hour %.3f mWh (%.3f mAh)\n",
+            POWER_VDD, total * POWER_VDD / 1000, total / 1000);
+    fprintf(out, "             ");
+    for(i = 0; i < PARTS; i++)
+    {
+        if(!power.charge[i])
+            continue;
+        fprintf(out, " %s ", part_name[i]);
+        print_current(out, power.charge[i] / sim.now);
+    }
+    fputc('\n', out);
+}
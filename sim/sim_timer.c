@@ -0,0 +1,425 @@
+/*
+ * File:   sim_timer.c
+ *
+ * Timer0, Timer1, Timer2 and the Watchdog Timer.
+ *
+ * The counters run from the same clocks as on the part:
+ *   TMR0  Fosc/4 through the shared prescaler (OPTION_REG PSA/PS)
+ *   TMR1  Fosc/4 or the 32.768 kHz T1OSC crystal, prescaler 1:1..1:8
+ *   TMR2  Fosc/4, prescaler 1:1/4/16, PR2 period match, postscaler 1:1..1:16
+ *   WDT   31.25 kHz LFINTOSC, WDTCON WDTPS prescaler 1:32..1:65536 and the
+ *         OPTION_REG postscaler when PSA = 1
+ * and obey the datasheet side effects of register writes: writing TMR0
+ * clears the prescaler and inhibits counting for two cycles, writing TMR1
+ * clears the Timer1 prescaler, writing TMR2 or T2CON clears the Timer2
+ * prescaler and postscaler.
+ *
+ * Nothing here is clocked cycle by cycle. Each counter remembers the time
+ * it was last brought up to date ('base') and the configuration it has
+ * been running with since; timer_sync() works out how far it got in O(1)
+ * and timer_next_event() tells the core when the next flag will be set,
+ * so the core can jump straight there. The configuration a counter runs
+ * with is cached rather than read back from sim_reg[], because by the
+ * time a write hook runs the register already holds the new value.
+ */
+
+#include "sim.h"
+
+static struct {
+    uint8_t  option;            // OPTION_REG the counter runs with
+    uint8_t  value;
+    uint32_t presc;
+    uint64_t base;              // may lie ahead: write inhibit
+    uint64_t overflows;
+} t0;
+
+static struct {
+    uint8_t  t1con;
+    uint16_t value;
+    uint8_t  presc;
+    uint64_t base;
+    uint64_t overflows;
+} t1;
+
+static struct {
+    uint8_t  t2con;
+    uint8_t  pr2;
+    uint8_t  value;
+    uint8_t  presc;
+    uint8_t  post;
+    uint64_t base;
+    uint64_t periods;
+} t2;
+
+static struct {
+    int      enabled;
+    uint32_t period;            // LFINTOSC ticks to a time-out
+    uint64_t base;              // time of the last clear
+    uint64_t timeouts;
+} wdt;
+
+static const uint8_t t2_prescale[4] = { 1, 4, 16, 16 };
+
+/* ---- Timer0 ---- */
+
+static int t0_running(void)
+{
+    return !(t0.option & 0x20) && !sim.asleep;  // T0CS = 0: Fosc/4, stops in Sleep
+}
+
+static uint32_t t0_rate(void)
+{
+    return (t0.option & 0x08) ? 1 : 2u << (t0.option & 7);
+}
+
+static void t0_sync(uint64_t t)
+{
+    uint64_t n, total, span;
+    uint32_t rate = t0_rate();
+
+    if(t <= t0.base)
+        return;
+    if(!t0_running())
+    {
+        t0.base = t;
+        return;
+    }
+    n = (t - t0.base) / sim.tcy;
+    t0.base += n * sim.tcy;
+    span = 256 * rate;
+    total = (uint64_t)t0.value * rate + t0.presc + n;
+    if(total >= span)
+    {
+        sim_reg[SFR_INTCON] |= 0x04;            // T0IF
+        t0.overflows += total / span;
+        total %= span;
+    }
+    t0.value = total / rate;
+    t0.presc = total % rate;
+}
+
+static uint64_t t0_next_event(void)
+{
+    uint32_t rate = t0_rate();
+
+    if(!t0_running() || (sim_reg[SFR_INTCON] & 0x04))
+        return SIM_NEVER;
+    return t0.base + (256 * rate - ((uint64_t)t0.value * rate + t0.presc)) * sim.tcy;
+}
+
+/* ---- Timer1 ---- */
+
+#define T1_OFF      0
+#define T1_FCY      1
+#define T1_OSC      2
+
+static int t1_source(void)
+{
+    if(!(t1.t1con & 0x01))                      // TMR1ON
+        return T1_OFF;
+    if(!(t1.t1con & 0x02))                      // TMR1CS = 0
+        return sim.asleep ? T1_OFF : T1_FCY;
+    if(!(t1.t1con & 0x08))                      // T1CKI pin, not modelled
+        return T1_OFF;
+    if(sim.asleep && !(t1.t1con & 0x04))        // synchronized counter stops in Sleep
+        return T1_OFF;
+    return T1_OSC;
+}
+
+static void t1_sync(uint64_t t)
+{
+    uint64_t edges, total, span;
+    uint32_t rate = 1u << ((t1.t1con >> 4) & 3);
+
+    if(t <= t1.base)
+        return;
+    switch(t1_source())
+    {
+    case T1_FCY:
+        edges = (t - t1.base) / sim.tcy;
+        t1.base += edges * sim.tcy;
+        break;
+    case T1_OSC:
+        // the crystal runs all the time; its edges sit on a fixed grid
+        edges = t / SIM_T1OSC_TICKS - t1.base / SIM_T1OSC_TICKS;
+        t1.base = t;
+        break;
+    default:
+        t1.base = t;
+        return;
+    }
+    span = 65536 * rate;
+    total = (uint64_t)t1.value * rate + t1.presc + edges;
+    if(total >= span)
+    {
+        sim_reg[SFR_PIR1] |= 0x01;              // TMR1IF
+        t1.overflows += total / span;
+        total %= span;
+    }
+    t1.value = total / rate;
+    t1.presc = total % rate;
+}
+
+static uint64_t t1_next_event(void)
+{
+    uint32_t rate = 1u << ((t1.t1con >> 4) & 3);
+    uint64_t need = 65536 * rate - ((uint64_t)t1.value * rate + t1.presc);
+
+    if(sim_reg[SFR_PIR1] & 0x01)
+        return SIM_NEVER;
+    switch(t1_source())
+    {
+    case T1_FCY:
+        return t1.base + need * sim.tcy;
+    case T1_OSC:
+        return (t1.base / SIM_T1OSC_TICKS + need) * SIM_T1OSC_TICKS;
+    default:
+        return SIM_NEVER;
+    }
+}
+
+/* ---- Timer2 ---- */
+
+static int t2_running(void)
+{
+    return (t2.t2con & 0x04) && !sim.asleep;    // TMR2ON, Fosc/4 stops in Sleep
+}
+
+// Increments from the current value to the first PR2 match reset
+static uint32_t t2_first_reset(void)
+{
+    if(t2.value <= t2.pr2)
+        return t2.pr2 - t2.value + 1;
+    return 256 - t2.value + t2.pr2 + 1;         // PR2 lowered under TMR2: wraps first
+}
+
+static void t2_sync(uint64_t t)
+{
+    uint64_t n, incs, resets, rem;
+    uint32_t rate = t2_prescale[t2.t2con & 3];
+    uint32_t period = t2.pr2 + 1;
+    uint32_t first;
+    uint8_t post = ((t2.t2con >> 3) & 0x0F) + 1;
+
+    if(t <= t2.base)
+        return;
+    if(!t2_running())
+    {
+        t2.base = t;
+        return;
+    }
+    n = (t - t2.base) / sim.tcy;
+    t2.base += n * sim.tcy;
+    incs = (t2.presc + n) / rate;
+    t2.presc = (t2.presc + n) % rate;
+
+    first = t2_first_reset();
+    if(incs < first)
+    {
+        t2.value += incs;
+        return;
+    }
+    rem = incs - first;
+    resets = 1 + rem / period;
+    t2.value = rem % period;
+    t2.periods += resets;
+    ccp_periods(resets, t2.pr2, rate);
+    if(t2.post + resets >= post)
+        sim_reg[SFR_PIR1] |= 0x02;              // TMR2IF
+    t2.post = (t2.post + resets) % post;
+}
+
+static uint64_t t2_next_event(void)
+{
+    uint32_t rate = t2_prescale[t2.t2con & 3];
+    uint8_t post = ((t2.t2con >> 3) & 0x0F) + 1;
+    uint64_t incs;
+
+    if(!t2_running() || (sim_reg[SFR_PIR1] & 0x02))
+        return SIM_NEVER;
+    incs = t2_first_reset() + (uint64_t)(post - t2.post - 1) * (t2.pr2 + 1);
+    return t2.base + (incs * rate - t2.presc) * sim.tcy;
+}
+
+/* ---- Watchdog ---- */
+
+static uint32_t wdt_period(uint8_t wdtcon, uint8_t option)
+{
+    uint8_t wdtps = (wdtcon >> 1) & 0x0F;
+    uint32_t period;
+
+    if(wdtps > 11)
+        wdtps = 11;                             // 11xx is reserved, treat as 1:65536
+    period = 32u << wdtps;
+    if(option & 0x08)                           // PSA: postscaler belongs to the WDT
+        period <<= option & 7;
+    return period;
+}
+
+static uint64_t wdt_next_event(void)
+{
+    if(!wdt.enabled)
+        return SIM_NEVER;
+    return (wdt.base / SIM_LFINTOSC_TICKS + wdt.period) * SIM_LFINTOSC_TICKS;
+}
+
+static void wdt_sync(uint64_t t)
+{
+    uint64_t timeout = wdt_next_event();
+
+    if(t < timeout)
+        return;
+    wdt.base = timeout;
+    wdt.timeouts++;
+    sim_reg[SFR_STATUS] &= ~0x10;               // nTO
+    if(sim.asleep)
+    {
+        sim_log("WDT wake-up");
+        sim_wake();
+    }
+    else
+        sim_wdt_reset();
+}
+
+void wdt_clear(void)
+{
+    wdt.base = sim.now;
+}
+
+/* ---- Core interface ---- */
+
+void timer_sync(uint64_t t)
+{
+    t0_sync(t);
+    t1_sync(t);
+    t2_sync(t);
+    wdt_sync(t);
+}
+
+uint64_t timer_next_event(void)
+{
+    uint64_t next = t0_next_event();
+    uint64_t ev;
+
+    if((ev = t1_next_event()) < next)
+        next = ev;
+    if((ev = t2_next_event()) < next)
+        next = ev;
+    if((ev = wdt_next_event()) < next)
+        next = ev;
+    return next;
+}
+
+/* ---- Register hooks ---- */
+
+static void tmr0_read(uint16_t addr)
+{
+    t0_sync(sim.now);
+    sim_reg[addr] = t0.value;
+}
+
+static void tmr0_write(uint16_t addr, uint8_t old, uint8_t val)
+{
+    (void)addr; (void)old;
+    t0_sync(sim.now);
+    t0.value = val;
+    t0.presc = 0;
+    t0.base = sim.now + 2 * sim.tcy;            // two cycle increment inhibit
+}
+
+static void option_write(uint16_t addr, uint8_t old, uint8_t val)
+{
+    (void)addr; (void)old;
+    t0_sync(sim.now);
+    t0.option = val;
+    t0.presc %= t0_rate();                      // a new PS taps the same ripple counter lower
+    wdt.period = wdt_period(sim_reg[SFR_WDTCON], val);
+    io_option_write();                          // nRBPU, INTEDG
+}
+
+static void tmr1_read(uint16_t addr)
+{
+    t1_sync(sim.now);
+    sim_reg[SFR_TMR1L] = t1.value & 0xFF;
+    sim_reg[SFR_TMR1H] = t1.value >> 8;
+    (void)addr;
+}
+
+static void tmr1_write(uint16_t addr, uint8_t old, uint8_t val)
+{
+    (void)old; (void)val;
+    t1_sync(sim.now);
+    if(addr == SFR_TMR1L)
+        t1.value = (t1.value & 0xFF00) | sim_reg[SFR_TMR1L];
+    else
+        t1.value = (t1.value & 0x00FF) | (sim_reg[SFR_TMR1H] << 8);
+    t1.presc = 0;
+}
+
+static void t1con_write(uint16_t addr, uint8_t old, uint8_t val)
+{
+    (void)addr; (void)old;
+    t1_sync(sim.now);
+    t1.t1con = val;
+    t1.presc &= (1u << ((val >> 4) & 3)) - 1;   // the same for T1CKPS
+}
+
+static void tmr2_read(uint16_t addr)
+{
+    t2_sync(sim.now);
+    sim_reg[addr] = t2.value;
+}
+
+static void tmr2_write(uint16_t addr, uint8_t old, uint8_t val)
+{
+    (void)old;
+    t2_sync(sim.now);
+    if(addr == SFR_TMR2)
+        t2.value = val;
+    else if(addr == SFR_T2CON)
+        t2.t2con = val;
+    else
+        t2.pr2 = val;
+    if(addr != SFR_PR2)
+    {
+        t2.presc = 0;
+        t2.post = 0;
+    }
+}
+
+static void wdtcon_write(uint16_t addr, uint8_t old, uint8_t val)
+{
+    (void)addr;
+    wdt.period = wdt_period(val, t0.option);
+    wdt.enabled = val & 0x01;
+    if(wdt.enabled && !(old & 0x01))
+        wdt_clear();
+}
+
+void timer_init(void)
+{
+    t0 = (typeof(t0)){ .option = sim_reg[SFR_OPTION_REG], .base = sim.now };
+    t1 = (typeof(t1)){ .t1con = sim_reg[SFR_T1CON], .base = sim.now };
+    t2 = (typeof(t2)){ .t2con = sim_reg[SFR_T2CON], .pr2 = sim_reg[SFR_PR2], .base = sim.now };
+    wdt.enabled = sim_reg[SFR_WDTCON] & 0x01;
+    wdt.period = wdt_period(sim_reg[SFR_WDTCON], sim_reg[SFR_OPTION_REG]);
+    wdt.base = sim.now;
+
+    sim_hook(SFR_TMR0, tmr0_read, tmr0_write);
+    sim_hook(SFR_OPTION_REG, NULL, option_write);
+    sim_hook(SFR_TMR1L, tmr1_read, tmr1_write);
+    sim_hook(SFR_TMR1H, tmr1_read, tmr1_write);
+    sim_hook(SFR_T1CON, NULL, t1con_write);
+    sim_hook(SFR_TMR2, tmr2_read, tmr2_write);
+    sim_hook(SFR_T2CON, NULL, tmr2_write);
+    sim_hook(SFR_PR2, NULL, tmr2_write);
+    sim_hook(SFR_WDTCON, NULL, wdtcon_write);
+}
+
+void timer_report(FILE *out)
+{
+    fprintf(out, "TMR0:         overflows %llu\n", (unsigned long long)t0.overflows);
+    fprintf(out, "TMR1:         overflows %llu\n", (unsigned long long)t1.overflows);
+    fprintf(out, "TMR2:         periods %llu\n", (unsigned long long)t2.periods);
+    fprintf(out, "WDT:          timeouts %llu\n", (unsigned long long)wdt.timeouts);
+}
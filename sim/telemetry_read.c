@@ -0,0 +1,171 @@
+/*
+ * File:   telemetry_read.c
+ *
+ * Reader for the binary frames main_uart_telemetry.c and
+ * main_uart_command.c send over the EUSART.
+ *
+ * Reads the byte stream from FILE (the simulator's -u FILE, a FIFO it is
+ * writing to, a serial port) or from standard input, finds the frames,
+ * checks their CRC and prints them one per line as they arrive. At the
+ * end it prints how many frames were good, how many failed the CRC, how
+ * many bytes had to be skipped to find the next frame and how many
+ * samples are missing from the sequence numbers.
+ *
+ * Frame: 0xA5 | type | length | payload | CRC-8 (poly 0x07 over type,
+ * length and payload).
+ *
+ * Usage: telemetry_read [-q] [FILE]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define FRAME_SYNC      0xA5
+#define FRAME_SAMPLE    0x01
+#define FRAME_STATS     0x02
+#define FRAME_REPLY     0x80            // reply to command type & 0x7F
+#define CMD_COUNTERS    0x13
+#define MAX_PAYLOAD     32
+
+static struct {
+    uint64_t frames;
+    uint64_t crc_errors;
+    uint64_t skipped;
+    uint64_t missing;                   // SAMPLE sequence numbers not seen
+    int      have_seq;
+    uint8_t  seq;
+} st;
+
+static int quiet;
+
+static const char *const status_name[] = { "ok", "bad length", "bad value", "unknown command" };
+
+static uint8_t crc8(uint8_t crc, uint8_t data)
+{
+    int i;
+
+    crc ^= data;
+    for(i = 0; i < 8; i++)
+        crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+    return crc;
+}
+
+static void frame(uint8_t type, const uint8_t *p, uint8_t len)
+{
+    int i;
+
+    st.frames++;
+    if(type == FRAME_SAMPLE && len == 4)
+    {
+        if(st.have_seq)
+            st.missing += (uint8_t)(p[0] - st.seq - 1);
+        st.seq = p[0];
+        st.have_seq = 1;
+        if(!quiet)
+            printf("SAMPLE  seq %3u  adc %4u  leds 0x%02X\n", p[0], p[1] | (p[2] << 8), p[3]);
+    }
+    else if(type == FRAME_STATS && len == 4)
+    {
+        if(!quiet)
+            printf("STATS   sent %u  dropped %u\n", p[0] | (p[1] << 8), p[2] | (p[3] << 8));
+    }
+    else if(type == (FRAME_REPLY | CMD_COUNTERS) && len == 12)
+    {
+        if(!quiet)
+            printf("COUNTERS  rx frames %u  rx errors %u  rx overruns %u  commands dropped %u\n"
+                   "          frames sent %u  frames dropped %u  max command latency %u Timer 1 cycles (SFR cycles if simulated)\n",
+                   p[0] | (p[1] << 8), p[2] | (p[3] << 8), p[4], p[5],
+                   p[6] | (p[7] << 8), p[8] | (p[9] << 8), p[10] | (p[11] << 8));
+    }
+    else if((type & FRAME_REPLY) && len == 1)
+    {
+        if(!quiet)
+            printf("REPLY   command 0x%02X  %s\n", type & 0x7F,
+                   p[0] < sizeof(status_name) / sizeof(status_name[0]) ? status_name[p[0]] : "?");
+    }
+    else if(!quiet)
+    {
+        printf("type 0x%02X  length %u ", type, len);
+        for(i = 0; i < len; i++)
+            printf(" %02X", p[i]);
+        putchar('\n');
+    }
+    if(!quiet)
+        fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+    enum { SYNC, TYPE, LENGTH, PAYLOAD, CRC } state = SYNC;
+    uint8_t type = 0, len = 0, got = 0, crc = 0;
+    uint8_t payload[MAX_PAYLOAD];
+    FILE *in = stdin;
+    int opt, c;
+
+    while((opt = getopt(argc, argv, "qh")) != -1)
+    {
+        if(opt != 'q')
+        {
+            fprintf(stderr, "usage: telemetry_read [-q] [FILE]\n"
+                            "  -q   only print the summary\n");
+            return 2;
+        }
+        quiet = 1;
+    }
+    if(optind < argc && strcmp(argv[optind], "-") && !(in = fopen(argv[optind], "rb")))
+    {
+        perror(argv[optind]);
+        return 1;
+    }
+
+    // Byte by byte, so that a FIFO or a serial port can be followed live
+    while((c = getc(in)) != EOF)
+    {
+        switch(state)
+        {
+        case SYNC:
+            if(c == FRAME_SYNC)
+                state = TYPE;
+            else
+                st.skipped++;
+            break;
+        case TYPE:
+            type = (uint8_t)c;
+            crc = crc8(0, type);
+            state = LENGTH;
+            break;
+        case LENGTH:
+            len = (uint8_t)c;
+            crc = crc8(crc, len);
+            got = 0;
+            if(len > MAX_PAYLOAD)
+            {
+                st.skipped += 3;                // not a frame after all
+                state = SYNC;
+            }
+            else
+                state = len ? PAYLOAD : CRC;
+            break;
+        case PAYLOAD:
+            payload[got++] = (uint8_t)c;
+            crc = crc8(crc, (uint8_t)c);
+            if(got == len)
+                state = CRC;
+            break;
+        case CRC:
+            if(c == crc)
+                frame(type, payload, len);
+            else
+                st.crc_errors++;
+            state = SYNC;
+            break;
+        }
+    }
+
+    printf("frames %llu  CRC errors %llu  bytes skipped %llu  samples missing %llu\n",
+           (unsigned long long)st.frames, (unsigned long long)st.crc_errors,
+           (unsigned long long)st.skipped, (unsigned long long)st.missing);
+    return 0;
+}
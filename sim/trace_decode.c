@@ -0,0 +1,152 @@
+/*
+ * File:   trace_decode.c
+ *
+ * Turns a dump of traceBuf (see ../trace.h) into a timeline.
+ *
+ * The dump is the raw bytes of traceBuf, as written by the simulator with
+ * -d traceBuf=FILE, or, with -x, the same bytes as hex text (a memory view
+ * copied out of the debugger; tokens ending in ':' are taken as addresses
+ * and skipped). Records are printed oldest first with the time since the
+ * first one, the time since the previous one and, for the end of an
+ * interrupt or a task, how long it took.
+ *
+ * Usage: trace_decode [-x] [-f Fosc] FILE
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TRACE_DECODER
+#include "../trace.h"
+
+#define RECORD_BYTES    (2 + TRACE_STAMP_BYTES)
+#define DUMP_BYTES      (2 + TRACE_SIZE * RECORD_BYTES)
+#define NONE            UINT64_MAX
+#define STAMP_MASK      ((1UL << (8 * TRACE_STAMP_BYTES)) - 1)
+
+#define TRACE_NAME(name, value)     [value] = #name,
+static const char *const event_name[256] = { TRACE_EVENTS(TRACE_NAME) };
+
+static size_t read_hex(FILE *f, uint8_t *buf, size_t size)
+{
+    char token[64];
+    size_t n = 0;
+
+    while(n < size && fscanf(f, "%63s", token) == 1)
+    {
+        char *end;
+        unsigned long v;
+
+        if(token[strlen(token) - 1] == ':')
+            continue;                   // address column
+        v = strtoul(token, &end, 16);
+        if(*end || v > 0xFF)
+        {
+            fprintf(stderr, "trace_decode: '%s' is not a hex byte\n", token);
+            exit(1);
+        }
+        buf[n++] = (uint8_t)v;
+    }
+    return n;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "usage: trace_decode [-x] [-f Fosc] FILE\n"
+        "  -x          FILE holds hex bytes instead of raw binary\n"
+        "  -f Fosc     system clock in Hz the timestamps count at Fosc/4 (default 8000000)\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    uint8_t dump[DUMP_BYTES + 1];
+    uint64_t isr_start = NONE, task_start[256];
+    uint64_t first = 0, prev = 0, stamp = 0;
+    double us_per_cycle = 4e6 / 8000000;
+    int hex = 0, opt;
+    unsigned head, count, i;
+    size_t n;
+    FILE *f;
+
+    while((opt = getopt(argc, argv, "xf:h")) != -1)
+    {
+        switch(opt)
+        {
+        case 'x':
+            hex = 1;
+            break;
+        case 'f':
+            us_per_cycle = 4e6 / strtod(optarg, NULL);
+            break;
+        default:
+            usage();
+        }
+    }
+    if(optind != argc - 1)
+        usage();
+    for(i = 0; i < 256; i++)
+        task_start[i] = NONE;
+
+    f = fopen(argv[optind], hex ? "r" : "rb");
+    if(!f)
+    {
+        perror(argv[optind]);
+        return 1;
+    }
+    n = hex ? read_hex(f, dump, sizeof(dump)) : fread(dump, 1, sizeof(dump), f);
+    fclose(f);
+    head = dump[0];
+    count = dump[1];
+    if(n != DUMP_BYTES || head >= TRACE_SIZE || count > TRACE_SIZE)
+    {
+        fprintf(stderr, "trace_decode: %s is not a traceBuf dump (%zu bytes, expected %d)\n",
+                argv[optind], n, DUMP_BYTES);
+        return 1;
+    }
+
+    printf("%3s %12s %10s  %-18s %5s\n", "#", "time [us]", "+[us]", "event", "arg");
+    for(i = 0; i < count; i++)
+    {
+        const uint8_t *rec = dump + 2 + ((head - count + i) & (TRACE_SIZE - 1)) * RECORD_BYTES;
+        uint32_t low = rec[2] | (rec[3] << 8) | ((uint32_t)rec[4] << 16);
+        const char *name = event_name[rec[0]];
+        char took[32] = "";
+
+        // Only the low bits are stored: consecutive records are assumed to
+        // be less than a full wrap apart.
+        if(i == 0)
+            first = prev = stamp = low;
+        else
+            stamp += (low - (uint32_t)stamp) & STAMP_MASK;
+
+        switch(rec[0])
+        {
+        case TRACE_ISR_ENTER:
+            isr_start = stamp;
+            break;
+        case TRACE_ISR_EXIT:
+            if(isr_start != NONE)
+                snprintf(took, sizeof(took), "  isr %.1f us", (stamp - isr_start) * us_per_cycle);
+            isr_start = NONE;
+            break;
+        case TRACE_TASK_RUN:
+            task_start[rec[1]] = stamp;
+            break;
+        case TRACE_TASK_END:
+            if(task_start[rec[1]] != NONE)
+                snprintf(took, sizeof(took), "  task %.1f us", (stamp - task_start[rec[1]]) * us_per_cycle);
+            task_start[rec[1]] = NONE;
+            break;
+        }
+
+        printf("%3u %12.1f %10.1f  %-18s %5u%s\n", i, (stamp - first) * us_per_cycle,
+               (stamp - prev) * us_per_cycle, name ? name + 6 : "?", rec[1], took);
+        prev = stamp;
+    }
+    return 0;
+}
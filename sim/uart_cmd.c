@@ -0,0 +1,173 @@
+/*
+ * File:   uart_cmd.c
+ *
+ * Builds command frames for main_uart_command.c.
+ *
+ * Each command on the command line becomes one frame on standard output
+ * (or FILE with -o), ready for the simulator's -r T:FILE or a serial port:
+ *     uart_cmd led 2 100 stream on 0 10 counters > cmds.bin
+ *     build/main_uart_command -t 2 -r 0.5:cmds.bin -u uart.bin
+ *     build/telemetry_read uart.bin
+ *
+ * Commands:
+ *   pwm PR2 PRESCALE DUTY      PWM period register, Timer 2 prescaler
+ *                              (1, 4 or 16, sent as its T2CKPS code 0, 1
+ *                              or 2) and 10-bit duty cycle
+ *   led MODE PERIOD_MS         0 off, 1 blink, 2 rotate, 3 ADC bar
+ *   stream on|off CH PERIOD_MS ADC streaming of channel CH
+ *   counters                   ask for the counters
+ *   raw TYPE [BYTE...]         any frame, for testing
+ * -c corrupts the CRC of every frame, to see it refused.
+ *
+ * Frame: 0xA5 | type | length | payload | CRC-8 (poly 0x07 over type,
+ * length and payload).
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define FRAME_SYNC      0xA5
+#define CMD_PWM         0x10
+#define CMD_LED         0x11
+#define CMD_STREAM      0x12
+#define CMD_COUNTERS    0x13
+#define MAX_PAYLOAD     8
+
+static FILE *out;
+static int corrupt;
+
+static uint8_t crc8(uint8_t crc, uint8_t data)
+{
+    int i;
+
+    crc ^= data;
+    for(i = 0; i < 8; i++)
+        crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+    return crc;
+}
+
+static void emit(uint8_t type, const uint8_t *payload, uint8_t len)
+{
+    uint8_t crc = crc8(crc8(0, type), len);
+    int i;
+
+    fputc(FRAME_SYNC, out);
+    fputc(type, out);
+    fputc(len, out);
+    for(i = 0; i < len; i++)
+    {
+        fputc(payload[i], out);
+        crc = crc8(crc, payload[i]);
+    }
+    fputc(corrupt ? crc ^ 0xFF : crc, out);
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "usage: uart_cmd [-c] [-o FILE] COMMAND...\n"
+        "  pwm PR2 PRESCALE DUTY       PRESCALE 1, 4 or 16 (sent as T2CKPS 0, 1, 2); DUTY 0..1023\n"
+        "  led MODE PERIOD_MS          MODE 0 off, 1 blink, 2 rotate, 3 ADC bar\n"
+        "  stream on|off CH PERIOD_MS  stream ADC channel CH every PERIOD_MS\n"
+        "  counters                    ask for the counters\n"
+        "  raw TYPE [BYTE...]          any frame\n"
+        "  -c                          send a wrong CRC\n"
+        "  -o FILE                     write to FILE instead of standard output\n");
+    exit(2);
+}
+
+static unsigned long number(char **argv, int i, int argc)
+{
+    char *end;
+    unsigned long v;
+
+    if(i >= argc)
+        usage();
+    v = strtoul(argv[i], &end, 0);
+    if(*end)
+        usage();
+    return v;
+}
+
+int main(int argc, char **argv)
+{
+    uint8_t p[MAX_PAYLOAD];
+    unsigned long v;
+    int opt, i;
+
+    out = stdout;
+    while((opt = getopt(argc, argv, "co:h")) != -1)
+    {
+        switch(opt)
+        {
+        case 'c':
+            corrupt = 1;
+            break;
+        case 'o':
+            if(!(out = fopen(optarg, "wb")))
+            {
+                perror(optarg);
+                return 1;
+            }
+            break;
+        default:
+            usage();
+        }
+    }
+    if(optind == argc)
+        usage();
+
+    for(i = optind; i < argc; i++)
+    {
+        if(!strcmp(argv[i], "pwm"))
+        {
+            p[0] = (uint8_t)number(argv, ++i, argc);
+            v = number(argv, ++i, argc);
+            if(v != 1 && v != 4 && v != 16)
+                usage();
+            p[1] = v == 1 ? 0 : v == 4 ? 1 : 2;             // T2CKPS
+            v = number(argv, ++i, argc);
+            p[2] = (uint8_t)v;
+            p[3] = (uint8_t)(v >> 8);
+            emit(CMD_PWM, p, 4);
+        }
+        else if(!strcmp(argv[i], "led"))
+        {
+            p[0] = (uint8_t)number(argv, ++i, argc);
+            v = number(argv, ++i, argc);
+            p[1] = (uint8_t)v;
+            p[2] = (uint8_t)(v >> 8);
+            emit(CMD_LED, p, 3);
+        }
+        else if(!strcmp(argv[i], "stream"))
+        {
+            if(++i >= argc)
+                usage();
+            p[0] = !strcmp(argv[i], "on");
+            p[1] = (uint8_t)number(argv, ++i, argc);
+            v = number(argv, ++i, argc);
+            p[2] = (uint8_t)v;
+            p[3] = (uint8_t)(v >> 8);
+            emit(CMD_STREAM, p, 4);
+        }
+        else if(!strcmp(argv[i], "counters"))
+            emit(CMD_COUNTERS, p, 0);
+        else if(!strcmp(argv[i], "raw"))
+        {
+            uint8_t type = (uint8_t)number(argv, ++i, argc);
+            uint8_t len = 0;
+            char *end;
+
+            // bytes up to the next word that is not a number
+            while(i + 1 < argc && len < MAX_PAYLOAD && (strtoul(argv[i + 1], &end, 0), !*end))
+                p[len++] = (uint8_t)strtoul(argv[++i], NULL, 0);
+            emit(type, p, len);
+        }
+        else
+            usage();
+    }
+    return fclose(out) ? 1 : 0;
+}
@@ -0,0 +1,38 @@
+/*
+ * File:   xc.h
+ *
+ * Host replacement for the XC8 <xc.h>.
+ *
+ * The sketches are compiled for the host with -I sim, so '#include <xc.h>'
+ * lands here instead of in the XC8 toolchain. It provides the register
+ * model (pic16f887.h) and the handful of XC8 built-ins the sketches use.
+ *
+ * '#pragma config' lines are left to the host compiler, which ignores them.
+ */
+
+#ifndef SIM_XC_H
+#define SIM_XC_H
+
+#include <stdint.h>
+#include "pic16f887.h"
+
+// XC8 'void interrupt isr()': the simulator calls isr() itself
+#define interrupt
+
+void sim_delay(uint32_t cycles);
+void sim_nop(void);
+void sim_sleep(void);
+void sim_clrwdt(void);
+
+// Same formulas XC8 uses; _XTAL_FREQ must be defined by the sketch
+#define _delay(x)       sim_delay((uint32_t)(x))
+#define __delay_us(x)   _delay((unsigned long)((x) * (_XTAL_FREQ / 4000000.0)))
+#define __delay_ms(x)   _delay((unsigned long)((x) * (_XTAL_FREQ / 4000.0)))
+
+#define NOP()           sim_nop()
+#define SLEEP()         sim_sleep()
+#define CLRWDT()        sim_clrwdt()
+#define ei()            (INTCONbits.GIE = 1)
+#define di()            (INTCONbits.GIE = 0)
+
+#endif /* SIM_XC_H */
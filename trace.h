@@ -0,0 +1,148 @@
+/*
+ * File:   trace.h
+ *
+ * Trace points: a flight recorder for the firmware
+ * TRACE(event, arg) stores the event number, one byte of detail and the
+ * Timer 1 timestamp (low 24 bits of timestamp_now(), see
+ * main_timer1_timestamp.c) in a small ring buffer in RAM. Once the ring is
+ * full the oldest records are overwritten, so it always holds the last
+ * TRACE_SIZE events. Read traceBuf out with the debugger (or the
+ * simulator: -d traceBuf=FILE) and turn it into a timeline with
+ * sim/build/trace_decode.
+ *
+ * Switches, set before including this file:
+ *   TRACE_IMPL     defined in exactly one file of the program: traceBuf is
+ *                  stored there, the other files share it
+ *   TRACE_ENABLE   0 removes every trace point, they compile to nothing
+ *   TRACE_ISR, TRACE_ADC, TRACE_TASK, TRACE_BUTTON
+ *                  0 removes that group only
+ *   TRACE_ONESHOT  1 stops recording when the ring is full instead of
+ *                  overwriting (captures start-up instead of the last events)
+ *
+ * The sketch provides uint32_t timestamp_now(void).
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+// Event numbers. The decoder takes its names from this list too.
+#define TRACE_EVENTS(X) \
+    X(TRACE_ISR_ENTER,   1)     /* arg: interrupt source */ \
+    X(TRACE_ISR_EXIT,    2) \
+    X(TRACE_ADC_START,   3)     /* arg: channel */ \
+    X(TRACE_ADC_DONE,    4)     /* arg: ADRESH */ \
+    X(TRACE_TASK_RUN,    5)     /* arg: task number */ \
+    X(TRACE_TASK_END,    6)     /* arg: task number */ \
+    X(TRACE_BUTTON_EDGE, 7)     /* arg: 1 pressed, 0 released */ \
+    X(TRACE_USER,        8)     /* arg: anything */
+
+#define TRACE_SIZE          16      // records, power of two; 16 x 5 + 2 bytes fit one RAM bank
+#define TRACE_STAMP_BYTES   3       // 24-bit timestamps: 8.4 s apart at most at 8 MHz
+
+#define TRACE_ENUM(name, value)     name = value,
+enum { TRACE_EVENTS(TRACE_ENUM) };
+
+#ifndef TRACE_DECODER
+
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE        1
+#endif
+#ifndef TRACE_ISR
+#define TRACE_ISR           1
+#endif
+#ifndef TRACE_ADC
+#define TRACE_ADC           1
+#endif
+#ifndef TRACE_TASK
+#define TRACE_TASK          1
+#endif
+#ifndef TRACE_BUTTON
+#define TRACE_BUTTON        1
+#endif
+#ifndef TRACE_ONESHOT
+#define TRACE_ONESHOT       0
+#endif
+
+#if TRACE_ENABLE
+
+typedef struct
+{
+    uint8_t id;
+    uint8_t arg;
+    uint8_t stamp[TRACE_STAMP_BYTES];       // little endian
+} trace_rec_t;
+
+typedef struct
+{
+    uint8_t head;                           // next record to write
+    uint8_t count;                          // records written, stops at TRACE_SIZE
+    trace_rec_t rec[TRACE_SIZE];
+} trace_t;
+
+extern trace_t traceBuf;
+#ifdef TRACE_IMPL
+trace_t traceBuf;
+#endif
+
+uint32_t timestamp_now(void);
+
+// Callable from main() and isr(). Interrupts are held off for the few cycles
+// it takes, so a trace point in isr() cannot land in the middle of one in main().
+static inline void trace_record(uint8_t id, uint8_t arg)
+{
+    uint8_t gie = INTCONbits.GIE;
+    uint32_t stamp;
+    trace_rec_t *rec;
+
+    INTCONbits.GIE = 0;
+#if TRACE_ONESHOT
+    if(traceBuf.count == TRACE_SIZE)
+    {
+        INTCONbits.GIE = gie;
+        return;
+    }
+#endif
+    stamp = timestamp_now();
+    rec = &traceBuf.rec[traceBuf.head];
+    rec->id = id;
+    rec->arg = arg;
+    rec->stamp[0] = (uint8_t)stamp;
+    rec->stamp[1] = (uint8_t)(stamp >> 8);
+    rec->stamp[2] = (uint8_t)(stamp >> 16);
+    traceBuf.head = (traceBuf.head + 1) & (TRACE_SIZE - 1);
+    if(traceBuf.count < TRACE_SIZE)
+        traceBuf.count++;
+    INTCONbits.GIE = gie;
+}
+
+#define TRACE(id, arg)      trace_record(id, arg)
+#else
+#define TRACE(id, arg)      ((void)0)
+#endif
+
+#if TRACE_ENABLE && TRACE_ISR
+#define TRACE_ISR_POINT(id, arg)        TRACE(id, arg)
+#else
+#define TRACE_ISR_POINT(id, arg)        ((void)0)
+#endif
+#if TRACE_ENABLE && TRACE_ADC
+#define TRACE_ADC_POINT(id, arg)        TRACE(id, arg)
+#else
+#define TRACE_ADC_POINT(id, arg)        ((void)0)
+#endif
+#if TRACE_ENABLE && TRACE_TASK
+#define TRACE_TASK_POINT(id, arg)       TRACE(id, arg)
+#else
+#define TRACE_TASK_POINT(id, arg)       ((void)0)
+#endif
+#if TRACE_ENABLE && TRACE_BUTTON
+#define TRACE_BUTTON_POINT(id, arg)     TRACE(id, arg)
+#else
+#define TRACE_BUTTON_POINT(id, arg)     ((void)0)
+#endif
+
+#endif /* TRACE_DECODER */
+
+#endif /* TRACE_H */
@@ -0,0 +1,121 @@
+/*
+ * File:   uart_tx.h
+ *
+ * Interrupt-driven EUSART transmit ring buffer for framed messages
+ * uart_send_frame() copies a whole frame into a ring buffer in RAM and
+ * returns at once; the transmit interrupt (TXIF) feeds TXREG one byte at
+ * a time. A frame that does not fit into the buffer is dropped whole and
+ * counted, so the receiver never sees half of one.
+ *
+ * Frame: 0xA5 | type | length | payload (length bytes) | CRC-8
+ *   CRC-8: polynomial 0x07, initial value 0, over type, length and payload
+ *
+ * Switches, set before including this file:
+ *   UART_TX_IMPL   defined in exactly one file of the program: the ring
+ *                  buffer, the CRC table and the counters are stored there
+ *   TX_BUFFER_SIZE bytes, a power of two (default 64)
+ *
+ * The sketch sets up the EUSART itself (see main_uart_telemetry.c), sets
+ * PEIE and GIE, and calls uart_tx_isr() from isr() when TXIE and TXIF
+ * are set.
+ */
+
+#ifndef UART_TX_H
+#define UART_TX_H
+
+#include <stdint.h>
+
+#define FRAME_SYNC                0xA5
+#define FRAME_OVERHEAD            4         // sync, type, length, CRC
+
+#ifndef TX_BUFFER_SIZE
+#define TX_BUFFER_SIZE            64
+#endif
+#if TX_BUFFER_SIZE & (TX_BUFFER_SIZE - 1)
+#error "TX_BUFFER_SIZE must be a power of two"
+#endif
+
+// main() writes txHead, isr() writes txTail
+extern volatile uint8_t txBuffer[TX_BUFFER_SIZE];
+extern volatile uint8_t txHead;             // next slot main() writes
+extern volatile uint8_t txTail;             // next byte isr() sends
+extern uint16_t framesSent;
+extern uint16_t framesDropped;
+extern const uint8_t crcNibble[16];
+#ifdef UART_TX_IMPL
+volatile uint8_t txBuffer[TX_BUFFER_SIZE];
+volatile uint8_t txHead = 0;
+volatile uint8_t txTail = 0;
+uint16_t framesSent = 0;
+uint16_t framesDropped = 0;
+
+// CRC-8 (poly 0x07) of the high nibble, for crc8()
+const uint8_t crcNibble[16] = {
+    0x00, 0x07, 0x0E, 0x09, 0x1C, 0x1B, 0x12, 0x15,
+    0x38, 0x3F, 0x36, 0x31, 0x24, 0x23, 0x2A, 0x2D
+};
+#endif
+
+// CRC-8 four bits at a time: short enough for isr(), which has to keep
+// up with a byte every 174us at 57600 baud
+static inline uint8_t crc8(uint8_t crc, uint8_t data)
+{
+    crc ^= data;
+    crc = (uint8_t)(crc << 4) ^ crcNibble[crc >> 4];
+    crc = (uint8_t)(crc << 4) ^ crcNibble[crc >> 4];
+    return crc;
+}
+
+// Queue one frame for isr() to send. Returns 0 (and counts it) if the
+// buffer cannot take the whole frame right now.
+static inline uint8_t uart_send_frame(uint8_t type, const uint8_t *payload, uint8_t length)
+{
+    uint8_t space = (txTail - txHead - 1) & (TX_BUFFER_SIZE - 1);
+    uint8_t head = txHead;
+    uint8_t crc = 0;
+    uint8_t i;
+
+    if(space < length + FRAME_OVERHEAD)
+    {
+        framesDropped++;
+        return 0;
+    }
+
+    txBuffer[head] = FRAME_SYNC;
+    head = (head + 1) & (TX_BUFFER_SIZE - 1);
+    txBuffer[head] = type;
+    head = (head + 1) & (TX_BUFFER_SIZE - 1);
+    crc = crc8(crc, type);
+    txBuffer[head] = length;
+    head = (head + 1) & (TX_BUFFER_SIZE - 1);
+    crc = crc8(crc, length);
+    for(i = 0; i < length; i++)
+    {
+        txBuffer[head] = payload[i];
+        head = (head + 1) & (TX_BUFFER_SIZE - 1);
+        crc = crc8(crc, payload[i]);
+    }
+    txBuffer[head] = crc;
+    txHead = (head + 1) & (TX_BUFFER_SIZE - 1);     // publish the whole frame at once
+
+    PIE1bits.TXIE = 1;                              // isr() sends it
+    framesSent++;
+    return 1;
+}
+
+// From isr() on TXIF with TXIE set. TXREG is double buffered: TXIF is set
+// while it can take another byte, which is most of the time, so TXIE is
+// only on while there is something to send.
+static inline void uart_tx_isr()
+{
+    // TXIF cannot be cleared, writing TXREG is what does it
+    if(txTail != txHead)
+    {
+        TXREG = txBuffer[txTail];
+        txTail = (txTail + 1) & (TX_BUFFER_SIZE - 1);
+    }
+    if(txTail == txHead)
+        PIE1bits.TXIE = 0;                          // buffer empty, uart_send_frame() turns it back on
+}
+
+#endif /* UART_TX_H */
@@ -0,0 +1,103 @@
+/*
+ * File:   wdt_wake.h
+ *
+ * The Watchdog Timer as a periodic wake-up alarm
+ * Set WDT_WAKE_MS before including this file; the preprocessor turns it
+ * into the WDT prescaler (WDTCON WDTPS, 1:32 .. 1:65536) and the
+ * postscaler shared with Timer 0 (OPTION_REG PS with PSA = 1, 1:1 ..
+ * 1:128). Together they divide the 31 kHz LFINTOSC by 32 x 2^n, so
+ * periods from 1 ms to about 4.5 minutes are possible, in powers of two:
+ * WDT_WAKE_MS is rounded to the nearest one and WDT_WAKE_ACTUAL_MS tells
+ * which. LFINTOSC is not trimmed (the datasheet allows +-15% and more
+ * over temperature), so count wake-ups of a shorter period rather than
+ * trust one long one where the time matters.
+ *
+ * wdt_wake_sleep() enables the WDT only for the time of the SLEEP, so the
+ * work done in between can take as long as it likes without a WDT reset.
+ * Timer 0 loses its prescaler to the WDT.
+ */
+
+#ifndef WDT_WAKE_H
+#define WDT_WAKE_H
+
+#ifndef WDT_WAKE_MS
+#error "define WDT_WAKE_MS before including wdt_wake.h"
+#endif
+#define WDT_LFINTOSC_KHZ    31UL
+
+// LFINTOSC periods in WDT_WAKE_MS, rounded to 32 x 2^n (thresholds at 32 x 2^(n + 1/2))
+#define WDT_WAKE_DIV        (WDT_WAKE_MS * WDT_LFINTOSC_KHZ)
+
+#if WDT_WAKE_MS < 1
+#error "WDT_WAKE_MS is below the 1 ms WDT step"
+#elif WDT_WAKE_DIV < 45UL
+#define WDT_WAKE_EXP        0
+#elif WDT_WAKE_DIV < 91UL
+#define WDT_WAKE_EXP        1
+#elif WDT_WAKE_DIV < 181UL
+#define WDT_WAKE_EXP        2
+#elif WDT_WAKE_DIV < 362UL
+#define WDT_WAKE_EXP        3
+#elif WDT_WAKE_DIV < 724UL
+#define WDT_WAKE_EXP        4
+#elif WDT_WAKE_DIV < 1448UL
+#define WDT_WAKE_EXP        5
+#elif WDT_WAKE_DIV < 2896UL
+#define WDT_WAKE_EXP        6
+#elif WDT_WAKE_DIV < 5793UL
+#define WDT_WAKE_EXP        7
+#elif WDT_WAKE_DIV < 11585UL
+#define WDT_WAKE_EXP        8
+#elif WDT_WAKE_DIV < 23170UL
+#define WDT_WAKE_EXP        9
+#elif WDT_WAKE_DIV < 46341UL
+#define WDT_WAKE_EXP        10
+#elif WDT_WAKE_DIV < 92682UL
+#define WDT_WAKE_EXP        11
+#elif WDT_WAKE_DIV < 185364UL
+#define WDT_WAKE_EXP        12
+#elif WDT_WAKE_DIV < 370728UL
+#define WDT_WAKE_EXP        13
+#elif WDT_WAKE_DIV < 741455UL
+#define WDT_WAKE_EXP        14
+#elif WDT_WAKE_DIV < 1482910UL
+#define WDT_WAKE_EXP        15
+#elif WDT_WAKE_DIV < 2965821UL
+#define WDT_WAKE_EXP        16
+#elif WDT_WAKE_DIV < 5931642UL
+#define WDT_WAKE_EXP        17
+#elif WDT_WAKE_DIV < 11863283UL
+#define WDT_WAKE_EXP        18
+#else
+#error "WDT_WAKE_MS is above what the WDT can reach (about 270 s)"
+#endif
+
+// WDTPS takes the first 11 doublings, the Timer 0 postscaler the rest
+#if WDT_WAKE_EXP > 11
+#define WDT_WAKE_WDTPS      11
+#define WDT_WAKE_PS         (WDT_WAKE_EXP - 11)
+#else
+#define WDT_WAKE_WDTPS      WDT_WAKE_EXP
+#define WDT_WAKE_PS         0
+#endif
+
+#define WDT_WAKE_ACTUAL_MS  ((32UL << WDT_WAKE_EXP) / WDT_LFINTOSC_KHZ)
+
+static inline void wdt_wake_init()
+{
+    WDTCONbits.SWDTEN = 0;                  // off until wdt_wake_sleep()
+    OPTION_REGbits.PSA = 1;                 // Prescaler assigned to the WDT
+    OPTION_REGbits.PS = WDT_WAKE_PS;
+    WDTCONbits.WDTPS = WDT_WAKE_WDTPS;
+}
+
+// Sleep for WDT_WAKE_ACTUAL_MS (or until an enabled interrupt flag is set)
+static inline void wdt_wake_sleep()
+{
+    WDTCONbits.SWDTEN = 1;                  // SLEEP clears the WDT: a full period
+    SLEEP();
+    NOP();
+    WDTCONbits.SWDTEN = 0;
+}
+
+#endif /* WDT_WAKE_H */